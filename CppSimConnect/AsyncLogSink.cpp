@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <chrono>
+
+#include "AsyncLogSink.h"
+
+
+using CppSimConnect::AsyncLogSink;
+using CppSimConnect::LogStats;
+
+
+AsyncLogSink::AsyncLogSink(LogSink sink, size_t capacity, LogOverflow overflow, std::unique_ptr<BinaryLogWriter> writer) :
+    _sink{ std::move(sink) }, _writer{ std::move(writer) }, _overflow{ overflow }, _records(capacity)
+{
+    _thread = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    _thread.request_stop();
+    wake();
+    _thread.join();
+}
+
+
+void AsyncLogSink::wake() noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleeping.load() && _sleeping.exchange(false)) {
+        _sleeping.notify_one();
+    }
+}
+
+bool AsyncLogSink::dropOldest()
+{
+    LogRecord stale;
+    if (_records.tryPop(stale)) {
+        _evicted++;
+        return true;
+    }
+    return false;
+}
+
+void AsyncLogSink::log(LogLevel level, std::string_view msg)
+{
+    LogRecord record;
+    record.setText(level, msg);
+    log(record);
+}
+
+void AsyncLogSink::log(const LogRecord& record)
+{
+    while (!_records.tryPush(record)) {
+        switch (_overflow) {
+        case LogOverflow::DropNewest:
+            _dropped++;
+            wake();
+            return;
+
+        case LogOverflow::DropOldest:
+            dropOldest();
+            break;
+
+        case LogOverflow::Block:
+            wake();
+            std::this_thread::yield();
+            break;
+        }
+    }
+    _accepted++;
+    wake();
+}
+
+void AsyncLogSink::run(std::stop_token stop)
+{
+    LogRecord record;
+    std::string line;
+    line.reserve(maxMessageLength);
+
+    for (;;) {
+        while (_records.tryPop(record)) {
+            try {
+                if (_writer) {
+                    _writer->write(record);
+                }
+                if (_sink) {
+                    record.formatTo(line);
+                    _sink(record.level, line);
+                }
+            }
+            catch (...) {
+                // A failing sink loses the message, but must not stop logging.
+            }
+            _written++;
+        }
+        if (stop.stop_requested()) {
+            if (_records.empty()) {
+                break;
+            }
+            continue;
+        }
+        if (_writer) {
+            _writer->flush();
+        }
+        // Announce we're going to sleep, then look once more so a message logged in between isn't missed.
+        _sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_records.empty() || stop.stop_requested()) {
+            _sleeping.store(false);
+            continue;
+        }
+        _sleeping.wait(true);
+    }
+}
+
+void AsyncLogSink::flush()
+{
+    const std::uint64_t target{ _accepted.load() };
+    while ((_written.load() + _evicted.load()) < target) {
+        wake();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+LogStats AsyncLogSink::stats() const noexcept
+{
+    return {
+        _written.load(std::memory_order_relaxed),
+        _dropped.load(std::memory_order_relaxed) + _evicted.load(std::memory_order_relaxed),
+        _records.size()
+    };
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "BinaryLog.h"
+#include "Logger.h"
+#include "Statistics.h"
+#include "reactive/BoundedQueue.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>What to do with a log message when the buffer is full.</summary>
+	 */
+	enum class LogOverflow {
+		DropNewest,		// Lose the new message. Logging never waits.
+		DropOldest,		// Lose the oldest waiting message. Logging never waits.
+		Block			// Wait for the sink thread to make room.
+	};
+
+	/**
+	 * <summary>Passes log messages to a sink on a thread of its own.</summary>
+	 *
+	 * Messages are copied into fixed-size records in a lock-free ring, so the memory used is fixed at
+	 * construction and logging threads never wait for the sink unless the overflow policy says so.
+	 * Messages longer than a record are truncated. Records that were captured unformatted are formatted
+	 * on the sink thread. With a binary log writer, records are also written to a binary log file, where
+	 * they stay unformatted. Destroying the sink delivers what is still queued.
+	 */
+	class AsyncLogSink {
+	public:
+		static constexpr size_t maxMessageLength{ LogRecord::dataSize };
+
+	private:
+		LogSink _sink;
+		std::unique_ptr<BinaryLogWriter> _writer;
+		LogOverflow _overflow;
+		Reactive::BoundedQueue<LogRecord> _records;
+
+		std::atomic_bool _sleeping{ false };
+		std::atomic<std::uint64_t> _accepted{ 0 };
+		std::atomic<std::uint64_t> _written{ 0 };
+		std::atomic<std::uint64_t> _dropped{ 0 };
+		std::atomic<std::uint64_t> _evicted{ 0 };		// Accepted, but then dropped to make room
+
+		std::jthread _thread;
+
+		void run(std::stop_token stop);
+		void wake() noexcept;
+		bool dropOldest();
+
+	public:
+		AsyncLogSink(LogSink sink, size_t capacity = 4096, LogOverflow overflow = LogOverflow::DropNewest, std::unique_ptr<BinaryLogWriter> writer = nullptr);
+		~AsyncLogSink();
+		AsyncLogSink(AsyncLogSink const&) = delete;
+		AsyncLogSink(AsyncLogSink&&) = delete;
+		AsyncLogSink& operator=(AsyncLogSink const&) = delete;
+		AsyncLogSink& operator=(AsyncLogSink&&) = delete;
+
+		void log(LogLevel level, std::string_view msg);
+		void log(const LogRecord& record);
+
+		/**
+		 * <summary>Wait until every message logged before the call has been passed to the sink or dropped.</summary>
+		 */
+		void flush();
+
+		inline size_t capacity() const noexcept { return _records.capacity(); }
+		LogStats stats() const noexcept;
+	};
+}
\ No newline at end of file
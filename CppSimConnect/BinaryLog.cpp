@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <chrono>
+#include <format>
+#include <stdexcept>
+
+#include "BinaryLog.h"
+
+
+using CppSimConnect::BinaryLogReader;
+using CppSimConnect::BinaryLogWriter;
+using CppSimConnect::LogLevel;
+using CppSimConnect::LogRecord;
+
+static constexpr std::string_view levelNames[]{ "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
+
+
+BinaryLogWriter::BinaryLogWriter(const std::filesystem::path& file) :
+    _out(file, std::ios::binary | std::ios::trunc)
+{
+    if (!_out) {
+        throw std::runtime_error("Cannot create binary log file '" + file.string() + "'");
+    }
+    _out.write(magic, sizeof(magic));
+    put(version);
+    put(byteOrderMark);
+}
+
+void BinaryLogWriter::write(const LogRecord& record)
+{
+    std::uint32_t formatId{ 0 };
+    if (!record.preformatted()) {
+        auto it = _formats.find(record.format);
+        if (it == _formats.end()) {
+            const std::string_view format{ record.format };
+            formatId = static_cast<std::uint32_t>(_formats.size() + 1);
+            _formats.emplace(record.format, formatId);
+
+            put(formatEntry);
+            put(formatId);
+            put(static_cast<std::uint16_t>(format.size()));
+            _out.write(format.data(), format.size());
+        }
+        else {
+            formatId = it->second;
+        }
+    }
+    put(recordEntry);
+    put(formatId);
+    put(record.timestamp);
+    put(static_cast<std::uint8_t>(record.level));
+    put(record.argCount);
+    put(record.length);
+    _out.write(reinterpret_cast<const char*>(record.types), record.argCount);
+    _out.write(reinterpret_cast<const char*>(record.data), record.length);
+}
+
+void BinaryLogWriter::flush()
+{
+    _out.flush();
+}
+
+
+BinaryLogReader::BinaryLogReader(const std::filesystem::path& file) :
+    _in(file, std::ios::binary)
+{
+    if (!_in) {
+        throw std::runtime_error("Cannot open binary log file '" + file.string() + "'");
+    }
+    char magic[sizeof(BinaryLogWriter::magic)];
+    std::uint16_t version{ 0 };
+    std::uint16_t byteOrderMark{ 0 };
+    if (!_in.read(magic, sizeof(magic)) || !get(version) || !get(byteOrderMark) ||
+        (std::string_view(magic, sizeof(magic)) != std::string_view(BinaryLogWriter::magic, sizeof(magic)))) {
+        throw std::runtime_error("'" + file.string() + "' is not a binary log file");
+    }
+    if (byteOrderMark != BinaryLogWriter::byteOrderMark) {
+        throw std::runtime_error("'" + file.string() + "' was written with a different byte order");
+    }
+    if (version != BinaryLogWriter::version) {
+        throw std::runtime_error("'" + file.string() + "' has unsupported binary log version " + std::to_string(version));
+    }
+}
+
+bool BinaryLogReader::next(LogRecord& record)
+{
+    std::uint8_t kind{ 0 };
+    while (get(kind)) {
+        std::uint32_t formatId{ 0 };
+        if (!get(formatId)) {
+            return false;
+        }
+        if (kind == BinaryLogWriter::formatEntry) {
+            std::uint16_t length{ 0 };
+            if (!get(length)) {
+                return false;
+            }
+            std::string format(length, '\0');
+            if (!_in.read(format.data(), length)) {
+                return false;
+            }
+            if (formatId != (_formats.size() + 1)) {
+                throw std::runtime_error("Binary log format ids out of sequence");
+            }
+            _formats.push_back(std::move(format));
+        }
+        else if (kind == BinaryLogWriter::recordEntry) {
+            std::uint8_t level{ 0 };
+            if (!get(record.timestamp) || !get(level) || !get(record.argCount) || !get(record.length)) {
+                return false;
+            }
+            if ((formatId > _formats.size()) || (level > static_cast<std::uint8_t>(LogLevel::Fatal)) ||
+                (record.argCount > LogRecord::maxArgs) || (record.length > LogRecord::dataSize)) {
+                throw std::runtime_error("Damaged binary log record");
+            }
+            if (!_in.read(reinterpret_cast<char*>(record.types), record.argCount) ||
+                !_in.read(reinterpret_cast<char*>(record.data), record.length)) {
+                return false;
+            }
+            record.level = static_cast<LogLevel>(level);
+            record.format = (formatId == 0) ? nullptr : _formats[formatId - 1].c_str();
+            return true;
+        }
+        else {
+            throw std::runtime_error("Damaged binary log entry");
+        }
+    }
+    return false;
+}
+
+
+bool CppSimConnect::parseLogLevel(std::string_view name, LogLevel& level)
+{
+    for (size_t i = 0; i < std::size(levelNames); i++) {
+        if (levelNames[i] == name) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t CppSimConnect::decodeBinaryLog(BinaryLogReader& reader, std::ostream& out, LogLevel threshold)
+{
+    size_t lines{ 0 };
+    LogRecord record;
+    std::string text;
+    while (reader.next(record)) {
+        if (record.level < threshold) {
+            continue;
+        }
+        record.formatTo(text);
+        const std::chrono::sys_time<std::chrono::nanoseconds> when{ std::chrono::nanoseconds(record.timestamp) };
+        out << std::format("{:%F %T} {:5} {}\n", when, levelNames[static_cast<size_t>(record.level)], text);
+        lines++;
+    }
+    return lines;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "LogRecord.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>Writes log records to a file without formatting them.</summary>
+	 *
+	 * The file starts with a 10-byte header ("CSCLOG", a 16-bit version, and a 16-bit byte order mark), followed by entries that each start
+	 * with a kind byte. A format entry (kind 1) gives a 32-bit id, a 16-bit length, and the format string, and
+	 * is written the first time a format string is used. A record entry (kind 2) holds the 32-bit format id
+	 * (0 for preformatted text), the 64-bit timestamp, the level, the argument count, the 16-bit data length,
+	 * one type byte per argument, and the argument data as captured. All numbers are in the writer's native byte
+	 * order, as the argument data is copied as is; the byte order mark lets a reader reject a file it can't decode.
+	 * Not thread-safe; the AsyncLogSink calls it from its sink thread only.
+	 */
+	class BinaryLogWriter {
+		std::ofstream _out;
+		std::unordered_map<const char*, std::uint32_t> _formats;	// By address, see LogRecord::capture()
+
+		template <typename T>
+		inline void put(T value) { _out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+	public:
+		static constexpr char magic[6]{ 'C', 'S', 'C', 'L', 'O', 'G' };
+		static constexpr std::uint16_t version{ 2 };
+		static constexpr std::uint16_t byteOrderMark{ 0x0102 };
+		static constexpr std::uint8_t formatEntry{ 1 };
+		static constexpr std::uint8_t recordEntry{ 2 };
+
+		BinaryLogWriter(const std::filesystem::path& file);
+		~BinaryLogWriter() = default;
+		BinaryLogWriter(BinaryLogWriter const&) = delete;
+		BinaryLogWriter(BinaryLogWriter&&) = delete;
+		BinaryLogWriter& operator=(BinaryLogWriter const&) = delete;
+		BinaryLogWriter& operator=(BinaryLogWriter&&) = delete;
+
+		void write(const LogRecord& record);
+		void flush();
+	};
+
+	/**
+	 * <summary>Reads the log records from a file written by a BinaryLogWriter.</summary>
+	 *
+	 * The records returned point to format strings owned by the reader, so they can be formatted for as long as
+	 * the reader exists. A file that isn't a binary log, or that is damaged, causes a std::runtime_error; a file
+	 * that ends in the middle of a record (as it will if the writer is still busy) just ends early.
+	 */
+	class BinaryLogReader {
+		std::ifstream _in;
+		std::deque<std::string> _formats;		// Deque, because records point into the strings
+
+		template <typename T>
+		inline bool get(T& value) { return static_cast<bool>(_in.read(reinterpret_cast<char*>(&value), sizeof(T))); }
+
+	public:
+		BinaryLogReader(const std::filesystem::path& file);
+		~BinaryLogReader() = default;
+		BinaryLogReader(BinaryLogReader const&) = delete;
+		BinaryLogReader(BinaryLogReader&&) = delete;
+		BinaryLogReader& operator=(BinaryLogReader const&) = delete;
+		BinaryLogReader& operator=(BinaryLogReader&&) = delete;
+
+		/**
+		 * <summary>Read the next record, returning false at the end of the file.</summary>
+		 */
+		bool next(LogRecord& record);
+	};
+
+	/**
+	 * <summary>Find the level for a name as decodeBinaryLog() writes it, "TRACE" to "FATAL". Returns false if there is none.</summary>
+	 */
+	bool parseLogLevel(std::string_view name, LogLevel& level);
+
+	/**
+	 * <summary>Write the records of a binary log as lines of text, each with its time and level, skipping those below
+	 * the threshold. Returns the number of lines written.</summary>
+	 */
+	size_t decodeBinaryLog(BinaryLogReader& reader, std::ostream& out, LogLevel threshold = LogLevel::Trace);
+}
\ No newline at end of file
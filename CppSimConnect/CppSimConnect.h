@@ -17,19 +17,29 @@
 #pragma once
 
 #include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <thread>
 #include <vector>
 #include <map>
 
 #include "Logger.h"
+#include "AsyncLogSink.h"
 
 #include "AppInfo.h"
+#include "EventManager.h"
+#include "MessageViews.h"
+#include "Statistics.h"
 
+#include "events/ClientEvent.h"
 #include "reactive/MessageObserver.h"
 #include "reactive/MessageResult.h"
+#include "reactive/StreamResult.h"
+#include "requests/DataDefinition.h"
 #include "requests/SystemState.h"
 
 namespace CppSimConnect {
@@ -41,6 +51,8 @@ namespace CppSimConnect {
 	};
 
 	class SimState;
+	class SimBackend;
+	class MessageRecorder;
 
 	class SimConnect {
 	public:
@@ -61,7 +73,9 @@ namespace CppSimConnect {
 		std::weak_ptr<SimConnect> weakThis() const noexcept { return _clients.at(_clientName); }
 
 	private:
+		std::shared_ptr<SimBackend> _backend;
 		std::unique_ptr<SimState> _state;
+		std::unique_ptr<MessageRecorder> _recorder;
 
 		bool _stopOnDisconnect;
 		std::mutex _simConnector;
@@ -77,20 +91,40 @@ namespace CppSimConnect {
 		// Client connections
 		static std::map<std::string, std::shared_ptr<SimConnect>> _clients;
 		std::string _clientName;
-		messages::AppInfo _appInfo;
 		FlightSimType _connectedSim{ FlightSimType::Unknown };
 
 		// Connecting to the simulator
 		std::atomic_bool _autoConnect;
 		std::chrono::milliseconds _autoConnectRetryPeriod;
 		std::chrono::milliseconds _messagePollerRetryPeriod;
+		bool _eventDriven;
+
+		// Handling requests
+		size_t _exceptionDepth;
+		std::chrono::milliseconds _earlyErrorMaxAge;
+		bool _cacheSystemStates;
+		bool _timingStats;
 
 		void autoConnectHandler();
+		void waitForMessages();
 		std::jthread _autoConnector;
 
 		LogLevel _loggingThreshold{ LogLevel::Info };
+		std::unique_ptr<AsyncLogSink> _asyncSink;
 		LogSink _sink;
+		LogRecordSink _recordSink;
 		Logger _logger;
+		static std::unique_ptr<AsyncLogSink> createAsyncSink(Builder const& builder);
+
+		// Client events get their IDs from here, so each client has its own.
+		EventManager _events;
+
+		// Client event sets, registered again on every connection. The lock also covers setting and clearing _state,
+		// so each set is registered exactly once with each connection.
+		std::mutex _clientEventLock;
+		std::vector<std::unique_ptr<RegisteredEventSet>> _clientEventSets;
+		std::vector<bool> _mappedEvents;		// By EventID, over all sets
+		void simActivateState(std::unique_ptr<SimState> state);
 
 		std::vector<std::function<void(std::string const& msg)>> stateLoggers;
 		void notifyStateChanged(std::string const& msg) const { for (auto const& cb : stateLoggers) { cb(msg); } }
@@ -98,19 +132,30 @@ namespace CppSimConnect {
 		std::vector<std::function<void()>> onConnectHandlers;
 		void notifyConnected() const { for (auto const& cb : onConnectHandlers) { cb(); } }
 
+		std::vector<std::function<void(messages::AppInfoView const& appInfo)>> onOpenViewHandlers;
 		std::vector<std::function<void(messages::AppInfo const& appInfo)>> onOpenHandlers;
-		void notifyOpen() const { for (auto const& cb : onOpenHandlers) { cb(_appInfo); } }
+		void notifyOpen(messages::AppInfoView const& appInfo) const {
+			for (auto const& cb : onOpenViewHandlers) { cb(appInfo); }
+			if (!onOpenHandlers.empty()) {
+				const auto info{ appInfo.materialize() };
+				for (auto const& cb : onOpenHandlers) { cb(info); }
+			}
+		}
 		std::vector<std::function<void()>> onCloseHandlers;
 		void notifyClose() const { for (auto const& cb : onCloseHandlers) { cb(); } }
 		std::vector<std::function<void()>> onDisconnectHandlers;
 		void notifyDisconnected() const { for (auto const& cb : onDisconnectHandlers) { cb(); } }
 
 		// Requests
-		std::atomic<unsigned> _nextReqId;
-		inline unsigned nextReqId() { return _nextReqId++; }
-
 		Reactive::MessageResult<std::string> simRequestSystemStateString(const std::string& stateName);
+		void simRequestSystemStateString(const std::string& stateName, Reactive::MessageResult<std::string> result);
 		Reactive::MessageResult<bool> simRequestSystemStateBool(const std::string& stateName);
+		void simRequestSystemStateBool(const std::string& stateName, Reactive::MessageResult<bool> result);
+		void simRequestData(const DataLayout& layout, std::uint32_t objectId,
+							std::function<void(const std::byte* data)> onData, std::function<void(std::exception_ptr err)> onError);
+		std::function<void()> simSubscribeData(const DataLayout& layout, std::uint32_t objectId, DataPeriod period, bool changedOnly, bool tagged,
+											   std::function<void(std::span<const std::byte> data, std::uint32_t count)> onData,
+											   std::function<void(std::exception_ptr err)> onError);
 
 		// Actual SimConnect calls hidden here
 
@@ -124,12 +169,7 @@ namespace CppSimConnect {
 
 		bool running() const { return _running; }
 		void start() noexcept;
-		void stop() noexcept {
-			_logger.debug("SimConnect::stop()");
-
-			_running = false;
-			_running_cv.notify_all();
-		}
+		void stop() noexcept;
 
 		inline bool connected() const noexcept { return _connected; }
 
@@ -144,12 +184,14 @@ namespace CppSimConnect {
 		}
 
 		inline std::chrono::milliseconds autoConnectRetryPeriods() const noexcept { return _autoConnectRetryPeriod; }
-		template <typename Repr>
-		void autoConnectRetryPeriods(std::chrono::duration<Repr> period) { _autoConnectRetryPeriod = period; }
+		template <typename Repr, typename Period>
+		void autoConnectRetryPeriods(std::chrono::duration<Repr, Period> period) { _autoConnectRetryPeriod = std::chrono::duration_cast<std::chrono::milliseconds>(period); }
 
 		inline std::chrono::milliseconds messagePollerRetryPeriod() const { return _messagePollerRetryPeriod; }
-		template <typename Repr>
-		void messagePollerRetryPeriod(std::chrono::duration<Repr> period) { _messagePollerRetryPeriod = period; }
+		template <typename Repr, typename Period>
+		void messagePollerRetryPeriod(std::chrono::duration<Repr, Period> period) { _messagePollerRetryPeriod = std::chrono::duration_cast<std::chrono::milliseconds>(period); }
+
+		inline bool eventDrivenDispatch() const noexcept { return _eventDriven; }
 
 		// Simulator state
 		std::string systemStateName(SystemState state) const noexcept;
@@ -164,11 +206,119 @@ namespace CppSimConnect {
 		Reactive::MessageResult<bool> requestUserFlying();
 		inline bool isUserFlying() { return requestUserFlying().get(); }
 
+		/**
+		 * <summary>Request several system states at once. The requests are sent together, and the result
+		 * completes when all replies or exceptions have arrived.</summary>
+		 * A state that is not a SystemState fails the whole result, with an invalid_argument.
+		 */
+		Reactive::MessageResult<SystemStates> requestSystemStates(std::initializer_list<SystemState> states);
+
+		/**
+		 * <summary>Request a system state and receive the reply as a view on the message, without copying it.</summary>
+		 * The view is only valid during the call to <c>onState</c>, which is made on the dispatcher thread. This always
+		 * asks the simulator; it does not use the cache or join outstanding requests.
+		 */
+		void requestSystemState(SystemState state, std::function<void(messages::SystemStateView const& view)> onState, std::function<void(std::exception_ptr err)> onError);
+
+		// Simulation variables
+
+		/**
+		 * <summary>Request the current values of a data definition struct, for the user's aircraft by default.</summary>
+		 */
+		template <DataStruct T>
+		Reactive::MessageResult<T> requestData(std::uint32_t objectId = UserObjectId) {
+			Reactive::MessageResult<T> result;
+			simRequestData(dataLayout<T>(), objectId,
+				[result](const std::byte* data) {
+					T value;
+					std::memcpy(&value, data, sizeof(T));
+					result.onNext(value);
+				},
+				[result](std::exception_ptr err) { result.onError(err); });
+			return result;
+		}
+
+		/**
+		 * <summary>Request the current values of a data definition struct, without copying them.</summary>
+		 * The struct passed to <c>onData</c> lies in the simulator's receive buffer, and is only valid during the call,
+		 * which is made on the dispatcher thread.
+		 */
+		template <DataStruct T>
+		void requestData(std::function<void(const T& data)> onData, std::function<void(std::exception_ptr err)> onError, std::uint32_t objectId = UserObjectId) {
+			simRequestData(dataLayout<T>(), objectId,
+				[onData = std::move(onData)](const std::byte* data) { onData(*reinterpret_cast<const T*>(data)); },
+				std::move(onError));
+		}
+
+		/**
+		 * <summary>Receive the values of a data definition struct every period, until the stream is completed.</summary>
+		 * With <c>changedOnly</c>, the simulator only sends the struct when one of its values changed.
+		 * A subscription lasts for the current connection: the stream gets a NotConnected error when that closes.
+		 */
+		template <DataStruct T>
+		Reactive::StreamResult<T> subscribe(std::uint32_t objectId, DataPeriod period, bool changedOnly = false) {
+			Reactive::StreamResult<T> stream;
+			auto cancel = simSubscribeData(dataLayout<T>(), objectId, period, changedOnly, false,
+				[stream](std::span<const std::byte> data, std::uint32_t) {
+					T value;
+					std::memcpy(&value, data.data(), sizeof(T));
+					stream.onNext(value);
+				},
+				[stream](std::exception_ptr err) { stream.onError(err); });
+			stream.withOnComplete([cancel = std::move(cancel)]() { cancel(); });
+			return stream;
+		}
+
+		/**
+		 * <summary>Receive only the changed values of a data definition struct, as tagged data.</summary>
+		 * Each update carries the struct with the latest value of every field, and marks the fields that changed.
+		 * The first update has all fields. When most values are idle, this is far less to send and decode.
+		 */
+		template <DataStruct T>
+		Reactive::StreamResult<DataUpdate<T>> subscribeTagged(std::uint32_t objectId, DataPeriod period) {
+			static_assert(dataFieldCount<T>() <= 64, "A tagged subscription supports up to 64 fields.");
+
+			Reactive::StreamResult<DataUpdate<T>> stream;
+			auto current = std::make_shared<T>();		// Only touched on the dispatcher thread
+			const DataLayout& layout{ dataLayout<T>() };
+			auto cancel = simSubscribeData(layout, objectId, period, true, true,
+				[this, stream, current, &layout](std::span<const std::byte> data, std::uint32_t count) {
+					DataUpdate<T> update;
+					if (!layout.applyTagged(reinterpret_cast<std::byte*>(current.get()), data.data(), data.size(), count, update.fields)) {
+						_logger.warn("Ignoring tagged data that does not match its definition.");
+						return;
+					}
+					update.value = *current;
+					stream.onNext(update);
+				},
+				[stream](std::exception_ptr err) { stream.onError(err); });
+			stream.withOnComplete([cancel = std::move(cancel)]() { cancel(); });
+			return stream;
+		}
+
+		inline EventManager& events() noexcept { return _events; }
+
+		/**
+		 * <summary>Map a set of client events, right away if connected, and again each time a connection opens.</summary>
+		 * The calls are queued together and don't wait for replies, so the whole set costs about one round trip.
+		 * An event that an earlier set already mapped is not mapped again.
+		 */
+		void addClientEvents(ClientEventSet events);
+
+		// Statistics, for the current connection
+		ExceptionStats exceptionStats() const noexcept;
+		RequestStats requestStats() const noexcept;
+		MessageStats messageStats() const noexcept;
+		TimingStats timingStats() const;
+		inline LogStats logStats() const noexcept { return _asyncSink ? _asyncSink->stats() : LogStats{}; }
+		inline void flushLog() { if (_asyncSink) { _asyncSink->flush(); } }
+
 		// Callbacks
 		void addStateLogger(std::function<void(std::string const& msg)>&& cb) { stateLoggers.emplace_back(cb); }
 		void onConnect(std::function<void()>&& cb) { onConnectHandlers.emplace_back(cb); }
 		void onDisconnect(std::function<void()>&& cb) { onDisconnectHandlers.emplace_back(cb); }
 		void onOpen(std::function<void(messages::AppInfo const& appInfo)>&& cb) { onOpenHandlers.emplace_back(cb); }
+		void onOpenView(std::function<void(messages::AppInfoView const& appInfo)>&& cb) { onOpenViewHandlers.emplace_back(cb); }	// Valid during the call only
 		void onClose(std::function<void()>&& cb) { onCloseHandlers.emplace_back(cb); }
 
 		/**
@@ -183,10 +333,26 @@ namespace CppSimConnect {
 			bool _autoConnect{ false };
 			std::chrono::milliseconds _autoConnectRetryPeriod{ 5000 };
 			std::chrono::milliseconds _messagePollerRetryPeriod{ 100 };
+			bool _eventDriven{ true };
 			bool _stopOnDisconnect{ true };
 
 			LogLevel _loggingThreshold{ LogLevel::Info };
 			std::function<void(LogLevel level, std::string)> _logger;
+			bool _asyncLogging{ false };
+			size_t _asyncLogCapacity{ 4096 };
+			LogOverflow _asyncLogOverflow{ LogOverflow::DropNewest };
+			bool _deferredFormatting{ false };
+			std::filesystem::path _binaryLog;
+
+			std::shared_ptr<SimBackend> _backend;
+			std::filesystem::path _messageRecording;
+
+			size_t _exceptionDepth{ 1024 };
+			std::chrono::milliseconds _earlyErrorMaxAge{ 5000 };
+			bool _cacheSystemStates{ true };
+			bool _timingStats{ false };
+
+			std::vector<ClientEventSet> _clientEvents;
 
 		public:
 			Builder() = default;
@@ -216,14 +382,29 @@ namespace CppSimConnect {
 				_autoConnect = false;
 				return *this;
 			}
-			template <typename Repr>
-			Builder& withAutoConnectRetryPeriod(std::chrono::duration<Repr> period) {
-				_autoConnectRetryPeriod = period;
+			template <typename Repr, typename Period>
+			Builder& withAutoConnectRetryPeriod(std::chrono::duration<Repr, Period> period) {
+				_autoConnectRetryPeriod = std::chrono::duration_cast<std::chrono::milliseconds>(period);
 				return *this;
 			}
-			template <typename Repr>
-			Builder& withMessagePollerRetryPeriod(std::chrono::duration<Repr> period) {
-				_messagePollerRetryPeriod = period;
+			template <typename Repr, typename Period>
+			Builder& withMessagePollerRetryPeriod(std::chrono::duration<Repr, Period> period) {
+				_messagePollerRetryPeriod = std::chrono::duration_cast<std::chrono::milliseconds>(period);
+				return *this;
+			}
+			/**
+			 * <summary>Wake the message dispatcher as soon as the simulator signals new messages. The poller
+			 * retry period then only bounds how long it waits without a signal. This is the default.</summary>
+			 */
+			Builder& withEventDrivenDispatch() {
+				_eventDriven = true;
+				return *this;
+			}
+			/**
+			 * <summary>Check for new messages once every poller retry period.</summary>
+			 */
+			Builder& withPolledDispatch() {
+				_eventDriven = false;
 				return *this;
 			}
 			Builder& stopOnDisconnect() {
@@ -243,6 +424,100 @@ namespace CppSimConnect {
 				_logger = logger;
 				return *this;
 			}
+			/**
+			 * <summary>Pass log messages to the logger on a thread of its own, through a buffer of <c>capacity</c>
+			 * messages, so logging never holds up the message dispatcher unless the overflow policy says so.</summary>
+			 */
+			Builder& withAsyncLogging(size_t capacity = 4096, LogOverflow overflow = LogOverflow::DropNewest) {
+				_asyncLogging = true;
+				_asyncLogCapacity = capacity;
+				_asyncLogOverflow = overflow;
+				return *this;
+			}
+			/**
+			 * <summary>Keep the format string and arguments of log messages, and format them on the logging thread.
+			 * Messages with arguments that can't be captured, or that don't fit, are still formatted immediately.
+			 * This implies asynchronous logging.</summary>
+			 */
+			Builder& withDeferredFormatting() {
+				_asyncLogging = true;
+				_deferredFormatting = true;
+				return *this;
+			}
+			/**
+			 * <summary>Write log messages unformatted to a binary file, which CppSimConnectLogDecoder turns back into text.
+			 * A logger set with withLogger() still receives the formatted messages. This implies deferred formatting.</summary>
+			 */
+			Builder& withBinaryLog(std::filesystem::path file) {
+				_asyncLogging = true;
+				_deferredFormatting = true;
+				_binaryLog = std::move(file);
+				return *this;
+			}
+			Builder& withSyncLogging() {
+				_asyncLogging = false;
+				_deferredFormatting = false;
+				_binaryLog.clear();
+				return *this;
+			}
+
+			/**
+			 * <summary>Talk to the simulator through the given backend instead of the SimConnect library.</summary>
+			 */
+			Builder& withBackend(std::shared_ptr<SimBackend> backend) {
+				_backend = std::move(backend);
+				return *this;
+			}
+
+			/**
+			 * <summary>Append every message received to a file, which a ReplayBackend can play back. The file is
+			 * flushed after each batch of messages, so it is complete up to the last one handled.</summary>
+			 */
+			Builder& withMessageRecording(std::filesystem::path file) {
+				_messageRecording = std::move(file);
+				return *this;
+			}
+
+			/**
+			 * <summary>Keep exception handlers for the last <c>depth</c> calls sent, and exceptions that arrive
+			 * before their handler for at most <c>maxAge</c>.</summary>
+			 */
+			template <typename Repr, typename Period>
+			Builder& withExceptionCorrelation(size_t depth, std::chrono::duration<Repr, Period> maxAge) {
+				_exceptionDepth = depth;
+				_earlyErrorMaxAge = std::chrono::duration_cast<std::chrono::milliseconds>(maxAge);
+				return *this;
+			}
+
+			/**
+			 * <summary>Answer requests for AircraftLoaded, FlightLoaded, FlightPlan, and Sim from memory, kept
+			 * up to date by subscribing to the system events that signal their change. This is the default.</summary>
+			 */
+			Builder& withSystemStateCache() {
+				_cacheSystemStates = true;
+				return *this;
+			}
+			Builder& withoutSystemStateCache() {
+				_cacheSystemStates = false;
+				return *this;
+			}
+
+			/**
+			 * <summary>Time request round trips, message handling, and callbacks, for timingStats(). This costs
+			 * a few clock reads per message, so it is off by default.</summary>
+			 */
+			Builder& withTimingStats() {
+				_timingStats = true;
+				return *this;
+			}
+
+			/**
+			 * <summary>Map a set of client events with the first calls sent on every connection.</summary>
+			 */
+			Builder& withClientEvents(ClientEventSet events) {
+				_clientEvents.push_back(std::move(events));
+				return *this;
+			}
 
 			SimConnect& build() {
 				auto result = std::make_shared<SimConnect>(*this);
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "EventManager.h"
+
+
+using CppSimConnect::EventID;
+using CppSimConnect::EventManager;
+
+
+EventManager::EventManager(SimConnect& api) : _api{ api }
+{
+    _indexes.push_back(std::make_unique<Index>(initialIndexSize));
+    _index.store(_indexes.back().get(), std::memory_order_release);
+}
+
+std::string_view EventManager::storeName(std::string_view name)
+{
+    if (name.empty()) {
+        return {};
+    }
+    if (name.size() > _nameFreeSize) {
+        // A long name gets a block of its own, so the rest of the current block isn't wasted.
+        if (name.size() > (nameBlockSize / 4)) {
+            _nameBlocks.push_back(std::make_unique<char[]>(name.size()));
+            std::memcpy(_nameBlocks.back().get(), name.data(), name.size());
+            return { _nameBlocks.back().get(), name.size() };
+        }
+        _nameBlocks.push_back(std::make_unique<char[]>(nameBlockSize));
+        _nameFree = _nameBlocks.back().get();
+        _nameFreeSize = nameBlockSize;
+    }
+    std::string_view result{ _nameFree, name.size() };
+    std::memcpy(_nameFree, name.data(), name.size());
+    _nameFree += name.size();
+    _nameFreeSize -= name.size();
+    return result;
+}
+
+EventID EventManager::add(std::string_view name, std::uint32_t hash)
+{
+    std::lock_guard lock(_writeLock);
+
+    Index* index = _index.load(std::memory_order_relaxed);
+    if (const Entry* entry = index->find(name, hash)) {
+        return entry->id;
+    }
+
+    const size_t id{ _size.load(std::memory_order_relaxed) };
+    if (id >= (maxPages * pageSize)) {
+        throw std::length_error("Too many client events");
+    }
+    if (_pages[id >> pageBits].load(std::memory_order_relaxed) == nullptr) {
+        _ownedPages.push_back(std::make_unique<Page>());
+        _pages[id >> pageBits].store(_ownedPages.back().get(), std::memory_order_release);
+    }
+    Entry& entry{ (*_pages[id >> pageBits].load(std::memory_order_relaxed))[id & (pageSize - 1)] };
+    entry.name = storeName(name);
+    entry.hash = hash;
+    entry.id = static_cast<EventID>(id);
+
+    // Keep the index at most half full, so probes stay short and always end at an empty slot.
+    if (((id + 1) * 2) > index->slots.size()) {
+        _indexes.push_back(std::make_unique<Index>(index->slots.size() * 2));
+        index = _indexes.back().get();
+        for (size_t i = 0; i < id; i++) {
+            index->insert(&(*_pages[i >> pageBits].load(std::memory_order_relaxed))[i & (pageSize - 1)]);
+        }
+    }
+    index->insert(&entry);
+    _index.store(index, std::memory_order_release);
+    _size.store(id + 1, std::memory_order_release);
+
+    return entry.id;
+}
\ No newline at end of file
@@ -16,47 +16,151 @@
 
 #pragma once
 
-#include "../CppSimConnect.h"
-
+#include <array>
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
 
 
 namespace CppSimConnect {
 
+	class SimConnect;
+
 	using EventID = unsigned;
 	using GroupID = unsigned;
 
+	/**
+	 * <summary>The 32-bit FNV-1a hash of an event name, usable at compile time.</summary>
+	 */
+	constexpr std::uint32_t eventNameHash(std::string_view name) noexcept {
+		std::uint32_t hash{ 2166136261u };
+		for (char c : name) {
+			hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619u;
+		}
+		return hash;
+	}
+
+	/**
+	 * <summary>An event name with its hash computed at compile time. Write <c>"AP_MASTER"_event</c> to get one.</summary>
+	 */
+	class EventName {
+		std::string_view _name;
+		std::uint32_t _hash;
+
+	public:
+		consteval explicit EventName(std::string_view name) : _name{ name }, _hash{ eventNameHash(name) } {}
+
+		inline constexpr std::string_view name() const noexcept { return _name; }
+		inline constexpr std::uint32_t hash() const noexcept { return _hash; }
+	};
+
+	namespace literals {
+		consteval EventName operator""_event(const char* name, size_t length) {
+			return EventName(std::string_view(name, length));
+		}
+	}
+
+	/**
+	 * <summary>Interns client event names for a single connection, handing out dense EventIDs from 0.</summary>
+	 *
+	 * Looking up a name that is already interned takes no lock: the index is an open-addressed table of
+	 * atomic pointers, and entries never move or change once published. Only adding a name takes the
+	 * lock. When the index grows, the old one stays around until the manager goes, because a reader may
+	 * still be probing it; a reader that misses there falls back to the locked path, which looks again.
+	 *
+	 * Names are copied into blocks that are never reallocated, so the views returned by name() stay
+	 * valid for the life of the manager.
+	 */
 	class EventManager {
+		struct Entry {
+			std::string_view name;
+			std::uint32_t hash{ 0 };
+			EventID id{ 0 };
+		};
+
+		struct Index {
+			std::vector<std::atomic<const Entry*>> slots;
+			std::uint32_t mask;
+
+			Index(size_t capacity) : slots(capacity), mask{ static_cast<std::uint32_t>(capacity - 1) } {}
+
+			const Entry* find(std::string_view name, std::uint32_t hash) const noexcept {
+				for (std::uint32_t i = hash & mask; ; i = (i + 1) & mask) {
+					const Entry* entry = slots[i].load(std::memory_order_acquire);
+					if ((entry == nullptr) || ((entry->hash == hash) && (entry->name == name))) {
+						return entry;
+					}
+				}
+			}
+			void insert(const Entry* entry) noexcept {
+				std::uint32_t i{ entry->hash & mask };
+				while (slots[i].load(std::memory_order_relaxed) != nullptr) {
+					i = (i + 1) & mask;
+				}
+				slots[i].store(entry, std::memory_order_release);
+			}
+		};
+
+		static constexpr unsigned pageBits{ 10 };
+		static constexpr size_t pageSize{ size_t{ 1 } << pageBits };
+		static constexpr size_t maxPages{ 64 };
+		static constexpr size_t initialIndexSize{ 256 };
+		static constexpr size_t nameBlockSize{ 4096 };
+
+		using Page = std::array<Entry, pageSize>;
+
+		SimConnect& _api;
+
+		std::mutex _writeLock;
+		std::atomic<Index*> _index;
+		std::vector<std::unique_ptr<Index>> _indexes;		// The current index and all earlier ones
+		std::array<std::atomic<Page*>, maxPages> _pages{};
+		std::vector<std::unique_ptr<Page>> _ownedPages;
+		std::atomic<size_t> _size{ 0 };
+		std::atomic<GroupID> _nextGroup{ 0 };
+
+		// Name storage
+		std::vector<std::unique_ptr<char[]>> _nameBlocks;
+		char* _nameFree{ nullptr };
+		size_t _nameFreeSize{ 0 };
+
+		std::string_view storeName(std::string_view name);
+		EventID add(std::string_view name, std::uint32_t hash);
+
+		inline EventID lookup(std::string_view name, std::uint32_t hash) {
+			const Entry* entry = _index.load(std::memory_order_acquire)->find(name, hash);
+			return (entry != nullptr) ? entry->id : add(name, hash);
+		}
+
+	public:
+		EventManager(SimConnect& api);
+		~EventManager() = default;
 		EventManager(const EventManager&) = delete;
 		EventManager(EventManager&&) = delete;
 		EventManager& operator=(const EventManager&) = delete;
 		EventManager& operator=(EventManager&&) = delete;
 
-		SimConnect& _api;
+		inline SimConnect& api() const noexcept { return _api; }
 
-		static std::mutex _eventLock;
-		static EventID _nextID;
-		static GroupID _nextGroup;
-		static std::vector<std::string> _names;
-		static std::map<std::string, EventID> _ids;
-		template <typename T>
-
-		EventID eventID(T&& eventName) {
-			std::lock_guard<std::mutex> lock(_eventLock);
-			std::string name{ std::forward<T>(eventName) };
-			auto it{ _ids.find(name) };
-			if (it == _ids.cend()) {
-				_names.resize(_nextID + 1, name);
-				_ids.emplace(std::move(name), _nextID);
-				return _nextID++;
-			}
-			return it->second;
+		/**
+		 * <summary>The ID of the named event, interning the name if this is the first time it is seen.</summary>
+		 */
+		inline EventID eventID(std::string_view name) { return lookup(name, eventNameHash(name)); }
+		inline EventID eventID(EventName name) { return lookup(name.name(), name.hash()); }
+
+		/**
+		 * <summary>The name of an event, which must have been returned by eventID().</summary>
+		 */
+		inline std::string_view name(EventID id) const noexcept {
+			return (*_pages[id >> pageBits].load(std::memory_order_acquire))[id & (pageSize - 1)].name;
 		}
 
-	public:
-		EventManager(SimConnect& api) : _api{ api } {}
-		~EventManager() = default;
+		inline bool contains(EventID id) const noexcept { return id < _size.load(std::memory_order_acquire); }
+		inline size_t size() const noexcept { return _size.load(std::memory_order_acquire); }
 
-		
+		inline GroupID nextGroupID() noexcept { return _nextGroup.fetch_add(1, std::memory_order_relaxed); }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <array>
+#include <charconv>
+#include <format>
+
+#include "LogRecord.h"
+
+
+using CppSimConnect::LogArgType;
+using CppSimConnect::LogRecord;
+
+
+namespace {
+
+    struct LogArg {
+        LogArgType type;
+        const std::byte* value;
+    };
+
+    template <typename T>
+    T read(const std::byte* value) noexcept {
+        T result;
+        std::memcpy(&result, value, sizeof(T));
+        return result;
+    }
+
+    template <typename T>
+    void appendFormatted(std::string& out, const std::string& fieldFormat, T value) {
+        out += std::vformat(fieldFormat, std::make_format_args(value));
+    }
+
+    void appendArg(std::string& out, const std::string& fieldFormat, const LogArg& arg) {
+        switch (arg.type) {
+        case LogArgType::Bool:
+            appendFormatted(out, fieldFormat, read<std::uint8_t>(arg.value) != 0);
+            break;
+        case LogArgType::Char:
+            appendFormatted(out, fieldFormat, read<char>(arg.value));
+            break;
+        case LogArgType::Int:
+            appendFormatted(out, fieldFormat, read<std::int64_t>(arg.value));
+            break;
+        case LogArgType::UInt:
+            appendFormatted(out, fieldFormat, read<std::uint64_t>(arg.value));
+            break;
+        case LogArgType::Float:
+            appendFormatted(out, fieldFormat, read<float>(arg.value));
+            break;
+        case LogArgType::Double:
+            appendFormatted(out, fieldFormat, read<double>(arg.value));
+            break;
+        case LogArgType::String:
+            appendFormatted(out, fieldFormat, std::string_view(reinterpret_cast<const char*>(arg.value) + sizeof(std::uint16_t), read<std::uint16_t>(arg.value)));
+            break;
+        case LogArgType::Pointer:
+            appendFormatted(out, fieldFormat, reinterpret_cast<const void*>(static_cast<std::uintptr_t>(read<std::uint64_t>(arg.value))));
+            break;
+        }
+    }
+
+    // Find where each argument starts, checking that they all lie within the data.
+    size_t locateArgs(std::array<LogArg, LogRecord::maxArgs>& args, std::span<const LogArgType> types, std::span<const std::byte> data) noexcept {
+        size_t count{ 0 };
+        size_t offset{ 0 };
+        for (auto type : types) {
+            if (count == args.size()) {
+                return 0;
+            }
+            size_t size{ 0 };
+            switch (type) {
+            case LogArgType::Bool:
+            case LogArgType::Char:
+                size = 1;
+                break;
+            case LogArgType::Int:
+            case LogArgType::UInt:
+            case LogArgType::Double:
+            case LogArgType::Pointer:
+                size = 8;
+                break;
+            case LogArgType::Float:
+                size = 4;
+                break;
+            case LogArgType::String:
+                if ((offset + sizeof(std::uint16_t)) > data.size()) {
+                    return 0;
+                }
+                size = sizeof(std::uint16_t) + read<std::uint16_t>(data.data() + offset);
+                break;
+            default:
+                return 0;
+            }
+            if ((offset + size) > data.size()) {
+                return 0;
+            }
+            args[count++] = { type, data.data() + offset };
+            offset += size;
+        }
+        return count;
+    }
+}
+
+
+void CppSimConnect::formatLogArgs(std::string& out, std::string_view format, std::span<const LogArgType> types, std::span<const std::byte> data)
+{
+    out.clear();
+
+    std::array<LogArg, LogRecord::maxArgs> args;
+    const size_t count{ locateArgs(args, types, data) };
+    if (count != types.size()) {
+        out.append(format);
+        out.append(" <malformed arguments>");
+        return;
+    }
+
+    std::string fieldFormat;
+    size_t nextArg{ 0 };
+    size_t pos{ 0 };
+    while (pos < format.size()) {
+        const auto special{ format.find_first_of("{}", pos) };
+        if (special == std::string_view::npos) {
+            out.append(format.substr(pos));
+            break;
+        }
+        out.append(format.substr(pos, special - pos));
+        pos = special;
+
+        if (format[pos] == '}') {
+            out += '}';
+            pos += ((pos + 1) < format.size() && format[pos + 1] == '}') ? 2 : 1;
+            continue;
+        }
+        if ((pos + 1) < format.size() && format[pos + 1] == '{') {
+            out += '{';
+            pos += 2;
+            continue;
+        }
+        const auto end{ format.find('}', pos) };
+        if (end == std::string_view::npos) {
+            out.append(format.substr(pos));
+            break;
+        }
+        const auto field{ format.substr(pos + 1, end - pos - 1) };
+        const auto colon{ field.find(':') };
+        const auto id{ field.substr(0, colon) };
+
+        size_t index{ nextArg++ };
+        if (!id.empty() && (std::from_chars(id.data(), id.data() + id.size(), index).ec != std::errc())) {
+            index = count;
+        }
+        if (index < count) {
+            fieldFormat.assign("{");
+            if (colon != std::string_view::npos) {
+                fieldFormat.append(field.substr(colon));
+            }
+            fieldFormat += '}';
+            try {
+                appendArg(out, fieldFormat, args[index]);
+            }
+            catch (const std::format_error&) {
+                out.append(format.substr(pos, end + 1 - pos));
+            }
+        }
+        else {
+            out.append(format.substr(pos, end + 1 - pos));
+        }
+        pos = end + 1;
+    }
+}
+
+void LogRecord::formatTo(std::string& out) const
+{
+    if (preformatted()) {
+        out.assign(text());
+    }
+    else {
+        formatLogArgs(out, format, argTypes(), argData());
+    }
+}
+
+std::string LogRecord::formatted() const
+{
+    std::string result;
+    formatTo(result);
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace CppSimConnect {
+
+	enum class LogLevel {
+		Trace,
+		Debug,
+		Info,
+		Warn,
+		Error,
+		Fatal
+	};
+
+	/**
+	 * <summary>The types a log argument is stored as. Integers are widened to 64 bits.</summary>
+	 * The values are part of the binary log format, so they must never change.
+	 */
+	enum class LogArgType : std::uint8_t {
+		Bool = 0,
+		Char = 1,
+		Int = 2,
+		UInt = 3,
+		Float = 4,
+		Double = 5,
+		String = 6,		// A 16-bit length followed by the characters
+		Pointer = 7
+	};
+
+	template <typename T>
+	concept CapturableLogArg =
+		std::is_arithmetic_v<std::remove_cvref_t<T>> ||
+		std::is_convertible_v<const T&, std::string_view> ||
+		std::same_as<std::remove_cvref_t<T>, const void*> || std::same_as<std::remove_cvref_t<T>, void*>;
+
+	/**
+	 * <summary>A log message, either formatted or as the format string with its arguments.</summary>
+	 *
+	 * Capturing copies the arguments in binary form, so the formatting can be done later, on another thread,
+	 * or even in another program. Only the pointer to the format string is kept, so it must outlive the record;
+	 * the checked format strings of the Logger are string literals, which do. Records have a fixed size, so
+	 * capturing fails if the arguments don't fit, and formatted text is truncated.
+	 */
+	struct LogRecord {
+		static constexpr size_t maxArgs{ 12 };
+		static constexpr size_t dataSize{ 220 };
+
+		const char* format{ nullptr };			// The format string, or nullptr if data holds the formatted text.
+		std::int64_t timestamp{ 0 };			// System clock, nanoseconds since the epoch
+		LogLevel level{ LogLevel::Info };
+		std::uint8_t argCount{ 0 };
+		std::uint16_t length{ 0 };				// Bytes used in data
+		LogArgType types[maxArgs];
+		std::byte data[dataSize];
+
+		static inline std::int64_t now() noexcept {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		}
+
+		inline void setText(LogLevel lvl, std::string_view text) noexcept {
+			format = nullptr;
+			timestamp = now();
+			level = lvl;
+			argCount = 0;
+			length = static_cast<std::uint16_t>((text.size() < dataSize) ? text.size() : dataSize);
+			std::memcpy(data, text.data(), length);
+		}
+
+		/**
+		 * <summary>Store the format string and arguments. Returns false if they don't fit.</summary>
+		 * <c>fmt</c> must be null-terminated and stay at the same address, unchanged, for the life of the program:
+		 * only the pointer is stored, and a BinaryLogWriter knows formats it has already written by their address.
+		 * A string literal qualifies; a buffer that is reused for other text does not.
+		 */
+		template <CapturableLogArg... Targs>
+		inline bool capture(LogLevel lvl, const char* fmt, const Targs&... args) noexcept {
+			if constexpr (sizeof...(Targs) > maxArgs) {
+				return false;
+			}
+			format = fmt;
+			timestamp = now();
+			level = lvl;
+			argCount = 0;
+			length = 0;
+			return (put(args) && ...);
+		}
+
+		inline bool preformatted() const noexcept { return format == nullptr; }
+		inline std::string_view text() const noexcept { return { reinterpret_cast<const char*>(data), length }; }
+		inline std::span<const LogArgType> argTypes() const noexcept { return { types, argCount }; }
+		inline std::span<const std::byte> argData() const noexcept { return { data, length }; }
+
+		/**
+		 * <summary>Write the message into <c>out</c>, replacing its contents.</summary>
+		 */
+		void formatTo(std::string& out) const;
+		std::string formatted() const;
+
+	private:
+		template <typename T>
+		inline bool putValue(LogArgType type, T value) noexcept {
+			if ((length + sizeof(T)) > dataSize) {
+				return false;
+			}
+			std::memcpy(data + length, &value, sizeof(T));
+			length += sizeof(T);
+			types[argCount++] = type;
+			return true;
+		}
+
+		inline bool putString(std::string_view value) noexcept {
+			const auto size{ static_cast<std::uint16_t>(value.size()) };
+			if ((value.size() > 0xffff) || ((length + sizeof(size) + size) > dataSize)) {
+				return false;
+			}
+			std::memcpy(data + length, &size, sizeof(size));
+			std::memcpy(data + length + sizeof(size), value.data(), size);
+			length += static_cast<std::uint16_t>(sizeof(size) + size);
+			types[argCount++] = LogArgType::String;
+			return true;
+		}
+
+		template <typename T>
+		inline bool put(const T& value) noexcept {
+			using U = std::remove_cvref_t<T>;
+			if constexpr (std::same_as<U, bool>) {
+				return putValue(LogArgType::Bool, value);
+			}
+			else if constexpr (std::same_as<U, char>) {
+				return putValue(LogArgType::Char, value);
+			}
+			else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+				return putValue(LogArgType::Int, static_cast<std::int64_t>(value));
+			}
+			else if constexpr (std::is_integral_v<U>) {
+				return putValue(LogArgType::UInt, static_cast<std::uint64_t>(value));
+			}
+			else if constexpr (std::same_as<U, float>) {
+				return putValue(LogArgType::Float, value);
+			}
+			else if constexpr (std::is_floating_point_v<U>) {
+				return putValue(LogArgType::Double, static_cast<double>(value));
+			}
+			else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+				return putString(std::string_view(value));
+			}
+			else {
+				return putValue(LogArgType::Pointer, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value)));
+			}
+		}
+	};
+
+	/**
+	 * <summary>Format a message from a format string and arguments as captured in a LogRecord.</summary>
+	 *
+	 * Replacement fields are handled one at a time, so argument ids and format specs work, but nested replacement
+	 * fields (such as a width taken from an argument) do not. Errors are reported inside the text, never thrown.
+	 */
+	void formatLogArgs(std::string& out, std::string_view format, std::span<const LogArgType> types, std::span<const std::byte> data);
+
+	using LogRecordSink = std::function<void(const LogRecord&)>;
+}
\ No newline at end of file
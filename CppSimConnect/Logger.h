@@ -21,16 +21,20 @@
 #include <optional>
 #include <functional>
 
+#include "LogRecord.h"
+
+/**
+ * Log calls below this level compile to nothing: 0 = Trace (keep everything), 1 = Debug, 2 = Info, 3 = Warn,
+ * 4 = Error, 5 = Fatal. Define it before including the library headers, for example to 2 in release builds
+ * that cannot afford the threshold checks.
+ */
+#ifndef CPPSIMCONNECT_MIN_LOG_LEVEL
+#define CPPSIMCONNECT_MIN_LOG_LEVEL 0
+#endif
+
 namespace CppSimConnect {
 
-	enum class LogLevel {
-		Trace,
-		Debug,
-		Info,
-		Warn,
-		Error,
-		Fatal
-	};
+	constexpr LogLevel minimumLogLevel{ static_cast<LogLevel>(CPPSIMCONNECT_MIN_LOG_LEVEL) };
 
 	using LogSink = std::function<void(LogLevel, const std::string&)>;
 
@@ -40,9 +44,29 @@ namespace CppSimConnect {
 		std::string _name;
 		LogLevel _threshold;
 		LogSink &_logger;
+		LogRecordSink* _records{ nullptr };
+
+		inline bool enabled(LogLevel level) const noexcept { return _logger && (_threshold <= level); }
+
+		// If there is a record sink, capture the arguments and leave the formatting to it. Capturing keeps only
+		// fmt.data(), so the format strings passed to the level methods must be string literals; see LogRecord::capture().
+		template <typename ...Targs>
+		inline void log(LogLevel level, std::string_view fmt, const Targs&... args) {
+			if constexpr ((CapturableLogArg<Targs> && ...)) {
+				if (_records != nullptr) {
+					LogRecord record;
+					if (record.capture(level, fmt.data(), args...)) {
+						(*_records)(record);
+						return;
+					}
+				}
+			}
+			_logger(level, std::vformat(fmt, std::make_format_args(args...)));
+		}
 
 	public:
-		Logger(std::string name, LogSink &logger, LogLevel threshold = LogLevel::Info) : _name(std::move(name)), _logger{ logger }, _threshold(threshold) {}
+		Logger(std::string name, LogSink &logger, LogLevel threshold = LogLevel::Info, LogRecordSink* records = nullptr)
+			: _name(std::move(name)), _logger{ logger }, _threshold(threshold), _records{ records } {}
 		~Logger() = default;
 		Logger(Logger const&) = default;
 		Logger(Logger&&) = default;
@@ -50,69 +74,105 @@ namespace CppSimConnect {
 		Logger& operator=(Logger&&) = default;
 
 		inline void trace(const char* msg) {
-			if (_logger && _threshold <= LogLevel::Trace) _logger(LogLevel::Trace, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Trace) {
+				if (enabled(LogLevel::Trace)) _logger(LogLevel::Trace, msg);
+			}
 		};
 		inline void trace(std::string msg) {
-			if (_logger && _threshold <= LogLevel::Trace) _logger(LogLevel::Trace, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Trace) {
+				if (enabled(LogLevel::Trace)) _logger(LogLevel::Trace, msg);
+			}
 		};
 		template <typename ...Targs>
-		inline void trace(const std::_Fmt_string<Targs...> fmt, Targs... args) {
-			if (_logger && _threshold <= LogLevel::Trace) _logger(LogLevel::Trace, std::format(fmt, std::forward<Targs>(args)...));
+		inline void trace(const std::format_string<const Targs&...> fmt, const Targs&... args) {
+			if constexpr (minimumLogLevel <= LogLevel::Trace) {
+				if (enabled(LogLevel::Trace)) log(LogLevel::Trace, fmt.get(), args...);
+			}
 		}
 
 		inline void debug(const char* msg) {
-			if (_logger && _threshold <= LogLevel::Debug) _logger(LogLevel::Debug, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Debug) {
+				if (enabled(LogLevel::Debug)) _logger(LogLevel::Debug, msg);
+			}
 		};
 		inline void debug(std::string msg) {
-			if (_logger && _threshold <= LogLevel::Debug) _logger(LogLevel::Debug, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Debug) {
+				if (enabled(LogLevel::Debug)) _logger(LogLevel::Debug, msg);
+			}
 		};
 		template <typename ...Targs>
-		inline void debug(const std::_Fmt_string<Targs...> fmt, Targs... args) {
-			if (_logger && _threshold <= LogLevel::Debug) _logger(LogLevel::Debug, std::format(fmt, std::forward<Targs>(args)...));
+		inline void debug(const std::format_string<const Targs&...> fmt, const Targs&... args) {
+			if constexpr (minimumLogLevel <= LogLevel::Debug) {
+				if (enabled(LogLevel::Debug)) log(LogLevel::Debug, fmt.get(), args...);
+			}
 		}
 
 		inline void info(const char* msg) {
-			if (_logger && _threshold <= LogLevel::Info) _logger(LogLevel::Info, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Info) {
+				if (enabled(LogLevel::Info)) _logger(LogLevel::Info, msg);
+			}
 		};
 		inline void info(std::string msg) {
-			if (_logger && _threshold <= LogLevel::Info) _logger(LogLevel::Info, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Info) {
+				if (enabled(LogLevel::Info)) _logger(LogLevel::Info, msg);
+			}
 		};
 		template <typename ...Targs>
-		inline void info(const std::_Fmt_string<Targs...> fmt, Targs... args) {
-			if (_logger && _threshold <= LogLevel::Info) _logger(LogLevel::Info, std::format(fmt, std::forward<Targs>(args)...));
+		inline void info(const std::format_string<const Targs&...> fmt, const Targs&... args) {
+			if constexpr (minimumLogLevel <= LogLevel::Info) {
+				if (enabled(LogLevel::Info)) log(LogLevel::Info, fmt.get(), args...);
+			}
 		}
 
 		inline void warn(const char* msg) {
-			if (_logger && _threshold <= LogLevel::Warn) _logger(LogLevel::Warn, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Warn) {
+				if (enabled(LogLevel::Warn)) _logger(LogLevel::Warn, msg);
+			}
 		};
 		inline void warn(std::string msg) {
-			if (_logger && _threshold <= LogLevel::Warn) _logger(LogLevel::Warn, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Warn) {
+				if (enabled(LogLevel::Warn)) _logger(LogLevel::Warn, msg);
+			}
 		};
 		template <typename ...Targs>
-		inline void warn(const std::_Fmt_string<Targs...> fmt, Targs... args) {
-			if (_logger && _threshold <= LogLevel::Warn) _logger(LogLevel::Warn, std::format(fmt, std::forward<Targs>(args)...));
+		inline void warn(const std::format_string<const Targs&...> fmt, const Targs&... args) {
+			if constexpr (minimumLogLevel <= LogLevel::Warn) {
+				if (enabled(LogLevel::Warn)) log(LogLevel::Warn, fmt.get(), args...);
+			}
 		}
 
 		inline void error(const char* msg) {
-			if (_logger && _threshold <= LogLevel::Error) _logger(LogLevel::Error, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Error) {
+				if (enabled(LogLevel::Error)) _logger(LogLevel::Error, msg);
+			}
 		};
 		inline void error(std::string msg) {
-			if (_logger && _threshold <= LogLevel::Error) _logger(LogLevel::Error, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Error) {
+				if (enabled(LogLevel::Error)) _logger(LogLevel::Error, msg);
+			}
 		};
-		template <typename... Targs>
-		inline void error(const std::_Fmt_string<Targs...> fmt, Targs... args) {
-			if (_logger && _threshold <= LogLevel::Error) _logger(LogLevel::Error, std::format(fmt, std::forward<Targs>(args)...));
+		template <typename ...Targs>
+		inline void error(const std::format_string<const Targs&...> fmt, const Targs&... args) {
+			if constexpr (minimumLogLevel <= LogLevel::Error) {
+				if (enabled(LogLevel::Error)) log(LogLevel::Error, fmt.get(), args...);
+			}
 		}
 
 		inline void fatal(const char* msg) {
-			if (_logger && _threshold <= LogLevel::Fatal) _logger(LogLevel::Fatal, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Fatal) {
+				if (enabled(LogLevel::Fatal)) _logger(LogLevel::Fatal, msg);
+			}
 		};
 		inline void fatal(std::string msg) {
-			if (_logger && _threshold <= LogLevel::Fatal) _logger(LogLevel::Fatal, msg);
+			if constexpr (minimumLogLevel <= LogLevel::Fatal) {
+				if (enabled(LogLevel::Fatal)) _logger(LogLevel::Fatal, msg);
+			}
 		};
 		template <typename ...Targs>
-		inline void fatal(const std::_Fmt_string<Targs...> fmt, Targs... args) {
-			if (_logger && _threshold <= LogLevel::Fatal) _logger(LogLevel::Fatal, std::format(fmt, std::forward<Targs>(args)...));
+		inline void fatal(const std::format_string<const Targs&...> fmt, const Targs&... args) {
+			if constexpr (minimumLogLevel <= LogLevel::Fatal) {
+				if (enabled(LogLevel::Fatal)) log(LogLevel::Fatal, fmt.get(), args...);
+			}
 		}
 
 	};
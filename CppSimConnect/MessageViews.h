@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "AppInfo.h"
+
+namespace CppSimConnect::messages {
+
+	/**
+	 * <summary>The text in a fixed-size character array of a message, which need not be null-terminated.</summary>
+	 */
+	template <size_t N>
+	inline std::string_view textView(const char (&text)[N]) noexcept {
+		return { text, static_cast<size_t>(std::find(text, text + N, '\0') - text) };
+	}
+
+	/**
+	 * <summary>The OPEN message, as a view on the receive buffer. It is only valid during the callback it is passed to;
+	 * use materialize() to keep it.</summary>
+	 */
+	struct AppInfoView {
+		std::string_view appName;
+		std::uint32_t appVersionMajor;
+		std::uint32_t appVersionMinor;
+		std::uint32_t appBuildMajor;
+		std::uint32_t appBuildMinor;
+
+		std::uint32_t scVersionMajor;
+		std::uint32_t scVersionMinor;
+		std::uint32_t scBuildMajor;
+		std::uint32_t scBuildMinor;
+
+		AppInfo materialize() const {
+			return {
+				std::string(appName),
+				std::to_string(appVersionMajor), std::to_string(appVersionMinor),
+				std::to_string(appBuildMajor), std::to_string(appBuildMinor),
+				std::to_string(scVersionMajor), std::to_string(scVersionMinor),
+				std::to_string(scBuildMajor), std::to_string(scBuildMinor)
+			};
+		}
+	};
+
+	/**
+	 * <summary>A SYSTEM_STATE reply, as a view on the receive buffer. It is only valid during the callback it is passed to.</summary>
+	 */
+	struct SystemStateView {
+		std::uint32_t integer;
+		float floatValue;
+		std::string_view string;
+
+		inline bool boolean() const noexcept { return integer != 0; }
+		inline std::string materialize() const { return std::string(string); }
+	};
+}
\ No newline at end of file
@@ -16,22 +16,58 @@
 
 #include "pch.h"
 
+#include <stdexcept>
 
+#include "sim/MessageRecorder.h"
+#ifdef _WIN32
+#include "sim/SimConnectBackend.h"
+#endif
+
+
+using CppSimConnect::AsyncLogSink;
+using CppSimConnect::BinaryLogWriter;
 using CppSimConnect::LogLevel;
+using CppSimConnect::LogRecord;
+using CppSimConnect::MessageRecorder;
+using CppSimConnect::SimBackend;
 using CppSimConnect::SimConnect;
 
+
+// The SimConnect library only exists on Windows; elsewhere the fake or replay backend must be given.
+static std::shared_ptr<SimBackend> defaultBackend() {
+#ifdef _WIN32
+    return std::make_shared<CppSimConnect::SimConnectBackend>();
+#else
+    throw std::invalid_argument("There is no SimConnect library on this platform; use Builder::withBackend()");
+#endif
+}
+
+
 // These need to go here to hide the SimState class.
 
 SimConnect::SimConnect(SimConnect::Builder const& builder) :
+    _backend{ builder._backend ? builder._backend : defaultBackend() },
+    _recorder{ builder._messageRecording.empty() ? nullptr : std::make_unique<MessageRecorder>(builder._messageRecording) },
+    _stopOnDisconnect{ builder._stopOnDisconnect },
     _clientName{ builder._clientName },
     _autoConnect{ builder._autoConnect },
     _autoConnectRetryPeriod{ builder._autoConnectRetryPeriod },
     _messagePollerRetryPeriod{ builder._messagePollerRetryPeriod },
-    _stopOnDisconnect{ builder._stopOnDisconnect },
+    _eventDriven{ builder._eventDriven },
+    _exceptionDepth{ builder._exceptionDepth },
+    _earlyErrorMaxAge{ builder._earlyErrorMaxAge },
+    _cacheSystemStates{ builder._cacheSystemStates },
+    _timingStats{ builder._timingStats },
     _loggingThreshold{ builder._loggingThreshold },
-    _sink{ builder._logger },
-    _logger{ "SimConnect", _sink, _loggingThreshold }
+    _asyncSink{ createAsyncSink(builder) },
+    _sink{ _asyncSink ? LogSink([this](LogLevel level, const std::string& msg) { _asyncSink->log(level, msg); }) : LogSink(builder._logger) },
+    _recordSink{ [this](const LogRecord& record) { _asyncSink->log(record); } },
+    _logger{ "SimConnect", _sink, _loggingThreshold, (_asyncSink && builder._deferredFormatting) ? &_recordSink : nullptr },
+    _events{ *this }
 {
+    for (auto const& events : builder._clientEvents) {
+        addClientEvents(events);
+    }
     if (builder._startRunning) {
         start();
     }
@@ -40,10 +76,23 @@ SimConnect::SimConnect(SimConnect::Builder const& builder) :
 SimConnect::~SimConnect() {
     disconnect();
     stop();
+    // The connector thread logs, so it must be gone before the loggers are.
+    if (_autoConnector.joinable() && (_autoConnector.get_id() != std::this_thread::get_id())) {
+        _autoConnector.join();
+    }
 }
 
 std::map<std::string, std::shared_ptr<CppSimConnect::SimConnect>> CppSimConnect::SimConnect::_clients;
 
+std::unique_ptr<AsyncLogSink> SimConnect::createAsyncSink(SimConnect::Builder const& builder)
+{
+    if (!builder._asyncLogging || (!builder._logger && builder._binaryLog.empty())) {
+        return nullptr;
+    }
+    auto writer = builder._binaryLog.empty() ? nullptr : std::make_unique<BinaryLogWriter>(builder._binaryLog);
+    return std::make_unique<AsyncLogSink>(builder._logger, builder._asyncLogCapacity, builder._asyncLogOverflow, std::move(writer));
+}
+
 
 void SimConnect::start() noexcept {
     _logger.debug("SimConnect::start()");
@@ -55,6 +104,15 @@ void SimConnect::start() noexcept {
     _running_cv.notify_all();
 }
 
+void SimConnect::stop() noexcept {
+    _logger.debug("SimConnect::stop()");
+
+    _running = false;
+    _running_cv.notify_all();
+    _connection_cv.notify_all();
+    _backend->wakeUp();
+}
+
 void CppSimConnect::SimConnect::autoConnectHandler()
 {
     while (running())
@@ -63,10 +121,11 @@ void CppSimConnect::SimConnect::autoConnectHandler()
         {
             notifyStateChanged("Handling messages.");
 
-            simDrainDispatchQueue();
-
-            std::unique_lock lock(_simConnector);
-            _connection_cv.wait_for(lock, _messagePollerRetryPeriod, [this] { return !running() || !connected(); });
+            while (running() && connected())
+            {
+                simDrainDispatchQueue();
+                waitForMessages();
+            }
         }
         else if (_autoConnect)
         {
@@ -87,6 +146,17 @@ void CppSimConnect::SimConnect::autoConnectHandler()
     }
 }
 
+void CppSimConnect::SimConnect::waitForMessages()
+{
+    if (_eventDriven) {
+        _backend->waitForDispatch(_messagePollerRetryPeriod);
+    }
+    else {
+        std::unique_lock lock(_simConnector);
+        _connection_cv.wait_for(lock, _messagePollerRetryPeriod, [this] { return !running() || !connected(); });
+    }
+}
+
 [[nodiscard]]
 bool SimConnect::connect(bool byAutoConnect)
 {
@@ -109,7 +179,29 @@ void CppSimConnect::SimConnect::disconnect() noexcept
     if (simDisconnect()) {
         _connected = false;
         _connection_cv.notify_all();
+        _backend->wakeUp();
 
         notifyDisconnected();
     }
 }
+
+
+CppSimConnect::ExceptionStats SimConnect::exceptionStats() const noexcept
+{
+    return _state ? _state->exceptionStats() : ExceptionStats{};
+}
+
+CppSimConnect::RequestStats SimConnect::requestStats() const noexcept
+{
+    return _state ? _state->requestStats() : RequestStats{};
+}
+
+CppSimConnect::MessageStats SimConnect::messageStats() const noexcept
+{
+    return _state ? _state->messageStats() : MessageStats{};
+}
+
+CppSimConnect::TimingStats SimConnect::timingStats() const
+{
+    return _state ? _state->timingStats() : TimingStats{};
+}
\ No newline at end of file
@@ -19,25 +19,99 @@
 #include <array>
 #include <string>
 
+#include "sim/MessageRecorder.h"
+#include "sim/RecvViews.h"
 #include "sim/SimState.h"
 
 
+using CppSimConnect::DispatchTiming;
 using CppSimConnect::LogLevel;
 using CppSimConnect::SimConnect;
 using CppSimConnect::SimState;
+using CppSimConnect::simObjectDataHeaderSize;
 
 
-static void copyAppInfo(CppSimConnect::messages::AppInfo& info, SIMCONNECT_RECV_OPEN const& msg) {
-    info.appName = msg.szApplicationName;
+// Message handlers, one per message type. Each is listed in the dispatch table below, with the size it needs.
 
-    info.appVersionMajor = std::to_string(msg.dwApplicationVersionMajor);
-    info.appVersionMinor = std::to_string(msg.dwApplicationVersionMinor);
-    info.appBuildMajor = std::to_string(msg.dwApplicationBuildMajor);
-    info.appBuildMinor = std::to_string(msg.dwApplicationBuildMinor);
-    info.scVersionMajor = std::to_string(msg.dwSimConnectVersionMajor);
-    info.scVersionMinor = std::to_string(msg.dwSimConnectVersionMinor);
-    info.scBuildMajor = std::to_string(msg.dwSimConnectBuildMajor);
-    info.scBuildMinor = std::to_string(msg.dwSimConnectBuildMinor);
+template <>
+void SimState::handleMessage<SIMCONNECT_RECV_ID_EXCEPTION>(SimConnect& sim, SIMCONNECT_RECV* msgPtr)
+{
+    SIMCONNECT_RECV_EXCEPTION& msg{ *static_cast<SIMCONNECT_RECV_EXCEPTION*>(msgPtr) };
+    sim._state->onExcept(msg.dwSendID, msg.dwException, msg.dwIndex);
+}
+
+template <>
+void SimState::handleMessage<SIMCONNECT_RECV_ID_OPEN>(SimConnect& sim, SIMCONNECT_RECV* msgPtr)
+{
+    const auto appInfo{ CppSimConnect::appInfoView(*static_cast<SIMCONNECT_RECV_OPEN*>(msgPtr)) };
+    sim._logger.info("Connected to '{}'", appInfo.appName);
+    sim.notifyOpen(appInfo);
+}
+
+template <>
+void SimState::handleMessage<SIMCONNECT_RECV_ID_QUIT>(SimConnect& sim, [[maybe_unused]] SIMCONNECT_RECV* msgPtr)
+{
+    sim.notifyClose();
+}
+
+template <>
+void SimState::handleMessage<SIMCONNECT_RECV_ID_EVENT>(SimConnect& sim, SIMCONNECT_RECV* msgPtr)
+{
+    SIMCONNECT_RECV_EVENT& msg{ *static_cast<SIMCONNECT_RECV_EVENT*>(msgPtr) };
+    sim._state->dispatchEvent(msg.uEventID, msg.uGroupID, msg.dwData, nullptr);
+}
+
+template <>
+void SimState::handleMessage<SIMCONNECT_RECV_ID_EVENT_FILENAME>(SimConnect& sim, SIMCONNECT_RECV* msgPtr)
+{
+    SIMCONNECT_RECV_EVENT_FILENAME& msg{ *static_cast<SIMCONNECT_RECV_EVENT_FILENAME*>(msgPtr) };
+    sim._state->dispatchEvent(msg.uEventID, msg.uGroupID, msg.dwData, msg.szFileName);
+}
+
+template <>
+void SimState::handleMessage<SIMCONNECT_RECV_ID_SYSTEM_STATE>(SimConnect& sim, SIMCONNECT_RECV* msgPtr)
+{
+    SIMCONNECT_RECV_SYSTEM_STATE& msg{ *static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msgPtr) };
+    sim._logger.debug("System state received: {} ({})", msg.dwRequestID, msg.dwInteger);
+    sim._state->dispatchRequestData(msg.dwRequestID, msgPtr);
+}
+
+template <>
+void SimState::handleMessage<SIMCONNECT_RECV_ID_SIMOBJECT_DATA>(SimConnect& sim, SIMCONNECT_RECV* msgPtr)
+{
+    SIMCONNECT_RECV_SIMOBJECT_DATA& msg{ *static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA*>(msgPtr) };
+    sim._state->dispatchRequestData(msg.dwRequestID, msgPtr);
+}
+
+
+namespace {
+    using MessageHandler = void (*)(SimConnect& sim, SIMCONNECT_RECV* msgPtr);
+
+    struct MessageSlot {
+        MessageHandler handler{ nullptr };
+        size_t minSize{ sizeof(SIMCONNECT_RECV) };
+    };
+
+    using MessageTable = std::array<MessageSlot, CppSimConnect::MessageStats::messageTypes>;
+
+    template <DWORD Id>
+    constexpr void addHandler(MessageTable& table, size_t minSize) {
+        static_assert(Id < CppSimConnect::MessageStats::messageTypes, "The message ID does not fit the dispatch table.");
+        table[Id] = { &SimState::handleMessage<Id>, minSize };
+    }
+
+    // To handle a new type of message, specialize SimState::handleMessage for it above, and add it here.
+    constexpr MessageTable messageTable{ []() {
+        MessageTable table{};
+        addHandler<SIMCONNECT_RECV_ID_EXCEPTION>(table, sizeof(SIMCONNECT_RECV_EXCEPTION));
+        addHandler<SIMCONNECT_RECV_ID_OPEN>(table, sizeof(SIMCONNECT_RECV_OPEN));
+        addHandler<SIMCONNECT_RECV_ID_QUIT>(table, sizeof(SIMCONNECT_RECV));
+        addHandler<SIMCONNECT_RECV_ID_EVENT>(table, sizeof(SIMCONNECT_RECV_EVENT));
+        addHandler<SIMCONNECT_RECV_ID_EVENT_FILENAME>(table, sizeof(SIMCONNECT_RECV_EVENT_FILENAME));
+        addHandler<SIMCONNECT_RECV_ID_SYSTEM_STATE>(table, sizeof(SIMCONNECT_RECV_SYSTEM_STATE));
+        addHandler<SIMCONNECT_RECV_ID_SIMOBJECT_DATA>(table, simObjectDataHeaderSize);
+        return table;
+    }() };
 }
 
 
@@ -47,42 +121,61 @@ void SimState::cppSimConnect_handleMessage(SIMCONNECT_RECV* msgPtr, DWORD msgLen
         return;
     }
     CppSimConnect::SimConnect& sim{ *static_cast<SimConnect*>(context) };
+    if (sim._recorder) {
+        sim._recorder->record(msgPtr, msgLen);
+    }
     if (!sim._state) {
         sim._logger.error("Received message from simulator but we have no valid connection.");
         return;
     }
+    SimState& state{ *sim._state };
+    const DWORD id{ msgPtr->dwID };
 
-    switch (msgPtr->dwID) {
-
-    case SIMCONNECT_RECV_ID_EXCEPTION:
-    {
-        SIMCONNECT_RECV_EXCEPTION& msg{ *static_cast<SIMCONNECT_RECV_EXCEPTION*>(msgPtr) };
-        sim._state->onExcept(msg.dwSendID, msg.dwException, msg.dwIndex);
+    if (id >= messageTable.size()) {
+        state._messagesUnhandled.fetch_add(1, std::memory_order_relaxed);
+        sim._logger.debug("Ignoring message type {}.", id);
+        return;
+    }
+    // Only this thread writes the counter, so there is no need for an atomic increment.
+    auto& received{ state._messagesReceived[id] };
+    const std::uint64_t count{ received.load(std::memory_order_relaxed) };
+    received.store(count + 1, std::memory_order_relaxed);
+
+    const MessageSlot& slot{ messageTable[id] };
+    if (slot.handler == nullptr) {
+        state._messagesUnhandled.fetch_add(1, std::memory_order_relaxed);
+        if (count == 0) {
+            sim._logger.warn("No handler for message type {}, ignoring these.", id);
+        }
+        return;
     }
-    break;
-
-    case SIMCONNECT_RECV_ID_OPEN:
-    {
-        auto msg = *static_cast<SIMCONNECT_RECV_OPEN*>(msgPtr);
-        copyAppInfo(sim._appInfo, msg);
-        sim._logger.info("Connected to '{}'", sim._appInfo.appName);
-        sim.notifyOpen();
+    if ((msgLen < slot.minSize) || (msgPtr->dwSize < slot.minSize)) {
+        state._messagesUndersized.fetch_add(1, std::memory_order_relaxed);
+        sim._logger.warn("Ignoring message of type {} with {} bytes, where at least {} are needed.", id, msgLen, slot.minSize);
+        return;
     }
-    break;
-
-    case SIMCONNECT_RECV_ID_QUIT:
-        sim.notifyClose();
-        break;
-
-    case SIMCONNECT_RECV_ID_SYSTEM_STATE:
-    {
-        SIMCONNECT_RECV_SYSTEM_STATE& msg{ *static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msgPtr) };
-        sim._logger.debug("System state received: {} ({})", msg.dwRequestID, msg.dwInteger);
-        sim._state->dispatchRequestData(msg.dwRequestID, msgPtr);
+    if (msgPtr->dwSize > msgLen) {     // Handlers trust dwSize for the length of what follows the fixed part
+        state._messagesUndersized.fetch_add(1, std::memory_order_relaxed);
+        sim._logger.warn("Ignoring message of type {} with {} bytes, where its header claims {}.", id, msgLen, msgPtr->dwSize);
+        return;
     }
-    break;
-
-    default:
-        sim._logger.warn("Unknown message type {}", msgPtr->dwID);
+    if (state._timing) {
+        const auto start{ DispatchTiming::Clock::now() };
+        slot.handler(sim, msgPtr);
+        state._timing->handled(id, start);
+    }
+    else {
+        slot.handler(sim, msgPtr);
     }
 }
+
+CppSimConnect::MessageStats SimState::messageStats() const noexcept
+{
+    MessageStats stats;
+    for (size_t id = 0; id < stats.received.size(); id++) {
+        stats.received[id] = _messagesReceived[id].load(std::memory_order_relaxed);
+    }
+    stats.unhandled = _messagesUnhandled.load(std::memory_order_relaxed);
+    stats.undersized = _messagesUndersized.load(std::memory_order_relaxed);
+    return stats;
+}
\ No newline at end of file
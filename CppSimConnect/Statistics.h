@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2022. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <map>
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>Counters for the correlation of simulator exceptions with the calls that caused them.</summary>
+	 */
+	struct ExceptionStats {
+		std::uint64_t matched{ 0 };		// Delivered to the handler of the call
+		std::uint64_t unmatched{ 0 };	// Arrived while no handler was known for the SendID
+		std::uint64_t dropped{ 0 };		// Unmatched, and discarded because they got too old or were overwritten
+	};
+
+	/**
+	 * <summary>Counters for system-state requests.</summary>
+	 */
+	struct RequestStats {
+		std::uint64_t systemStatesSent{ 0 };		// Requests actually sent to the simulator
+		std::uint64_t systemStatesCoalesced{ 0 };	// Requests that joined one already in flight, saving a round trip
+		std::uint64_t systemStatesCached{ 0 };		// Requests answered from the cache
+	};
+
+	/**
+	 * <summary>Counters for a stream, summed over its buffered subscribers.</summary>
+	 */
+	struct StreamStats {
+		std::uint64_t published{ 0 };	// Values offered to subscriber buffers
+		std::uint64_t delivered{ 0 };	// Values passed to subscribers
+		std::uint64_t dropped{ 0 };		// Values discarded by the overflow policy
+		std::uint64_t depth{ 0 };		// Values currently waiting in buffers
+		std::uint64_t maxDepth{ 0 };	// The highest depth seen in any single buffer
+	};
+
+	/**
+	 * <summary>Counters for asynchronous logging.</summary>
+	 */
+	struct LogStats {
+		std::uint64_t written{ 0 };		// Messages passed to the sink
+		std::uint64_t dropped{ 0 };		// Messages lost to the overflow policy
+		std::uint64_t queued{ 0 };		// Messages waiting for the sink thread
+	};
+
+	/**
+	 * <summary>Counters for received messages, per message type.</summary>
+	 */
+	struct MessageStats {
+		static constexpr size_t messageTypes{ 64 };		// Message IDs (dwID) below this are counted per type
+
+		std::array<std::uint64_t, messageTypes> received{};	// By message ID
+		std::uint64_t unhandled{ 0 };		// Of a type we have no handler for, including IDs beyond the table
+		std::uint64_t undersized{ 0 };		// Shorter than their type requires or their dwSize claims, and so not handled
+	};
+
+	/**
+	 * <summary>A histogram with logarithmic buckets, each split linearly into sub-buckets, as in HdrHistogram.</summary>
+	 *
+	 * Values below <c>subBuckets</c> are counted exactly. Above that a value lands in a bucket at most 1/8th of
+	 * its size wide, so percentiles are accurate to within 12.5% over the whole range up to 2^40.
+	 */
+	struct HistogramSnapshot {
+		static constexpr unsigned subBucketBits{ 3 };
+		static constexpr std::uint64_t subBuckets{ 1u << subBucketBits };
+		static constexpr unsigned maxExponent{ 39 };	// Larger values are counted in the last bucket
+		static constexpr size_t bucketCount{ (maxExponent - subBucketBits + 2) * subBuckets };
+
+		std::array<std::uint64_t, bucketCount> buckets{};
+		std::uint64_t count{ 0 };
+		std::uint64_t sum{ 0 };
+		std::uint64_t min{ 0 };
+		std::uint64_t max{ 0 };
+
+		static constexpr size_t bucketOf(std::uint64_t value) noexcept {
+			if (value < subBuckets) {
+				return static_cast<size_t>(value);
+			}
+			const unsigned exponent{ static_cast<unsigned>(std::bit_width(value)) - 1 };
+			if (exponent > maxExponent) {
+				return bucketCount - 1;
+			}
+			return (exponent - subBucketBits + 1) * subBuckets + ((value >> (exponent - subBucketBits)) & (subBuckets - 1));
+		}
+
+		/** <summary>The smallest value counted in the bucket.</summary> */
+		static constexpr std::uint64_t lowestValueOf(size_t bucket) noexcept {
+			if (bucket < subBuckets) {
+				return bucket;
+			}
+			const unsigned exponent{ static_cast<unsigned>(bucket / subBuckets) + subBucketBits - 1 };
+			return (subBuckets + (bucket % subBuckets)) << (exponent - subBucketBits);
+		}
+
+		/** <summary>The value below which the given percentage of the recorded values fall, as the highest value of its bucket.</summary> */
+		std::uint64_t percentile(double p) const noexcept {
+			if (count == 0) {
+				return 0;
+			}
+			const auto rank{ std::max<std::uint64_t>(1, static_cast<std::uint64_t>(p * static_cast<double>(count) / 100.0 + 0.5)) };
+			std::uint64_t seen{ 0 };
+			for (size_t bucket = 0; bucket < bucketCount; bucket++) {
+				seen += buckets[bucket];
+				if (seen >= rank) {
+					const std::uint64_t highest{ (bucket + 1 < bucketCount) ? lowestValueOf(bucket + 1) - 1 : max };
+					return std::clamp(highest, min, max);
+				}
+			}
+			return max;
+		}
+
+		inline double mean() const noexcept { return (count == 0) ? 0.0 : static_cast<double>(sum) / static_cast<double>(count); }
+	};
+
+	/**
+	 * <summary>The kinds of request whose round trips are timed.</summary>
+	 */
+	enum class RequestKind {
+		SystemState,	// A single system state
+		Data,			// A single SimObject data request
+		Subscription,	// Periodic SimObject data, up to its first update
+	};
+	inline constexpr size_t requestKinds{ 3 };
+
+	/**
+	 * <summary>Timings of the dispatcher. Durations are in nanoseconds.</summary>
+	 */
+	struct TimingStats {
+		std::array<HistogramSnapshot, requestKinds> roundTrip{};		// From sending a request to its first reply, by RequestKind
+		std::map<std::uint32_t, HistogramSnapshot> handling;			// Time spent handling a message, by message ID (dwID), for the types seen
+		HistogramSnapshot drainBatch{};			// The number of messages handled per drain of the queue, for drains that found any
+		HistogramSnapshot subscriberCallback{};	// Time taken delivering a reply, divided over the request's subscribers
+	};
+}
\ No newline at end of file
@@ -16,14 +16,83 @@
 
 #include "../pch.h"
 
+#include <algorithm>
+
 #include "ClientEvent.h"
 
+#include "../sim/SimState.h"
 
-using CppSimConnect::ClientEvent;
 
-/*
-std::mutex ClientEvent::_eventLock;
-ClientEvent::EventID ClientEvent::_nextID{ 0 };
-std::vector<std::string> ClientEvent::_names;
-std::map<std::string, ClientEvent::EventID> ClientEvent::_ids;
-*/
\ No newline at end of file
+using CppSimConnect::ClientEventErrorHandler;
+using CppSimConnect::ClientEventHandler;
+using CppSimConnect::ClientEventSet;
+using CppSimConnect::EventID;
+using CppSimConnect::RegisteredEventSet;
+using CppSimConnect::SimConnect;
+
+
+ClientEventSet& ClientEventSet::map(std::string name)
+{
+    _events.push_back({ std::move(name), false, false, GroupPriority::Default, nullptr });
+    return *this;
+}
+
+ClientEventSet& ClientEventSet::notify(std::string name, ClientEventHandler handler, std::uint32_t priority, bool maskable)
+{
+    _events.push_back({ std::move(name), true, maskable, priority, std::move(handler) });
+    return *this;
+}
+
+ClientEventSet& ClientEventSet::onError(ClientEventErrorHandler handler)
+{
+    _onError = std::move(handler);
+    return *this;
+}
+
+
+void SimConnect::addClientEvents(ClientEventSet events)
+{
+    auto set = std::make_unique<RegisteredEventSet>();
+    set->events = std::move(events);
+    const auto& list{ set->events.events() };
+    set->ids.reserve(list.size());
+    set->mapping.reserve(list.size());
+    set->groupOf.reserve(list.size());
+
+    std::lock_guard lock(_clientEventLock);
+    for (const auto& event : list) {
+        const EventID id{ _events.eventID(event.name) };
+        if (id >= _mappedEvents.size()) {
+            _mappedEvents.resize(id + 1, false);
+        }
+        set->ids.push_back(id);
+        set->mapping.push_back(!_mappedEvents[id]);
+        _mappedEvents[id] = true;
+
+        GroupID groupId{ 0 };
+        if (event.notify) {
+            auto group = std::find_if(set->groups.begin(), set->groups.end(), [&event](const auto& g) { return g.priority == event.priority; });
+            if (group == set->groups.end()) {
+                set->groups.push_back({ _events.nextGroupID(), event.priority });
+                group = std::prev(set->groups.end());
+            }
+            groupId = group->id;
+        }
+        set->groupOf.push_back(groupId);
+    }
+    _logger.debug("Added {} client event(s) in {} notification group(s).", list.size(), set->groups.size());
+
+    if (_state) {
+        _state->registerClientEvents(*set);
+    }
+    _clientEventSets.push_back(std::move(set));
+}
+
+void SimConnect::simActivateState(std::unique_ptr<SimState> state)
+{
+    std::lock_guard lock(_clientEventLock);
+    for (const auto& set : _clientEventSets) {
+        state->registerClientEvents(*set);
+    }
+    _state = std::move(state);
+}
\ No newline at end of file
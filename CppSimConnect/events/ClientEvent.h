@@ -16,38 +16,114 @@
 
 #pragma once
 
-#include <atomic>
-#include <map>
-#include <mutex>
+#include <cstdint>
+#include <exception>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "../EventManager.h"
 
 namespace CppSimConnect {
 
+	/**
+	 * <summary>A client event, known by its name and the ID it has on a connection.</summary>
+	 */
 	class ClientEvent {
+		EventID _id;
+		std::string_view _name;
+
 	public:
-		using EventID = unsigned int;
+		ClientEvent(EventManager& events, std::string_view name) : _id{ events.eventID(name) }, _name{ events.name(_id) } {}
+		ClientEvent(EventManager& events, EventName name) : _id{ events.eventID(name) }, _name{ events.name(_id) } {}
 
-	private:
+		ClientEvent(const ClientEvent&) = default;
+		~ClientEvent() = default;
+		ClientEvent& operator=(const ClientEvent&) = default;
 
-		std::weak_ptr<EventManager> _api;
-		EventID _id;
-		std::string _name;
+		inline EventID id() const noexcept { return _id; }
+		inline std::string_view name() const noexcept { return _name; }
+	};
 
-		ClientEvent(ClientEvent&&) = delete;
-		ClientEvent& operator=(ClientEvent&&) = delete;
+	/**
+	 * <summary>The notification group priorities SimConnect defines. Groups with a lower number hear of events first.</summary>
+	 */
+	namespace GroupPriority {
+		constexpr std::uint32_t Highest{ 1 };
+		constexpr std::uint32_t HighestMaskable{ 10000000 };
+		constexpr std::uint32_t Standard{ 1900000000 };
+		constexpr std::uint32_t Default{ 2000000000 };
+		constexpr std::uint32_t Lowest{ 4000000000 };
+	}
 
+	using ClientEventHandler = std::function<void(std::uint32_t data)>;
+	using ClientEventErrorHandler = std::function<void(std::string_view eventName, std::exception_ptr err)>;
+
+	/**
+	 * <summary>A list of client events to map to simulator events, and optionally be notified of.</summary>
+	 *
+	 * Give it to SimConnect::addClientEvents() or the Builder, and all of it is sent each time a connection
+	 * opens, in one go, without waiting for replies. Events to be notified of are put in one notification
+	 * group per priority. Exceptions the simulator reports come back later, to the error handler.
+	 */
+	class ClientEventSet {
 	public:
-//		ClientEvent(std::string eventName) : _name{ _name }, _id{ eventID(eventName) } {}
-//		ClientEvent(std::weak_ptr<SimConnect> api, std::string eventName) : _api{ api }, _id { eventID(eventName) } {}
-//
-//		ClientEvent(const ClientEvent& event) = default;
-//		~ClientEvent() = default;
-//		ClientEvent& operator=(const ClientEvent&) = default;
-//
-//		inline EventID id() const noexcept { return _id; }
-//		inline const std::string& name() const noexcept { return EventManager::_names.at(_id); }
+		struct Event {
+			std::string name;
+			bool notify{ false };
+			bool maskable{ false };
+			std::uint32_t priority{ GroupPriority::Default };
+			ClientEventHandler handler;
+		};
+
+	private:
+		std::vector<Event> _events;
+		ClientEventErrorHandler _onError;
+
+	public:
+		ClientEventSet() = default;
+		~ClientEventSet() = default;
+		ClientEventSet(const ClientEventSet&) = default;
+		ClientEventSet(ClientEventSet&&) = default;
+		ClientEventSet& operator=(const ClientEventSet&) = default;
+		ClientEventSet& operator=(ClientEventSet&&) = default;
+
+		/**
+		 * <summary>Map the event, so it can be sent to the simulator, but don't ask to be notified of it.</summary>
+		 */
+		ClientEventSet& map(std::string name);
+
+		/**
+		 * <summary>Map the event, and call <c>handler</c> on the dispatcher thread when the simulator sends it.</summary>
+		 * A maskable event is not passed on to groups of lower priority, or to the simulator itself.
+		 */
+		ClientEventSet& notify(std::string name, ClientEventHandler handler, std::uint32_t priority = GroupPriority::Standard, bool maskable = false);
+
+		/**
+		 * <summary>Called on the dispatcher thread for each exception the simulator reports on this set.</summary>
+		 */
+		ClientEventSet& onError(ClientEventErrorHandler handler);
+
+		inline const std::vector<Event>& events() const noexcept { return _events; }
+		inline const ClientEventErrorHandler& errorHandler() const noexcept { return _onError; }
+		inline size_t size() const noexcept { return _events.size(); }
+		inline bool empty() const noexcept { return _events.empty(); }
+	};
+
+	/**
+	 * <summary>A ClientEventSet with the IDs it got on a SimConnect client. These don't change between connections.</summary>
+	 */
+	struct RegisteredEventSet {
+		struct Group {
+			GroupID id;
+			std::uint32_t priority;
+		};
+
+		ClientEventSet events;
+		std::vector<EventID> ids;			// By position in the set
+		std::vector<bool> mapping;			// False where an earlier event already mapped the same ID
+		std::vector<GroupID> groupOf;		// By position in the set, for events to be notified of
+		std::vector<Group> groups;
 	};
-}
\ No newline at end of file
+}
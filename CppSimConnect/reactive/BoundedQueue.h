@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+
+namespace CppSimConnect {
+	namespace Reactive {
+
+		/**
+		 * <summary>A fixed-size lock-free queue for any number of producers and consumers.</summary>
+		 *
+		 * Every cell carries a sequence number that tells producers and consumers whose turn it is, so pushing
+		 * and popping each take a single compare-and-swap on their own index. The capacity is rounded up to a
+		 * power of two, with a minimum of two. Values must be default-constructible and move-assignable.
+		 */
+		template <typename T>
+		class BoundedQueue {
+			struct Cell {
+				std::atomic<size_t> sequence;
+				T value{};
+			};
+
+			static constexpr size_t cacheLine{ 64 };
+
+			std::unique_ptr<Cell[]> _cells;
+			size_t _mask;
+			alignas(cacheLine) std::atomic<size_t> _enqueuePos{ 0 };
+			alignas(cacheLine) std::atomic<size_t> _dequeuePos{ 0 };
+
+		public:
+			explicit BoundedQueue(size_t capacity) :
+				_cells(std::make_unique<Cell[]>(std::bit_ceil(std::max<size_t>(capacity, 2)))),
+				_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+			{
+				for (size_t i = 0; i <= _mask; i++) {
+					_cells[i].sequence.store(i, std::memory_order_relaxed);
+				}
+			}
+			~BoundedQueue() = default;
+			BoundedQueue(const BoundedQueue<T>&) = delete;
+			BoundedQueue(BoundedQueue<T>&&) = delete;
+			BoundedQueue<T>& operator=(const BoundedQueue<T>&) = delete;
+			BoundedQueue<T>& operator=(BoundedQueue<T>&&) = delete;
+
+			inline size_t capacity() const noexcept { return _mask + 1; }
+
+			// Only exact while nobody pushes or pops.
+			inline size_t size() const noexcept {
+				const size_t dequeued{ _dequeuePos.load(std::memory_order_acquire) };
+				const size_t enqueued{ _enqueuePos.load(std::memory_order_acquire) };
+				return (enqueued > dequeued) ? std::min(enqueued - dequeued, capacity()) : 0;
+			}
+			inline bool empty() const noexcept { return size() == 0; }
+
+			template <typename U>
+			bool tryPush(U&& value) {
+				size_t pos{ _enqueuePos.load(std::memory_order_relaxed) };
+				for (;;) {
+					Cell& cell{ _cells[pos & _mask] };
+					const size_t sequence{ cell.sequence.load(std::memory_order_acquire) };
+					const auto diff{ static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos) };
+					if (diff == 0) {
+						if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+							cell.value = std::forward<U>(value);
+							cell.sequence.store(pos + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (diff < 0) {
+						return false;	// Full
+					}
+					else {
+						pos = _enqueuePos.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+			bool tryPop(T& value) {
+				size_t pos{ _dequeuePos.load(std::memory_order_relaxed) };
+				for (;;) {
+					Cell& cell{ _cells[pos & _mask] };
+					const size_t sequence{ cell.sequence.load(std::memory_order_acquire) };
+					const auto diff{ static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1) };
+					if (diff == 0) {
+						if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+							value = std::move(cell.value);
+							cell.sequence.store(pos + _mask + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if (diff < 0) {
+						return false;	// Empty
+					}
+					else {
+						pos = _dequeuePos.load(std::memory_order_relaxed);
+					}
+				}
+			}
+		};
+	}
+}
\ No newline at end of file
@@ -16,45 +16,84 @@
 
 #pragma once
 
-#include <functional>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
-#include <set>
+
+#include "Epoch.h"
+#include "InplaceFunction.h"
 
 namespace CppSimConnect {
 
+	/**
+	 * <summary>A vector that keeps its first element inline, as most callback lists only ever get one.</summary>
+	 */
+	template <typename T>
+	class CallbackStorage {
+		T _first;
+		std::vector<T> _more;
+		size_t _size{ 0 };
+
+	public:
+		CallbackStorage() = default;
+		~CallbackStorage() = default;
+		CallbackStorage(CallbackStorage<T>&&) = default;
+		CallbackStorage(const CallbackStorage<T>&) = delete;
+		CallbackStorage<T>& operator=(CallbackStorage<T>&&) = default;
+		CallbackStorage<T>& operator=(const CallbackStorage<T>&) = delete;
+
+		inline size_t size() const noexcept { return _size; }
+		inline void reserve(size_t count) { if (count > 1) { _more.reserve(count - 1); } }
+
+		inline void push_back(T&& value) {
+			if (_size == 0) {
+				_first = std::move(value);
+			}
+			else {
+				_more.push_back(std::move(value));
+			}
+			_size++;
+		}
+
+		inline const T& operator[](size_t index) const noexcept { return (index == 0) ? _first : _more[index - 1]; }
+		inline T& operator[](size_t index) noexcept { return (index == 0) ? _first : _more[index - 1]; }
+	};
+
 	/**
 	 * <summary></summary>
 	 */
 	template <typename... Tparm>
 	class CallbackList {
 	public:
-		using Callback = std::function<void(Tparm...)>;
-		using CallbackVector = std::vector<Callback>;
+		using Callback = InplaceFunction<void(Tparm...)>;
+		using CallbackVector = CallbackStorage<Callback>;
 
 		CallbackList() = default;
 		~CallbackList() = default;
 		CallbackList(CallbackList<Tparm...>&&) = default;
-		CallbackList(const CallbackList<Tparm...>&) = default;
+		CallbackList(const CallbackList<Tparm...>&) = delete;
 		CallbackList<Tparm...>& operator=(CallbackList<Tparm...>&&) = default;
-		CallbackList<Tparm...>& operator=(const CallbackList<Tparm...>&) = default;
+		CallbackList<Tparm...>& operator=(const CallbackList<Tparm...>&) = delete;
 
 	private:
 		CallbackVector _callbacks;
 
 	public:
 		inline auto size() const noexcept { return _callbacks.size(); }
-		inline void add(Callback cb) { _callbacks.emplace_back(cb); }
-		inline void operator+=(Callback cb) { _callbacks.emplace_back(cb); }
-		inline void operator+=(const CallbackList<Tparm...>& other) {
-			for (const auto& cb : other._callbacks) {
-				_callbacks.push_back(cb);
+		inline void reserve(size_t count) { _callbacks.reserve(count); }
+		inline void add(Callback cb) { _callbacks.push_back(std::move(cb)); }
+		inline void operator+=(Callback cb) { _callbacks.push_back(std::move(cb)); }
+		inline void operator+=(CallbackList<Tparm...>&& other) {
+			for (size_t i = 0; i < other._callbacks.size(); i++) {
+				_callbacks.push_back(std::move(other._callbacks[i]));
 			}
+			other._callbacks = CallbackVector();
 		}
 		inline void operator()(Tparm... parms) {
-			for (const auto& cb : _callbacks)
+			for (size_t i = 0; i < _callbacks.size(); i++)
 			{
-				cb(parms...);
+				_callbacks[i](parms...);
 			}
 		}
 	};
@@ -69,20 +108,21 @@ namespace CppSimConnect {
 	template <typename... Tparm>
 	class ShortcutCallbackList {
 	public:
-		using Callback = std::function<CallbackResult(Tparm...)>;
-		using CallbackVector = std::vector<Callback>;
+		using Callback = InplaceFunction<CallbackResult(Tparm...)>;
+		using CallbackVector = CallbackStorage<Callback>;
 
 	private:
 		CallbackVector _callbacks;
 
 	public:
 		inline auto size() const noexcept { return _callbacks.size(); }
-		inline void add(Callback cb) { _callbacks.emplace_back(cb); }
-		inline void operator+=(Callback cb) { _callbacks.emplace_back(cb); }
+		inline void reserve(size_t count) { _callbacks.reserve(count); }
+		inline void add(Callback cb) { _callbacks.push_back(std::move(cb)); }
+		inline void operator+=(Callback cb) { _callbacks.push_back(std::move(cb)); }
 		inline CallbackResult operator()(Tparm... parms) {
-			for (const Callback& cb : _callbacks)
+			for (size_t i = 0; i < _callbacks.size(); i++)
 			{
-				switch (cb(parms...)) {
+				switch (_callbacks[i](parms...)) {
 				case CallbackResult::Abort:
 				case CallbackResult::AbortDone:
 					return CallbackResult::Abort;
@@ -92,49 +132,127 @@ namespace CppSimConnect {
 		}
 	};
 
+	/**
+	 * <summary>A list of callbacks that is replaced as a whole whenever a callback is added or removed.</summary>
+	 *
+	 * Each version of the list is immutable, so invoking only needs to load the current version inside an
+	 * EpochDomain::ReadGuard, and never copies the list, takes a lock, or touches a reference count that
+	 * other readers share. Callbacks may add or remove callbacks while being invoked.
+	 * Writers serialize among themselves, publish a new version, and retire the old one, which is deleted
+	 * once no invocation can still be working on it. A removed callback is flagged at once, so invocations
+	 * still working on an older version skip it.
+	 */
+	template <typename Callback>
+	class CallbackSnapshots {
+	public:
+		struct Entry {
+			unsigned id;
+			Callback callback;
+			mutable std::atomic_bool removed{ false };
+
+			Entry(unsigned entryId, Callback&& cb) : id(entryId), callback(std::move(cb)) {}
+		};
+		using Snapshot = std::vector<std::shared_ptr<const Entry>>;
+
+	private:
+		EpochPtr<const Snapshot> _current;	// nullptr while empty
+		std::atomic_uint _nextId{ 0 };
+		std::mutex _writeMutex;
+
+		template <typename Edit>
+		void publish(Edit&& edit) {
+			std::lock_guard<std::mutex> lock(_writeMutex);
+
+			auto current = _current.load();		// Only writers retire it, and we hold the write lock
+			auto next = current ? std::make_unique<Snapshot>(*current) : std::make_unique<Snapshot>();
+			edit(*next);
+			_current.store(next->empty() ? nullptr : std::unique_ptr<const Snapshot>(std::move(next)));
+		}
+
+	public:
+		CallbackSnapshots() = default;
+		~CallbackSnapshots() = default;
+		CallbackSnapshots(CallbackSnapshots<Callback>&&) = delete;
+		CallbackSnapshots(const CallbackSnapshots<Callback>&) = delete;
+		CallbackSnapshots<Callback>& operator=(CallbackSnapshots<Callback>&&) = delete;
+		CallbackSnapshots<Callback>& operator=(const CallbackSnapshots<Callback>&) = delete;
+
+		/**
+		 * <summary>The current version, or nullptr if there are no callbacks. Only valid while the caller holds
+		 * an EpochDomain::ReadGuard.</summary>
+		 */
+		inline const Snapshot* snapshot() const noexcept { return _current.load(); }
+		inline size_t size() const noexcept {
+			EpochDomain::ReadGuard guard;
+			auto current = snapshot();
+			return current ? current->size() : 0;
+		}
+
+		unsigned add(Callback&& cb) {
+			auto id = _nextId++;
+			auto entry = std::make_shared<const Entry>(id, std::move(cb));
+			publish([&entry](Snapshot& callbacks) { callbacks.push_back(std::move(entry)); });
+			return id;
+		}
+
+		void remove(unsigned id) {
+			publish([id](Snapshot& callbacks) {
+				std::erase_if(callbacks, [id](const auto& entry) {
+					if (entry->id != id) {
+						return false;
+					}
+					entry->removed = true;
+					return true;
+				});
+			});
+		}
+
+		/**
+		 * <summary>Drop all callbacks that were flagged as removed during an invocation.</summary>
+		 */
+		void purge() {
+			publish([](Snapshot& callbacks) { std::erase_if(callbacks, [](const auto& entry) { return entry->removed.load(); }); });
+		}
+	};
+
 	template <typename... Tparm>
 	class CleanableCallbackList {
 	public:
-		using Callback = std::function<CallbackResult(Tparm...)>;
-		using CallbackVector = std::vector<std::pair<unsigned, Callback>>;
+		using Callback = InplaceFunction<CallbackResult(Tparm...)>;
+		using CallbackVector = CallbackSnapshots<Callback>;
 
 	private:
 		CallbackVector _callbacks;
-		std::atomic_uint _nextId{ 0 };
-		std::mutex _mutex;
 
 	public:
 		inline auto size() const noexcept { return _callbacks.size(); }
-		inline unsigned add(Callback cb) { auto id = _nextId++; _callbacks.emplace_back(id, cb); return id; }
-		inline void operator+=(Callback cb) { auto id = _nextId++; _callbacks.emplace_back(id, cb); }
-		inline void operator-=(unsigned id) {
-			std::lock_guard<std::mutex> lock(_mutex);
-			auto end = std::remove_if(_callbacks.begin(), _callbacks.end(), [id](const auto& it) { return id == it.first; });
-			_callbacks.erase(end, _callbacks.end());
-		}
+		inline unsigned add(Callback cb) { return _callbacks.add(std::move(cb)); }
+		inline void operator+=(Callback cb) { _callbacks.add(std::move(cb)); }
+		inline void operator-=(unsigned id) { _callbacks.remove(id); }
 		CallbackResult operator()(Tparm... parms) {
 			CallbackResult result{ CallbackResult::Ok };
 
-			CallbackVector callbacks(_callbacks.size());
-			{
-				std::lock_guard<std::mutex> lock(_mutex);
-				callbacks = _callbacks;
+			EpochDomain::ReadGuard guard;
+			auto callbacks = _callbacks.snapshot();
+			if (!callbacks) {
+				return result;
 			}
-			std::set<unsigned> idsToGo;
-			for (auto pair : callbacks)
+			bool purge{ false };
+			for (const auto& entry : *callbacks)
 			{
-				switch (pair.second(parms...)) {
+				if (entry->removed) {
+					continue;
+				}
+				switch (entry->callback(parms...)) {
 				case CallbackResult::Done:
 				case CallbackResult::AbortDone:
-					idsToGo.emplace(pair.first);
+					purge |= !entry->removed.exchange(true);
 					result = CallbackResult::Done;
 					break;
 				}
 			}
-			{
-				std::lock_guard<std::mutex> lock(_mutex);
-				auto end = std::remove_if(_callbacks.begin(), _callbacks.end(), [&idsToGo](const auto& it) { return idsToGo.contains(it.first); });
-				_callbacks.erase(end, _callbacks.end());
+			if (purge) {
+				_callbacks.purge();
 			}
 			return result;
 		}
@@ -143,43 +261,40 @@ namespace CppSimConnect {
 	template <typename... Tparm>
 	class CleanableShortcutCallbackList {
 	public:
-		using Callback = std::function<CallbackResult(Tparm...)>;
-		using CallbackVector = std::vector<std::pair<unsigned, Callback>>;
+		using Callback = InplaceFunction<CallbackResult(Tparm...)>;
+		using CallbackVector = CallbackSnapshots<Callback>;
 
 	private:
 		CallbackVector _callbacks;
-		std::atomic_uint _nextId{ 0 };
-		std::mutex _mutex;
 
 	public:
 		inline auto size() const noexcept { return _callbacks.size(); }
-		inline unsigned add(Callback cb) { auto id = _nextId++; _callbacks.emplace_back(id, cb); return id; }
-		inline void operator+=(Callback cb) { auto id = _nextId++; _callbacks.emplace_back(id, cb); }
-		inline void operator-=(unsigned id) {
-			std::lock_guard<std::mutex> lock(_mutex);
-			auto end = std::remove_if(_callbacks.begin(), _callbacks.end(), [id](const auto& it) { return id == it.first; });
-			_callbacks.erase(end, _callbacks.end());
-		}
+		inline unsigned add(Callback cb) { return _callbacks.add(std::move(cb)); }
+		inline void operator+=(Callback cb) { _callbacks.add(std::move(cb)); }
+		inline void operator-=(unsigned id) { _callbacks.remove(id); }
 		CallbackResult operator()(Tparm... parms) {
 			CallbackResult result{ CallbackResult::Ok };
 
-			CallbackVector callbacks(_callbacks.size());
-			{
-				std::lock_guard<std::mutex> lock(_mutex);
-				callbacks = _callbacks;
+			EpochDomain::ReadGuard guard;
+			auto callbacks = _callbacks.snapshot();
+			if (!callbacks) {
+				return result;
 			}
-			std::set<unsigned> idsToGo;
-			for (auto pair : callbacks)
+			bool purge{ false };
+			for (const auto& entry : *callbacks)
 			{
+				if (entry->removed) {
+					continue;
+				}
 				bool abort = false;
-				switch (pair.second(parms...)) {
+				switch (entry->callback(parms...)) {
 				case CallbackResult::Done:
-					idsToGo.emplace(pair.first);
+					purge |= !entry->removed.exchange(true);
 					result = CallbackResult::Done;
 					break;
 
 				case CallbackResult::AbortDone:
-					idsToGo.emplace(pair.first);
+					purge |= !entry->removed.exchange(true);
 					result = CallbackResult::AbortDone;
 					abort = true;
 					break;
@@ -193,10 +308,8 @@ namespace CppSimConnect {
 					break;
 				}
 			}
-			{
-				std::lock_guard<std::mutex> lock(_mutex);
-				auto end = std::remove_if(_callbacks.begin(), _callbacks.end(), [&idsToGo](const auto& it) { return idsToGo.contains(it.first); });
-				_callbacks.erase(end, _callbacks.end());
+			if (purge) {
+				_callbacks.purge();
 			}
 			return result;
 		}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>Epoch-based reclamation: readers use shared objects without locks or reference counts, while
+	 * writers replace them and retire the old versions.</summary>
+	 *
+	 * A reader announces the epoch it started in, and an object retired in some epoch is only deleted once every
+	 * reader still inside a read section started after that. Entering and leaving a read section only touch the
+	 * reading thread's own record, so reads are lock-free and don't contend with each other. Read sections nest,
+	 * so a callback run from one may read again, or retire objects. Retired objects are deleted by the next
+	 * retire() that finds no reader can still see them.
+	 */
+	class EpochDomain {
+		static constexpr std::uint64_t idle{ std::numeric_limits<std::uint64_t>::max() };
+
+		struct alignas(64) Record {
+			std::atomic<std::uint64_t> epoch{ idle };
+			std::atomic_bool inUse{ true };
+			unsigned nesting{ 0 };		// Only used by the thread holding the record
+			Record* next{ nullptr };
+		};
+
+		struct Retired {
+			std::uint64_t epoch;
+			void* ptr;
+			void (*deleter)(void*);
+		};
+
+		std::atomic<std::uint64_t> _epoch{ 0 };
+		std::atomic<Record*> _records{ nullptr };		// Records are handed to later threads, and never freed
+		std::mutex _retiredLock;
+		std::vector<Retired> _retired;
+
+		EpochDomain() = default;
+
+		Record* acquire() {
+			for (Record* record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+				if (!record->inUse.load(std::memory_order_relaxed) && !record->inUse.exchange(true, std::memory_order_acquire)) {
+					return record;
+				}
+			}
+			Record* record{ new Record() };
+			record->next = _records.load(std::memory_order_relaxed);
+			while (!_records.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) {}
+			return record;
+		}
+
+		// A thread keeps its record until it ends.
+		class Registration {
+			Record* _record;
+
+		public:
+			Registration() : _record(instance().acquire()) {}
+			~Registration() {
+				_record->epoch.store(idle, std::memory_order_release);
+				_record->inUse.store(false, std::memory_order_release);
+			}
+			Registration(const Registration&) = delete;
+			Registration& operator=(const Registration&) = delete;
+
+			inline Record& record() noexcept { return *_record; }
+		};
+
+		static inline Record& local() {
+			thread_local Registration registration;
+			return registration.record();
+		}
+
+		std::uint64_t oldestReader() const noexcept {
+			std::uint64_t oldest{ idle };
+			for (Record* record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+				oldest = std::min(oldest, record->epoch.load(std::memory_order_seq_cst));
+			}
+			return oldest;
+		}
+
+	public:
+		~EpochDomain() = delete;
+		EpochDomain(EpochDomain&&) = delete;
+		EpochDomain(const EpochDomain&) = delete;
+		EpochDomain& operator=(EpochDomain&&) = delete;
+		EpochDomain& operator=(const EpochDomain&) = delete;
+
+		// Never destroyed, as other threads may still be reading while the program exits.
+		static EpochDomain& instance() {
+			static EpochDomain* domain{ new EpochDomain() };
+			return *domain;
+		}
+
+		/**
+		 * <summary>Marks a read section. Objects read through an EpochPtr stay valid until it is destroyed.</summary>
+		 */
+		class ReadGuard {
+			Record& _record;
+
+		public:
+			ReadGuard() : _record(local()) {
+				if (_record.nesting++ == 0) {
+					_record.epoch.store(instance()._epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+				}
+			}
+			~ReadGuard() {
+				if (--_record.nesting == 0) {
+					_record.epoch.store(idle, std::memory_order_release);
+				}
+			}
+			ReadGuard(const ReadGuard&) = delete;
+			ReadGuard& operator=(const ReadGuard&) = delete;
+		};
+
+		/**
+		 * <summary>Delete an object once no reader can see it any more. It must already be unreachable for new readers.</summary>
+		 *
+		 * The deleters are called outside our lock, so they may retire objects themselves.
+		 */
+		void retire(void* ptr, void (*deleter)(void*)) {
+			std::vector<Retired> unreachable;
+			{
+				std::lock_guard<std::mutex> lock(_retiredLock);
+				_retired.push_back({ _epoch.fetch_add(1, std::memory_order_seq_cst), ptr, deleter });
+
+				const std::uint64_t oldest{ oldestReader() };
+				auto reachable = std::partition(_retired.begin(), _retired.end(), [oldest](const Retired& retired) { return retired.epoch >= oldest; });
+				unreachable.assign(reachable, _retired.end());
+				_retired.erase(reachable, _retired.end());
+			}
+			for (const auto& retired : unreachable) {
+				retired.deleter(retired.ptr);
+			}
+		}
+	};
+
+	/**
+	 * <summary>An owning pointer that readers load inside an EpochDomain::ReadGuard, and writers replace.</summary>
+	 *
+	 * Writers must serialize among themselves. A replaced object is retired, so readers that still have it can
+	 * finish with it.
+	 */
+	template <typename T>
+	class EpochPtr {
+		std::atomic<T*> _ptr{ nullptr };
+
+		static void destroy(void* ptr) { delete static_cast<T*>(ptr); }
+
+	public:
+		EpochPtr() = default;
+		~EpochPtr() { store(nullptr); }
+		EpochPtr(EpochPtr<T>&&) = delete;
+		EpochPtr(const EpochPtr<T>&) = delete;
+		EpochPtr<T>& operator=(EpochPtr<T>&&) = delete;
+		EpochPtr<T>& operator=(const EpochPtr<T>&) = delete;
+
+		inline T* load() const noexcept { return _ptr.load(std::memory_order_seq_cst); }
+
+		void store(std::unique_ptr<T> next) {
+			if (T* previous = _ptr.exchange(next.release(), std::memory_order_seq_cst)) {
+				EpochDomain::instance().retire(const_cast<std::remove_const_t<T>*>(previous), &destroy);
+			}
+		}
+	};
+
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <concepts>
+
+#include "InplaceFunction.h"
+
+
+namespace CppSimConnect {
+	namespace Reactive {
+
+		using Task = InplaceFunction<void()>;
+
+		/**
+		 * <summary>Anything that runs tasks, now or later, on some thread.</summary>
+		 */
+		template <typename E>
+		concept Executor = requires(E& executor, Task task) {
+			executor.execute(std::move(task));
+		};
+
+		/**
+		 * <summary>Runs tasks immediately, on the calling thread.</summary>
+		 */
+		class InlineExecutor {
+		public:
+			inline void execute(Task task) { task(); }
+
+			static InlineExecutor& instance() noexcept {
+				static InlineExecutor executor;
+				return executor;
+			}
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>The inline capacity used for callbacks: enough for a lambda capturing a handful of pointers, shared_ptrs, or a string.</summary>
+	 */
+	inline constexpr size_t defaultInplaceCapacity{ 8 * sizeof(void*) };
+
+	template <typename Signature, size_t Capacity = defaultInplaceCapacity>
+	class InplaceFunction;
+
+	namespace detail {
+		// Callables that can be empty, and then should give us an empty InplaceFunction, like std::function does.
+		template <typename F>
+		struct IsNullableFunction : std::bool_constant<std::is_pointer_v<F> || std::is_member_pointer_v<F>> {};
+		template <typename Signature>
+		struct IsNullableFunction<std::function<Signature>> : std::true_type {};
+		template <typename Signature, size_t Capacity>
+		struct IsNullableFunction<InplaceFunction<Signature, Capacity>> : std::true_type {};
+	}
+
+	/**
+	 * <summary>A move-only replacement for std::function that stores its callable inline.</summary>
+	 *
+	 * Callables up to <c>Capacity</c> bytes that can be moved without throwing are stored in the object
+	 * itself, so constructing, moving, and calling never touch the heap. Larger callables still work, but
+	 * are allocated. Because it never needs to copy, it also accepts move-only callables. A null function
+	 * pointer or an empty std::function gives an empty InplaceFunction.
+	 */
+	template <typename R, typename... Args, size_t Capacity>
+	class InplaceFunction<R(Args...), Capacity> {
+		// Callables that don't fit are allocated, and the storage holds a pointer to them instead.
+		static_assert((Capacity >= sizeof(void*)) && (alignof(std::max_align_t) >= alignof(void*)), "An InplaceFunction must be able to hold a pointer.");
+
+		struct Ops {
+			R(*invoke)(void* storage, Args&&... args);
+			void(*move)(void* to, void* from) noexcept;
+			void(*destroy)(void* storage) noexcept;
+		};
+
+		template <typename F>
+		static constexpr bool fitsInline{ (sizeof(F) <= Capacity) && (alignof(F) <= alignof(std::max_align_t)) && std::is_nothrow_move_constructible_v<F> };
+
+		template <typename F>
+		struct InlineOps {
+			static R invoke(void* storage, Args&&... args) { return std::invoke(*static_cast<F*>(storage), std::forward<Args>(args)...); }
+			static void move(void* to, void* from) noexcept {
+				::new (to) F(std::move(*static_cast<F*>(from)));
+				static_cast<F*>(from)->~F();
+			}
+			static void destroy(void* storage) noexcept { static_cast<F*>(storage)->~F(); }
+
+			static constexpr Ops ops{ &invoke, &move, &destroy };
+		};
+
+		template <typename F>
+		struct HeapOps {
+			static F*& ptr(void* storage) noexcept { return *static_cast<F**>(storage); }
+
+			static R invoke(void* storage, Args&&... args) { return std::invoke(*ptr(storage), std::forward<Args>(args)...); }
+			static void move(void* to, void* from) noexcept { ::new (to) F*(std::exchange(ptr(from), nullptr)); }
+			static void destroy(void* storage) noexcept { delete ptr(storage); }
+
+			static constexpr Ops ops{ &invoke, &move, &destroy };
+		};
+
+		alignas(std::max_align_t) mutable std::byte _storage[Capacity];
+		const Ops* _ops{ nullptr };
+
+		void reset() noexcept {
+			if (_ops != nullptr) {
+				_ops->destroy(_storage);
+				_ops = nullptr;
+			}
+		}
+
+	public:
+		static constexpr size_t capacity{ Capacity };
+
+		InplaceFunction() noexcept = default;
+		InplaceFunction(std::nullptr_t) noexcept {}
+
+		template <typename F>
+			requires (!std::is_same_v<std::remove_cvref_t<F>, InplaceFunction>) && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+		InplaceFunction(F&& f) {
+			using Fn = std::decay_t<F>;
+
+			if constexpr (detail::IsNullableFunction<Fn>::value) {
+				if (!f) {
+					return;
+				}
+			}
+			if constexpr (fitsInline<Fn>) {
+				::new (static_cast<void*>(_storage)) Fn(std::forward<F>(f));
+				_ops = &InlineOps<Fn>::ops;
+			}
+			else {
+				::new (static_cast<void*>(_storage)) Fn*(new Fn(std::forward<F>(f)));
+				_ops = &HeapOps<Fn>::ops;
+			}
+		}
+
+		~InplaceFunction() { reset(); }
+
+		InplaceFunction(InplaceFunction&& other) noexcept : _ops(other._ops) {
+			if (_ops != nullptr) {
+				_ops->move(_storage, other._storage);
+				other._ops = nullptr;
+			}
+		}
+		InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+			if (this != &other) {
+				reset();
+				if (other._ops != nullptr) {
+					other._ops->move(_storage, other._storage);
+					_ops = std::exchange(other._ops, nullptr);
+				}
+			}
+			return *this;
+		}
+		InplaceFunction& operator=(std::nullptr_t) noexcept {
+			reset();
+			return *this;
+		}
+		InplaceFunction(InplaceFunction const&) = delete;
+		InplaceFunction& operator=(InplaceFunction const&) = delete;
+
+		explicit operator bool() const noexcept { return _ops != nullptr; }
+
+		R operator()(Args... args) const {
+			if (_ops == nullptr) {
+				throw std::bad_function_call();
+			}
+			return _ops->invoke(_storage, std::forward<Args>(args)...);
+		}
+	};
+}
\ No newline at end of file
@@ -19,6 +19,8 @@
 #include <exception>
 #include <stdexcept>
 #include <functional>
+#include <mutex>
+#include <utility>
 #include <vector>
 #include <atomic>
 
@@ -51,51 +53,60 @@ namespace CppSimConnect {
 				onCompleted();
 			}
 			_MessageObserver(_MessageObserver<Tmsg>&&) = delete;
-			_MessageObserver(const _MessageObserver<Tmsg>& other) : _error(other._error), _onNext(other._onNext), _onError(other._onError), _onCompleted(other._onCompleted) {
-				if (other.completed()) {
-					_completed.test_and_set();
-				}
-			}
+			_MessageObserver(const _MessageObserver<Tmsg>&) = delete;
 			_MessageObserver<Tmsg>& operator=(_MessageObserver<Tmsg>&&) = delete;
-			_MessageObserver<Tmsg>& operator=(const _MessageObserver<Tmsg>&) = default;
+			_MessageObserver<Tmsg>& operator=(const _MessageObserver<Tmsg>&) = delete;
 
 		private:
 			std::atomic_flag _completed;
 			std::exception_ptr _error;
-			CallbackList<Tmsg> _onNext;
+
+		protected:
+			CallbackList<const Tmsg&> _onNext;		// By reference, so a value is never copied per subscriber
+
+			// Adding an error or completion callback and completing exclude each other, so a callback is either
+			// taken along by the completion, or sees it has already happened and is called right away.
+			std::mutex _completionLock;
+
+		private:
 			CallbackList<std::exception_ptr> _onError;
 			CallbackList<> _onCompleted;
 
 		public:
-			using NextAction = CallbackList<Tmsg>::Callback;
+			using NextAction = CallbackList<const Tmsg&>::Callback;
 			using ErrorAction = CallbackList<std::exception_ptr>::Callback;
 			using CleanupAction = CallbackList<>::Callback;
 
-			inline _MessageObserver<Tmsg>& withOnNext(NextAction action) {
-				_onNext += action;
+			virtual _MessageObserver<Tmsg>& withOnNext(NextAction action) {
+				_onNext += std::move(action);
 				return *this;
 			}
 
+			// Actions are moved into the list, so if we're already done they are called instead of added.
 			inline _MessageObserver<Tmsg>& withOnError(ErrorAction action) {
-				_onError += action;
-				if (completed() && (_error != nullptr)) {
-					action(_error);
+				std::unique_lock lock(_completionLock);
+				if (!completed()) {
+					_onError += std::move(action);
+					return *this;
+				}
+				const std::exception_ptr error{ _error };
+				lock.unlock();
+
+				if (error != nullptr) {
+					action(error);
 				}
 				return *this;
 			}
 
 			inline _MessageObserver<Tmsg>& withOnComplete(CleanupAction action) {
-				_onCompleted += action;
-				if (completed()) {
-					action();
+				std::unique_lock lock(_completionLock);
+				if (!completed()) {
+					_onCompleted += std::move(action);
+					return *this;
 				}
-				return *this;
-			}
+				lock.unlock();
 
-			inline _MessageObserver<Tmsg>& operator+=(const _MessageObserver<Tmsg>& other) {
-				_onNext += other._onNext;
-				_onCompleted += other._onCompleted;
-				_onError += other._onError;
+				action();
 				return *this;
 			}
 
@@ -110,28 +121,42 @@ namespace CppSimConnect {
 				}
 			}
 
+			// The callbacks are taken out of the lists while holding the lock, and called after releasing it.
 			virtual void onCompleted() {
-				if (!_completed.test_and_set()) {
-					try {
-						_onCompleted();
-					}
-					catch (...) {
-						onError(std::current_exception());
-					}
+				std::unique_lock lock(_completionLock);
+				if (_completed.test_and_set()) {
+					return;
+				}
+				auto onCompleted{ std::exchange(_onCompleted, CallbackList<>()) };
+				_onError = CallbackList<std::exception_ptr>();
+				lock.unlock();
+
+				try {
+					onCompleted();
+				}
+				catch (...) {
+					onError(std::current_exception());
 				}
 			}
 
 			virtual void onError(std::exception_ptr err) {
-				if (_completed.test_and_set()) {
+				std::unique_lock lock(_completionLock);
+				if (_completed.test()) {
 					return;
 				}
-				_error = err;
-				_onError(err);
-				_onCompleted();
+				_error = err;		// Before the flag, so whoever sees it completed also sees the error
+				_completed.test_and_set();
+				auto onError{ std::exchange(_onError, CallbackList<std::exception_ptr>()) };
+				auto onCompleted{ std::exchange(_onCompleted, CallbackList<>()) };
+				lock.unlock();
+
+				onError(err);
+				onCompleted();
 			}
 
 			inline bool completed() const { return _completed.test(); }
 			inline std::exception_ptr error() const { return _error; }
+			virtual size_t subscribers() const noexcept { return _onNext.size(); }
 		};
 
 		template <typename Tmsg, typename Tobs>
@@ -144,7 +169,7 @@ namespace CppSimConnect {
 			inline Tobs& obs() { return *_obs; }
 
 		public:
-			using NextAction = CallbackList<Tmsg>::Callback;
+			using NextAction = CallbackList<const Tmsg&>::Callback;
 			using ErrorAction = CallbackList<std::exception_ptr>::Callback;
 			using CleanupAction = CallbackList<>::Callback;
 
@@ -156,22 +181,25 @@ namespace CppSimConnect {
 			MessageObserver<Tmsg, Tobs>& operator=(const MessageObserver<Tmsg, Tobs>&) = default;
 
 			inline const MessageObserver<Tmsg, Tobs>& withOnNext(NextAction action) const {
-				_obs->withOnNext(action);
+				_obs->withOnNext(std::move(action));
 				return *this;
 			}
 
 			inline const MessageObserver<Tmsg, Tobs>& withOnError(ErrorAction action) const {
-				_obs->withOnError(action);
+				_obs->withOnError(std::move(action));
 				return *this;
 			}
 
 			inline const MessageObserver<Tmsg, Tobs>& withOnComplete(CleanupAction action) const {
-				_obs->withOnComplete(action);
+				_obs->withOnComplete(std::move(action));
 				return *this;
 			}
 
+			// Callbacks cannot be copied, so the other observer is notified through forwarding callbacks.
 			inline const MessageObserver<Tmsg, Tobs>& operator+=(const MessageObserver<Tmsg, Tobs>& other) const {
-				(*_obs) += *(other._obs);
+				_obs->withOnNext([target = other._obs](const Tmsg& msg) { target->onNext(msg); });
+				_obs->withOnError([target = other._obs](std::exception_ptr err) { target->onError(err); });
+				_obs->withOnComplete([target = other._obs]() { target->onCompleted(); });
 				return *this;
 			}
 
@@ -189,22 +217,23 @@ namespace CppSimConnect {
 
 
 			inline const MessageObserver<Tmsg, Tobs>& subscribe(NextAction onNext) const {
-				return withOnNext(onNext);
+				return withOnNext(std::move(onNext));
 			}
 			inline const MessageObserver<Tmsg, Tobs>& subscribe(NextAction onNext, ErrorAction onError) const {
-				return withOnNext(onNext).withOnError(onError);
+				return withOnNext(std::move(onNext)).withOnError(std::move(onError));
 			}
 			inline const MessageObserver<Tmsg, Tobs>& subscribe(NextAction onNext, CleanupAction onCompleted) const {
-				return withOnNext(onNext).withOnComplete(onCompleted);
+				return withOnNext(std::move(onNext)).withOnComplete(std::move(onCompleted));
 			}
 			inline const MessageObserver<Tmsg, Tobs>& subscribe(NextAction onNext, ErrorAction onError, CleanupAction onCompleted) const {
-				return withOnNext(onNext).withOnError(onError).withOnComplete(onCompleted);
+				return withOnNext(std::move(onNext)).withOnError(std::move(onError)).withOnComplete(std::move(onCompleted));
 			}
 
 			inline std::exception_ptr error() const noexcept { return obs().error(); }
 			template <typename Terr>
 			inline Terr error() const { return errorFromPtr<Terr>(obs().error()); }
 			inline bool completed() const noexcept { return obs().completed(); }
+			inline size_t subscribers() const noexcept { return obs().subscribers(); }
 		};
 
 	}
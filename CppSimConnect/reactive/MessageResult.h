@@ -16,8 +16,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <coroutine>
 #include <future>
+#include <mutex>
+#include <optional>
 
+#include "Executor.h"
 #include "MessageObserver.h"
 
 
@@ -26,47 +31,111 @@ namespace CppSimConnect {
 
 		template <typename Tmsg>
 		class _MessageResult : public _MessageObserver<Tmsg> {
-			std::promise<Tmsg> _future;
+			std::atomic_flag _satisfied;
+			std::promise<Tmsg> _promise;
+			std::shared_future<Tmsg> _future{ _promise.get_future() };
+			std::optional<Tmsg> _value;		// The value delivered, for subscribers that come after it
 
 		public:
+			using NextAction = _MessageObserver<Tmsg>::NextAction;
+
 			_MessageResult() = default;
 			~_MessageResult() = default;
-			_MessageResult(_MessageResult<Tmsg>&&) = default;
-			_MessageResult(const _MessageResult<Tmsg>& other) : MessageObserver<Tmsg>(other) {};
-			_MessageResult<Tmsg>& operator=(_MessageResult<Tmsg>&&) = default;
-			_MessageResult<Tmsg>& operator=(const _MessageResult<Tmsg>&) = default;
+			_MessageResult(_MessageResult<Tmsg>&&) = delete;
+			_MessageResult(const _MessageResult<Tmsg>&) = delete;
+			_MessageResult<Tmsg>& operator=(_MessageResult<Tmsg>&&) = delete;
+			_MessageResult<Tmsg>& operator=(const _MessageResult<Tmsg>&) = delete;
+
+			// A result is often completed before the caller gets to subscribe, for example from a cache or by a fast
+			// reply. Keeping the value and adding subscribers under the same lock means every subscriber gets it
+			// exactly once: either from the list when the value arrives, or right away if it already has.
+			virtual _MessageObserver<Tmsg>& withOnNext(NextAction action) override {
+				std::unique_lock lock(this->_completionLock);
+				if (!_value) {
+					this->_onNext += std::move(action);
+					return *this;
+				}
+				const Tmsg value{ *_value };
+				lock.unlock();
+
+				action(value);
+				return *this;
+			}
 
 			virtual void onNext(const Tmsg& msg) override {
-				try {
-					_future.set_value(msg);
+				if (!_satisfied.test_and_set()) {
+					_promise.set_value(msg);
 				}
-				catch (std::future_error _) {
-					//TODO
+				{
+					std::lock_guard lock(this->_completionLock);
+					if (_value || _MessageObserver<Tmsg>::completed()) {
+						return;
+					}
+					_value.emplace(msg);
 				}
 				_MessageObserver<Tmsg>::onNext(msg);
 				onCompleted();
 			}
 
+			// Completing without a value or error leaves nothing to get(), so that becomes a broken promise.
 			virtual void onCompleted() override {
+				if (!_satisfied.test_and_set()) {
+					_promise.set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+				}
 				_MessageObserver<Tmsg>::onCompleted();
 			}
 
 			virtual void onError(std::exception_ptr err) override {
-				try {
-					_future.set_exception(err);
-				}
-				catch (std::future_error _) {
-					// TODO
+				if (!_satisfied.test_and_set()) {
+					_promise.set_exception(err);
 				}
 				_MessageObserver<Tmsg>::onError(err);
 			}
 
-			inline Tmsg get() {
+			inline Tmsg get() const {
 				if (_MessageObserver<Tmsg>::completed() && (_MessageObserver<Tmsg>::error() != nullptr)) {
 					std::rethrow_exception(_MessageObserver<Tmsg>::error());
 				}
-				return _future.get_future().get();
+				return _future.get();
+			}
+		};
+
+		/**
+		 * <summary>Suspends a coroutine until a MessageResult completes, and resumes it through an executor.</summary>
+		 *
+		 * If the result has already completed, the coroutine does not suspend and continues on its own thread.
+		 * Otherwise it is resumed by handing a task to the executor from the thread that completes the result,
+		 * which for requests is the message dispatcher.
+		 */
+		template <typename Tmsg, Executor Texec>
+		class MessageResultAwaiter {
+			std::shared_ptr<_MessageResult<Tmsg>> _obs;
+			Texec& _executor;
+			std::atomic_bool _armed{ false };
+
+		public:
+			MessageResultAwaiter(std::shared_ptr<_MessageResult<Tmsg>> obs, Texec& executor) : _obs{ std::move(obs) }, _executor{ executor } {}
+			~MessageResultAwaiter() = default;
+			MessageResultAwaiter(MessageResultAwaiter<Tmsg, Texec>&&) = delete;
+			MessageResultAwaiter(const MessageResultAwaiter<Tmsg, Texec>&) = delete;
+			MessageResultAwaiter<Tmsg, Texec>& operator=(MessageResultAwaiter<Tmsg, Texec>&&) = delete;
+			MessageResultAwaiter<Tmsg, Texec>& operator=(const MessageResultAwaiter<Tmsg, Texec>&) = delete;
+
+			inline bool await_ready() const noexcept { return _obs->completed(); }
+
+			// Whichever of us and the completion comes second decides: if the completion is second it resumes
+			// the coroutine, if we are second the result is already there and we don't suspend at all.
+			// withOnComplete() either keeps the callback or calls it right away, so exactly one of the two happens.
+			bool await_suspend(std::coroutine_handle<> handle) {
+				_obs->withOnComplete([this, handle]() {
+					if (_armed.exchange(true, std::memory_order_acq_rel)) {
+						_executor.execute([handle]() { handle.resume(); });
+					}
+				});
+				return !_armed.exchange(true, std::memory_order_acq_rel);
 			}
+
+			inline Tmsg await_resume() const { return _obs->get(); }
 		};
 
 		template <typename Tmsg>
@@ -82,6 +151,35 @@ namespace CppSimConnect {
 			Tmsg get() const {
 				return MessageObserver<Tmsg, _MessageResult<Tmsg>>::_obs->get();
 			}
+
+			/**
+			 * <summary>Await the result, resuming on the thread that completes it.</summary>
+			 */
+			inline MessageResultAwaiter<Tmsg, InlineExecutor> operator co_await() const {
+				return { MessageObserver<Tmsg, _MessageResult<Tmsg>>::_obs, InlineExecutor::instance() };
+			}
+
+			/**
+			 * <summary>Await the result, resuming on the given executor.</summary>
+			 */
+			template <Executor Texec>
+			inline MessageResultAwaiter<Tmsg, Texec> on(Texec& executor) const {
+				return { MessageObserver<Tmsg, _MessageResult<Tmsg>>::_obs, executor };
+			}
+
+			// A coroutine returning a MessageResult starts right away, and completes the result with its co_return value or exception.
+			struct promise_type;
+		};
+
+		template <typename Tmsg>
+		struct MessageResult<Tmsg>::promise_type {
+			MessageResult<Tmsg> _result;
+
+			inline MessageResult<Tmsg> get_return_object() const { return _result; }
+			inline std::suspend_never initial_suspend() const noexcept { return {}; }
+			inline std::suspend_never final_suspend() const noexcept { return {}; }
+			inline void return_value(const Tmsg& value) const { _result.onNext(value); }
+			inline void unhandled_exception() const { _result.onError(std::current_exception()); }
 		};
 	}
 }
\ No newline at end of file
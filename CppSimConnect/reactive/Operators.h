@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "TimerQueue.h"
+
+
+namespace CppSimConnect {
+	namespace Reactive {
+
+		/*
+		 * The state behind the stream operators. Each receives the values of its upstream and passes what
+		 * remains on to its downstream stream. Values arrive on a single producer thread, so operators that
+		 * don't use a timer need no locking. Those that do copy into buffers they keep, so once these have
+		 * grown to size no value causes an allocation.
+		 */
+
+		/*
+		 * Timed operators stop their timer once their downstream has completed, or has no subscribers left, so
+		 * idle ones don't keep waking the timer thread. Without subscribers they go idle, and the next value
+		 * starts the timer again. Called by the timer task, with the operator's lock held.
+		 */
+		template <typename Tout>
+		inline bool unwatched(const Tout& downstream, bool& done, bool& idle) noexcept {
+			if (downstream.completed()) {
+				done = true;
+			}
+			else if (downstream.subscribers() == 0) {
+				idle = true;
+			}
+			return done || idle;
+		}
+
+		template <typename Tmsg, typename Tout>
+		class ThrottleOperator {
+			Tout _downstream;
+			TimerQueue::Clock::duration _period;
+			TimerQueue::Clock::time_point _nextEmit{};
+
+		public:
+			ThrottleOperator(Tout downstream, TimerQueue::Clock::duration period) : _downstream{ std::move(downstream) }, _period{ period } {}
+
+			void onNext(const Tmsg& msg) {
+				const auto now{ TimerQueue::Clock::now() };
+				if (now >= _nextEmit) {
+					_nextEmit = now + _period;
+					_downstream.onNext(msg);
+				}
+			}
+			inline void onError(std::exception_ptr err) { _downstream.onError(err); }
+			inline void onCompleted() { _downstream.onCompleted(); }
+		};
+
+		template <typename Tmsg, typename Tout, typename Tequal>
+		class DistinctOperator {
+			Tout _downstream;
+			Tequal _equal;
+			std::optional<Tmsg> _last;
+
+		public:
+			DistinctOperator(Tout downstream, Tequal equal) : _downstream{ std::move(downstream) }, _equal{ std::move(equal) } {}
+
+			void onNext(const Tmsg& msg) {
+				if (!_last || !_equal(*_last, msg)) {
+					_last = msg;
+					_downstream.onNext(msg);
+				}
+			}
+			inline void onError(std::exception_ptr err) { _downstream.onError(err); }
+			inline void onCompleted() { _downstream.onCompleted(); }
+		};
+
+		template <typename Tmsg, typename Tout>
+		class CountBufferOperator {
+			Tout _downstream;
+			std::vector<Tmsg> _batch;
+			size_t _count;
+
+		public:
+			CountBufferOperator(Tout downstream, size_t count) : _downstream{ std::move(downstream) }, _count{ count } {
+				_batch.reserve(count);
+			}
+
+			void onNext(const Tmsg& msg) {
+				_batch.push_back(msg);
+				if (_batch.size() >= _count) {
+					_downstream.onNext(_batch);
+					_batch.clear();
+				}
+			}
+			inline void onError(std::exception_ptr err) { _downstream.onError(err); }
+			void onCompleted() {
+				if (!_batch.empty()) {
+					_downstream.onNext(_batch);
+					_batch.clear();
+				}
+				_downstream.onCompleted();
+			}
+		};
+
+		/**
+		 * <summary>Emits the latest value once every period, if a new one arrived since the last.</summary>
+		 */
+		template <typename Tmsg, typename Tout>
+		class SampleOperator : public std::enable_shared_from_this<SampleOperator<Tmsg, Tout>> {
+			Tout _downstream;
+			TimerQueue& _timers;
+			TimerQueue::Clock::duration _period;
+
+			std::mutex _emitLock;	// Keeps emissions in order. Taken before _lock.
+			std::mutex _lock;
+			std::optional<Tmsg> _latest;
+			bool _fresh{ false };
+			bool _done{ false };
+			bool _idle{ false };		// The timer stopped for lack of subscribers, until the next value
+			std::optional<Tmsg> _emitting;	// Stays engaged once used, so copying into it reuses its storage
+
+			void tick(TimerQueue::Clock::time_point due) {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				bool emit{ false };
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					if (_done || unwatched(_downstream, _done, _idle)) {
+						return;
+					}
+					if (_fresh) {
+						_emitting = _latest;
+						_fresh = false;
+						emit = true;
+					}
+				}
+				if (emit) {
+					_downstream.onNext(*_emitting);
+				}
+				schedule(due + _period);
+			}
+
+		public:
+			SampleOperator(Tout downstream, TimerQueue& timers, TimerQueue::Clock::duration period) :
+				_downstream{ std::move(downstream) }, _timers{ timers }, _period{ period } {}
+
+			// The timer only holds a weak reference, so sampling stops when the upstream lets go of us.
+			void schedule(TimerQueue::Clock::time_point due) {
+				_timers.schedule(due, [self = this->weak_from_this(), due]() {
+					if (auto op = self.lock()) {
+						op->tick(due);
+					}
+				});
+			}
+
+			void onNext(const Tmsg& msg) {
+				std::lock_guard<std::mutex> lock(_lock);
+				_latest = msg;
+				_fresh = true;
+				if (_idle && !_done) {
+					_idle = false;
+					schedule(TimerQueue::Clock::now() + _period);
+				}
+			}
+			void onError(std::exception_ptr err) {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					_done = true;
+				}
+				_downstream.onError(err);
+			}
+			void onCompleted() {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					_done = true;
+				}
+				_downstream.onCompleted();
+			}
+		};
+
+		/**
+		 * <summary>Emits a value only once no newer one has arrived for a full period. Completion flushes the pending value.</summary>
+		 */
+		template <typename Tmsg, typename Tout>
+		class DebounceOperator : public std::enable_shared_from_this<DebounceOperator<Tmsg, Tout>> {
+			Tout _downstream;
+			TimerQueue& _timers;
+			TimerQueue::Clock::duration _period;
+
+			std::mutex _emitLock;	// Keeps emissions in order. Taken before _lock.
+			std::mutex _lock;
+			std::optional<Tmsg> _latest;
+			bool _pending{ false };
+			bool _timerSet{ false };
+			bool _done{ false };
+			TimerQueue::Clock::time_point _deadline;
+			std::optional<Tmsg> _emitting;	// Stays engaged once used, so copying into it reuses its storage
+
+			void schedule(TimerQueue::Clock::time_point due) {
+				_timers.schedule(due, [self = this->weak_from_this()]() {
+					if (auto op = self.lock()) {
+						op->expire();
+					}
+				});
+			}
+
+			void expire() {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					if (_done || !_pending) {
+						_timerSet = false;
+						return;
+					}
+					if (TimerQueue::Clock::now() < _deadline) {
+						schedule(_deadline);	// More values came in; wait for them to settle
+						return;
+					}
+					_emitting = _latest;
+					_pending = false;
+					_timerSet = false;
+				}
+				_downstream.onNext(*_emitting);
+			}
+
+		public:
+			DebounceOperator(Tout downstream, TimerQueue& timers, TimerQueue::Clock::duration period) :
+				_downstream{ std::move(downstream) }, _timers{ timers }, _period{ period } {}
+
+			void onNext(const Tmsg& msg) {
+				std::lock_guard<std::mutex> lock(_lock);
+				_latest = msg;
+				_pending = true;
+				_deadline = TimerQueue::Clock::now() + _period;
+				if (!_timerSet) {
+					_timerSet = true;
+					schedule(_deadline);
+				}
+			}
+			void onError(std::exception_ptr err) {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					_done = true;
+				}
+				_downstream.onError(err);
+			}
+			void onCompleted() {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				bool emit{ false };
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					if (_done) {
+						return;
+					}
+					_done = true;
+					if (_pending) {
+						_emitting = _latest;
+						_pending = false;
+						emit = true;
+					}
+				}
+				if (emit) {
+					_downstream.onNext(*_emitting);
+				}
+				_downstream.onCompleted();
+			}
+		};
+
+		/**
+		 * <summary>Collects values and emits them together once every period, if any arrived.</summary>
+		 */
+		template <typename Tmsg, typename Tout>
+		class TimeBufferOperator : public std::enable_shared_from_this<TimeBufferOperator<Tmsg, Tout>> {
+			Tout _downstream;
+			TimerQueue& _timers;
+			TimerQueue::Clock::duration _period;
+
+			std::mutex _emitLock;	// Keeps emissions in order. Taken before _lock.
+			std::mutex _lock;
+			std::vector<Tmsg> _batch;
+			std::vector<Tmsg> _emitting;	// Swapped with _batch, so both keep their capacity
+			bool _done{ false };
+			bool _idle{ false };		// The timer stopped for lack of subscribers, until the next value
+
+			// Returns false if we're done.
+			bool flush(bool done) {
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					if (_done) {
+						return false;
+					}
+					_done = done;
+					_batch.swap(_emitting);
+				}
+				if (!_emitting.empty()) {
+					_downstream.onNext(_emitting);
+					_emitting.clear();
+				}
+				return true;
+			}
+
+			void tick(TimerQueue::Clock::time_point due) {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					if (!_done && unwatched(_downstream, _done, _idle)) {
+						_batch.clear();		// Nobody would have received them
+						return;
+					}
+				}
+				if (flush(false)) {
+					schedule(due + _period);
+				}
+			}
+
+		public:
+			TimeBufferOperator(Tout downstream, TimerQueue& timers, TimerQueue::Clock::duration period, size_t expected) :
+				_downstream{ std::move(downstream) }, _timers{ timers }, _period{ period }
+			{
+				_batch.reserve(expected);
+				_emitting.reserve(expected);
+			}
+
+			void schedule(TimerQueue::Clock::time_point due) {
+				_timers.schedule(due, [self = this->weak_from_this(), due]() {
+					if (auto op = self.lock()) {
+						op->tick(due);
+					}
+				});
+			}
+
+			void onNext(const Tmsg& msg) {
+				std::lock_guard<std::mutex> lock(_lock);
+				_batch.push_back(msg);
+				if (_idle && !_done) {
+					_idle = false;
+					schedule(TimerQueue::Clock::now() + _period);
+				}
+			}
+			void onError(std::exception_ptr err) {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					_done = true;
+				}
+				_downstream.onError(err);
+			}
+			void onCompleted() {
+				std::lock_guard<std::mutex> emitLock(_emitLock);
+				if (flush(true)) {
+					_downstream.onCompleted();
+				}
+			}
+		};
+	}
+}
\ No newline at end of file
@@ -16,15 +16,548 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../Statistics.h"
+
+#include "BoundedQueue.h"
+#include "Epoch.h"
+#include "Executor.h"
 #include "MessageObserver.h"
+#include "Operators.h"
 
 
 namespace CppSimConnect {
 	namespace Reactive {
 
+		/**
+		 * <summary>What a buffered subscriber does with a new value when its buffer is full.</summary>
+		 */
+		enum class OverflowPolicy {
+			DropOldest,		// Discard the oldest waiting value to make room
+			DropNewest,		// Discard the new value
+			LatestOnly,		// Keep only the newest value; anything not yet delivered is replaced
+			Block			// Make the producer wait for the consumer. Never use this if the consumer runs on the producer's thread.
+		};
+
+		struct BufferPolicy {
+			OverflowPolicy overflow{ OverflowPolicy::DropOldest };
+			size_t capacity{ 64 };
+		};
+
+		/**
+		 * <summary>A subscriber that receives a stream's values through its own bounded buffer.</summary>
+		 *
+		 * The producer only copies values into the buffer. They are delivered when the consumer calls drain(),
+		 * on whatever thread it likes; drain() never runs concurrently with itself, so values always arrive in
+		 * order. The ready action is called when the buffer goes from drained to having values, which is the
+		 * moment to schedule a drain(). Completion and errors are delivered after all buffered values.
+		 */
 		template <typename Tmsg>
-		class StreamResult : public virtual MessageObserver<Tmsg, _MessageObserver<Tmsg>> {
+		class StreamSubscription {
+		public:
+			using NextAction = CallbackList<const Tmsg&>::Callback;
+			using ErrorAction = CallbackList<std::exception_ptr>::Callback;
+			using CleanupAction = CallbackList<>::Callback;
+			using ReadyAction = CallbackList<>::Callback;
+
+		private:
+			BoundedQueue<Tmsg> _buffer;
+			OverflowPolicy _overflow;
+
+			NextAction _onNext;
+			ErrorAction _onError;
+			CleanupAction _onCompleted;
+			ReadyAction _onReady;
+
+			std::atomic_bool _signalled{ false };
+			std::atomic_flag _draining;
+			std::atomic_bool _cancelled{ false };
+			std::atomic_bool _done{ false };
+			std::atomic_bool _doneDelivered{ false };
+			std::exception_ptr _error;
+
+			std::atomic<std::uint64_t> _published{ 0 };
+			std::atomic<std::uint64_t> _delivered{ 0 };
+			std::atomic<std::uint64_t> _dropped{ 0 };
+			std::atomic<std::uint64_t> _maxDepth{ 0 };
+
+			inline void signalReady() {
+				if (!_signalled.exchange(true, std::memory_order_seq_cst) && _onReady) {
+					_onReady();
+				}
+			}
+
+			inline void dropOne() {
+				Tmsg stale;
+				if (_buffer.tryPop(stale)) {
+					_dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+		public:
+			StreamSubscription(NextAction onNext, BufferPolicy policy, ReadyAction onReady) :
+				_buffer(policy.capacity), _overflow(policy.overflow), _onNext(std::move(onNext)), _onReady(std::move(onReady))
+			{
+				_draining.clear();
+			}
+			~StreamSubscription() = default;
+			StreamSubscription(const StreamSubscription<Tmsg>&) = delete;
+			StreamSubscription(StreamSubscription<Tmsg>&&) = delete;
+			StreamSubscription<Tmsg>& operator=(const StreamSubscription<Tmsg>&) = delete;
+			StreamSubscription<Tmsg>& operator=(StreamSubscription<Tmsg>&&) = delete;
+
+			// Set these before values arrive.
+			inline StreamSubscription<Tmsg>& withOnError(ErrorAction action) {
+				_onError = std::move(action);
+				return *this;
+			}
+			inline StreamSubscription<Tmsg>& withOnComplete(CleanupAction action) {
+				_onCompleted = std::move(action);
+				return *this;
+			}
+			inline StreamSubscription<Tmsg>& withOnReady(ReadyAction action) {
+				_onReady = std::move(action);
+				return *this;
+			}
+
+			/**
+			 * <summary>Producer side: buffer a value, applying the overflow policy if the buffer is full.</summary>
+			 */
+			void offer(const Tmsg& msg) {
+				if (_cancelled.load(std::memory_order_relaxed)) {
+					return;
+				}
+				_published.fetch_add(1, std::memory_order_relaxed);
+				switch (_overflow) {
+				case OverflowPolicy::DropOldest:
+					while (!_buffer.tryPush(msg)) {
+						dropOne();
+					}
+					break;
+				case OverflowPolicy::DropNewest:
+					if (!_buffer.tryPush(msg)) {
+						_dropped.fetch_add(1, std::memory_order_relaxed);
+						return;
+					}
+					break;
+				case OverflowPolicy::LatestOnly:
+					while (!_buffer.empty()) {
+						dropOne();
+					}
+					while (!_buffer.tryPush(msg)) {
+						dropOne();
+					}
+					break;
+				case OverflowPolicy::Block:
+					while (!_buffer.tryPush(msg)) {
+						if (_cancelled.load(std::memory_order_relaxed)) {
+							_dropped.fetch_add(1, std::memory_order_relaxed);
+							return;
+						}
+						signalReady();
+						std::this_thread::yield();
+					}
+					break;
+				}
+				const std::uint64_t depth{ _buffer.size() };
+				if (depth > _maxDepth.load(std::memory_order_relaxed)) {
+					_maxDepth.store(depth, std::memory_order_relaxed);
+				}
+				signalReady();
+			}
+
+			/**
+			 * <summary>Producer side: the stream has ended, with an error if <c>err</c> is not null.</summary>
+			 */
+			void complete(std::exception_ptr err) {
+				if (!_done.load(std::memory_order_relaxed)) {
+					_error = err;
+					_done.store(true, std::memory_order_seq_cst);
+					signalReady();
+				}
+			}
+
+			/**
+			 * <summary>Consumer side: deliver up to <c>max</c> buffered values, and the completion if all have been
+			 * delivered. Returns the number of values delivered.</summary>
+			 *
+			 * The ready signal stays raised while a drain is due or running, so at most one drain gets scheduled at
+			 * a time. It is only lowered once the buffer is empty, after which we look once more: a value that
+			 * arrived in between either raised the signal again (and scheduled a new drain), or gets drained by us.
+			 */
+			size_t drain(size_t max = SIZE_MAX) {
+				if (_draining.test_and_set(std::memory_order_acquire)) {
+					return 0;
+				}
+				size_t count{ 0 };
+				Tmsg msg;
+				for (;;) {
+					while ((count < max) && !_cancelled.load(std::memory_order_relaxed) && _buffer.tryPop(msg)) {
+						count++;
+						_delivered.fetch_add(1, std::memory_order_relaxed);
+						try {
+							_onNext(msg);
+						}
+						catch (...) {
+							if (_onError) { _onError(std::current_exception()); }
+						}
+					}
+					if ((count >= max) && !_buffer.empty()) {
+						_draining.clear(std::memory_order_release);
+						if (_onReady) { _onReady(); }		// The signal is still raised; ask for another drain
+						return count;
+					}
+					const bool done{ _done.load(std::memory_order_acquire) };
+					if (done && _buffer.empty() && !_doneDelivered.exchange(true)) {
+						if (_error != nullptr) {
+							if (_onError) { _onError(_error); }
+						}
+						else if (_onCompleted) {
+							_onCompleted();
+						}
+					}
+					_draining.clear(std::memory_order_release);
+
+					_signalled.store(false, std::memory_order_seq_cst);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					const bool pending{ !_buffer.empty() || (_done.load(std::memory_order_acquire) && !_doneDelivered.load()) };
+					if (_cancelled.load(std::memory_order_relaxed) || !pending || _signalled.exchange(true, std::memory_order_seq_cst)) {
+						return count;
+					}
+					if (_draining.test_and_set(std::memory_order_acquire)) {
+						return count;
+					}
+				}
+			}
+
+			/**
+			 * <summary>Stop receiving values. A producer blocked on a full buffer is released.</summary>
+			 */
+			inline void cancel() noexcept { _cancelled.store(true, std::memory_order_relaxed); }
+			inline bool cancelled() const noexcept { return _cancelled.load(std::memory_order_relaxed); }
+
+			inline size_t depth() const noexcept { return _buffer.size(); }
+			inline size_t capacity() const noexcept { return _buffer.capacity(); }
+			inline OverflowPolicy overflow() const noexcept { return _overflow; }
+
+			StreamStats stats() const noexcept {
+				return {
+					_published.load(std::memory_order_relaxed),
+					_delivered.load(std::memory_order_relaxed),
+					_dropped.load(std::memory_order_relaxed),
+					_buffer.size(),
+					_maxDepth.load(std::memory_order_relaxed)
+				};
+			}
+		};
+
+		/**
+		 * <summary>The shared state of a stream: synchronous subscribers as for any observer, plus buffered ones.</summary>
+		 *
+		 * A stream gets subscribers while it is already producing, so both kinds are kept in an immutable list
+		 * that is replaced on every change, and the producer never takes a lock to publish a value. Until the
+		 * first subscriber there is no list at all.
+		 */
+		template <typename Tmsg>
+		class _StreamResult : public _MessageObserver<Tmsg> {
+		public:
+			using NextAction = _MessageObserver<Tmsg>::NextAction;
+			using Subscription = std::shared_ptr<StreamSubscription<Tmsg>>;
+
+		private:
+			struct Subscribers {
+				std::vector<std::shared_ptr<const NextAction>> direct;
+				std::vector<Subscription> buffered;
+			};
+
+			std::mutex _subscriptionsLock;
+			EpochPtr<const Subscribers> _subscribers;		// nullptr until the first subscriber
+
+			// Subscriptions that were removed still count, so the stream's counters never go backwards.
+			std::atomic<std::uint64_t> _removedPublished{ 0 };
+			std::atomic<std::uint64_t> _removedDelivered{ 0 };
+			std::atomic<std::uint64_t> _removedDropped{ 0 };
+
+			template <typename Edit>
+			void publish(Edit&& edit) {
+				std::lock_guard<std::mutex> lock(_subscriptionsLock);
+				auto current = _subscribers.load();		// Only writers retire it, and we hold the lock
+				auto next = current ? std::make_unique<Subscribers>(*current) : std::make_unique<Subscribers>();
+				edit(*next);
+				_subscribers.store(std::move(next));
+			}
+
+		public:
+			_StreamResult() = default;
+			~_StreamResult() = default;
+			_StreamResult(_StreamResult<Tmsg>&&) = delete;
+			_StreamResult(const _StreamResult<Tmsg>&) = delete;
+			_StreamResult<Tmsg>& operator=(_StreamResult<Tmsg>&&) = delete;
+			_StreamResult<Tmsg>& operator=(const _StreamResult<Tmsg>&) = delete;
+
+			virtual _MessageObserver<Tmsg>& withOnNext(NextAction action) override {
+				auto direct = std::make_shared<const NextAction>(std::move(action));
+				publish([&direct](Subscribers& subscribers) { subscribers.direct.push_back(std::move(direct)); });
+				return *this;
+			}
+
+			virtual void onNext(const Tmsg& msg) override {
+				if (_MessageObserver<Tmsg>::completed()) {
+					return;
+				}
+				EpochDomain::ReadGuard guard;
+				auto subscribers = _subscribers.load();
+				if (!subscribers) {
+					return;
+				}
+				try {
+					for (auto const& action : subscribers->direct) {
+						(*action)(msg);
+					}
+				}
+				catch (...) {
+					onError(std::current_exception());
+				}
+				for (auto const& subscription : subscribers->buffered) {
+					subscription->offer(msg);
+				}
+			}
+
+			virtual void onCompleted() override {
+				if (!_MessageObserver<Tmsg>::completed()) {
+					_MessageObserver<Tmsg>::onCompleted();
+					EpochDomain::ReadGuard guard;
+					if (auto subscribers = _subscribers.load()) {
+						for (auto const& subscription : subscribers->buffered) {
+							subscription->complete(_MessageObserver<Tmsg>::error());
+						}
+					}
+				}
+			}
+
+			virtual void onError(std::exception_ptr err) override {
+				if (!_MessageObserver<Tmsg>::completed()) {
+					_MessageObserver<Tmsg>::onError(err);
+					EpochDomain::ReadGuard guard;
+					if (auto subscribers = _subscribers.load()) {
+						for (auto const& subscription : subscribers->buffered) {
+							subscription->complete(err);
+						}
+					}
+				}
+			}
+
+			void add(Subscription subscription) {
+				publish([&subscription](Subscribers& subscribers) { subscribers.buffered.push_back(subscription); });
+				if (_MessageObserver<Tmsg>::completed()) {
+					subscription->complete(_MessageObserver<Tmsg>::error());
+				}
+			}
+
+			void remove(const Subscription& subscription) {
+				subscription->cancel();
+				bool removed{ false };
+				publish([&subscription, &removed](Subscribers& subscribers) {
+					removed = (std::erase(subscribers.buffered, subscription) != 0);
+				});
+				if (!removed) {
+					return;
+				}
+				auto stats = subscription->stats();
+				_removedPublished.fetch_add(stats.published, std::memory_order_relaxed);
+				_removedDelivered.fetch_add(stats.delivered, std::memory_order_relaxed);
+				_removedDropped.fetch_add(stats.dropped + stats.depth, std::memory_order_relaxed);
+			}
+
+			virtual size_t subscribers() const noexcept override {
+				EpochDomain::ReadGuard guard;
+				auto subscribers = _subscribers.load();
+				return subscribers ? (subscribers->direct.size() + subscribers->buffered.size()) : 0;
+			}
+
+			StreamStats stats() const noexcept {
+				StreamStats result{
+					_removedPublished.load(std::memory_order_relaxed),
+					_removedDelivered.load(std::memory_order_relaxed),
+					_removedDropped.load(std::memory_order_relaxed),
+					0, 0
+				};
+				EpochDomain::ReadGuard guard;
+				if (auto subscribers = _subscribers.load()) {
+					for (auto const& subscription : subscribers->buffered) {
+						auto stats = subscription->stats();
+						result.published += stats.published;
+						result.delivered += stats.delivered;
+						result.dropped += stats.dropped;
+						result.depth += stats.depth;
+						result.maxDepth = std::max(result.maxDepth, stats.maxDepth);
+					}
+				}
+				return result;
+			}
+		};
+
+		/**
+		 * <summary>A stream of values. Unlike a MessageResult, a value does not complete it.</summary>
+		 */
+		template <typename Tmsg>
+		class StreamResult : public virtual MessageObserver<Tmsg, _StreamResult<Tmsg>> {
+		public:
+			using Subscription = _StreamResult<Tmsg>::Subscription;
+			using ReadyAction = StreamSubscription<Tmsg>::ReadyAction;
+
+			StreamResult() = default;
+			~StreamResult() = default;
+			StreamResult(StreamResult<Tmsg>&&) = default;
+			StreamResult(const StreamResult<Tmsg>&) = default;
+			StreamResult<Tmsg>& operator=(const StreamResult<Tmsg>&) = default;
+
+			// Written out, as a defaulted one would move the virtual base once for every path to it.
+			StreamResult<Tmsg>& operator=(StreamResult<Tmsg>&& other) noexcept {
+				MessageObserver<Tmsg, _StreamResult<Tmsg>>::operator=(std::move(other));
+				return *this;
+			}
+
+			/**
+			 * <summary>Subscribe through a bounded buffer. Values are delivered by calling drain() on the returned
+			 * subscription; <c>onReady</c> is called when there is something to drain.</summary>
+			 */
+			Subscription subscribeBuffered(typename StreamSubscription<Tmsg>::NextAction onNext, BufferPolicy policy = {}, ReadyAction onReady = {}) const {
+				auto subscription = std::make_shared<StreamSubscription<Tmsg>>(std::move(onNext), policy, std::move(onReady));
+				MessageObserver<Tmsg, _StreamResult<Tmsg>>::_obs->add(subscription);
+				return subscription;
+			}
+
+			/**
+			 * <summary>Deliver this stream's values on the given executor, through a buffer with the given policy.</summary>
+			 *
+			 * At most one drain of the buffer is queued on the executor at any time, so values arrive in order
+			 * even on a thread pool, and a slow consumer only holds up itself. Each drain delivers at most a
+			 * buffer's worth before queueing the next, so a busy stream doesn't hog a pool thread.
+			 */
+			template <Executor Texec>
+			StreamResult<Tmsg> observeOn(Texec& executor, BufferPolicy policy = {}) const {
+				StreamResult<Tmsg> downstream;
+				auto subscription = std::make_shared<StreamSubscription<Tmsg>>([downstream](const Tmsg& msg) { downstream.onNext(msg); }, policy, ReadyAction{});
+				const size_t batch{ subscription->capacity() };
+				subscription->withOnError([downstream](std::exception_ptr err) { downstream.onError(err); })
+					.withOnComplete([downstream]() { downstream.onCompleted(); })
+					.withOnReady([weak = std::weak_ptr<StreamSubscription<Tmsg>>(subscription), &executor, batch]() {
+						executor.execute([weak, batch]() {
+							if (auto s = weak.lock()) {
+								s->drain(batch);
+							}
+						});
+					});
+				MessageObserver<Tmsg, _StreamResult<Tmsg>>::_obs->add(std::move(subscription));
+				return downstream;
+			}
+
+			inline void unsubscribe(const Subscription& subscription) const {
+				MessageObserver<Tmsg, _StreamResult<Tmsg>>::_obs->remove(subscription);
+			}
+
+			inline StreamStats stats() const noexcept {
+				return MessageObserver<Tmsg, _StreamResult<Tmsg>>::_obs->stats();
+			}
+
+			// Operators. Each returns a new stream that receives what remains of this one.
+
+			/**
+			 * <summary>Pass on a value, then ignore the values that follow it within the period.</summary>
+			 */
+			template <typename Repr, typename Period>
+			StreamResult<Tmsg> throttle(std::chrono::duration<Repr, Period> period) const {
+				StreamResult<Tmsg> downstream;
+				return connect(std::make_shared<ThrottleOperator<Tmsg, StreamResult<Tmsg>>>(downstream, toClock(period)), downstream);
+			}
+
+			/**
+			 * <summary>Pass on the latest value once every period, if a new one arrived since the last.</summary>
+			 * The timer pauses while the result has no subscribers, and stops when it completes.
+			 */
+			template <typename Repr, typename Period>
+			StreamResult<Tmsg> sample(std::chrono::duration<Repr, Period> period, TimerQueue& timers = TimerQueue::shared()) const {
+				StreamResult<Tmsg> downstream;
+				auto op = std::make_shared<SampleOperator<Tmsg, StreamResult<Tmsg>>>(downstream, timers, toClock(period));
+				op->schedule(TimerQueue::Clock::now() + toClock(period));
+				return connect(std::move(op), downstream);
+			}
+
+			/**
+			 * <summary>Pass on a value once no newer one arrived for a full period.</summary>
+			 */
+			template <typename Repr, typename Period>
+			StreamResult<Tmsg> debounce(std::chrono::duration<Repr, Period> period, TimerQueue& timers = TimerQueue::shared()) const {
+				StreamResult<Tmsg> downstream;
+				return connect(std::make_shared<DebounceOperator<Tmsg, StreamResult<Tmsg>>>(downstream, timers, toClock(period)), downstream);
+			}
+
+			/**
+			 * <summary>Only pass on values that differ from the last one passed on.</summary>
+			 */
+			StreamResult<Tmsg> distinctUntilChanged() const requires std::equality_comparable<Tmsg> {
+				return distinctUntilChanged(std::equal_to<Tmsg>{});
+			}
+			/**
+			 * <summary>Only pass on values that differ by more than <c>epsilon</c> from the last one passed on,
+			 * so slow drift still comes through but jitter does not.</summary>
+			 */
+			StreamResult<Tmsg> distinctUntilChanged(Tmsg epsilon) const requires std::floating_point<Tmsg> {
+				return distinctUntilChanged([epsilon](const Tmsg& lhs, const Tmsg& rhs) { return std::abs(lhs - rhs) <= epsilon; });
+			}
+			template <typename Tequal>
+				requires std::predicate<Tequal, const Tmsg&, const Tmsg&>
+			StreamResult<Tmsg> distinctUntilChanged(Tequal equal) const {
+				StreamResult<Tmsg> downstream;
+				return connect(std::make_shared<DistinctOperator<Tmsg, StreamResult<Tmsg>, Tequal>>(downstream, std::move(equal)), downstream);
+			}
+
+			/**
+			 * <summary>Pass on values in batches of <c>count</c>. Completion passes on what remains.</summary>
+			 */
+			StreamResult<std::vector<Tmsg>> buffer(size_t count) const {
+				StreamResult<std::vector<Tmsg>> downstream;
+				return connect(std::make_shared<CountBufferOperator<Tmsg, StreamResult<std::vector<Tmsg>>>>(downstream, count), downstream);
+			}
+			/**
+			 * <summary>Pass on the values that arrived in each period as one batch. <c>expected</c> is the batch
+			 * size to reserve room for up front.</summary>
+			 * Batches collected while the result has no subscribers are dropped, and the timer pauses until the next value.
+			 */
+			template <typename Repr, typename Period>
+			StreamResult<std::vector<Tmsg>> buffer(std::chrono::duration<Repr, Period> period, TimerQueue& timers = TimerQueue::shared(), size_t expected = 64) const {
+				StreamResult<std::vector<Tmsg>> downstream;
+				auto op = std::make_shared<TimeBufferOperator<Tmsg, StreamResult<std::vector<Tmsg>>>>(downstream, timers, toClock(period), expected);
+				op->schedule(TimerQueue::Clock::now() + toClock(period));
+				return connect(std::move(op), downstream);
+			}
+
+		private:
+			template <typename Repr, typename Period>
+			static inline TimerQueue::Clock::duration toClock(std::chrono::duration<Repr, Period> period) {
+				return std::chrono::duration_cast<TimerQueue::Clock::duration>(period);
+			}
 
+			// The operator lives as long as our callbacks do, and only refers to its downstream.
+			template <typename Top, typename Tout>
+			Tout connect(std::shared_ptr<Top> op, Tout downstream) const {
+				this->withOnNext([op](const Tmsg& msg) { op->onNext(msg); });
+				this->withOnError([op](std::exception_ptr err) { op->onError(err); });
+				this->withOnComplete([op]() { op->onCompleted(); });
+				return downstream;
+			}
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "Executor.h"
+
+
+namespace CppSimConnect {
+	namespace Reactive {
+
+		/**
+		 * <summary>Runs tasks one at a time, in order, on a thread of its own.</summary>
+		 *
+		 * Tasks still queued when the executor is destroyed are dropped.
+		 */
+		class ThreadExecutor {
+			std::mutex _lock;
+			std::condition_variable_any _available;
+			std::vector<Task> _queued;
+			std::vector<Task> _running;		// Swapped with _queued, so both keep their capacity
+			std::jthread _thread;
+
+			void run(std::stop_token stop) {
+				std::unique_lock<std::mutex> lock(_lock);
+				while (_available.wait(lock, stop, [this]() { return !_queued.empty(); })) {
+					_queued.swap(_running);
+					lock.unlock();
+					for (auto& task : _running) {
+						try {
+							task();
+						}
+						catch (...) {
+							// Tasks report their own errors; one failing must not stop the others.
+						}
+					}
+					_running.clear();
+					lock.lock();
+				}
+			}
+
+		public:
+			explicit ThreadExecutor(size_t expectedTasks = 256) {
+				_queued.reserve(expectedTasks);
+				_running.reserve(expectedTasks);
+				_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+			}
+			~ThreadExecutor() = default;	// The jthread stops and joins
+			ThreadExecutor(const ThreadExecutor&) = delete;
+			ThreadExecutor(ThreadExecutor&&) = delete;
+			ThreadExecutor& operator=(const ThreadExecutor&) = delete;
+			ThreadExecutor& operator=(ThreadExecutor&&) = delete;
+
+			void execute(Task task) {
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					_queued.push_back(std::move(task));
+				}
+				_available.notify_one();
+			}
+
+			inline bool onExecutorThread() const noexcept { return std::this_thread::get_id() == _thread.get_id(); }
+		};
+	}
+}
\ No newline at end of file
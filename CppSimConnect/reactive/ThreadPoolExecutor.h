@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "Executor.h"
+
+
+namespace CppSimConnect {
+	namespace Reactive {
+
+		/**
+		 * <summary>Runs tasks on a pool of threads that steal work from each other.</summary>
+		 *
+		 * Every worker has its own queue. Tasks submitted by a worker go to its own queue, others are spread
+		 * over the workers in turn. A worker takes tasks from the front of its own queue, and when that is
+		 * empty steals from the back of another's. Tasks may run in any order and in parallel; a stream's
+		 * observeOn() only ever has one drain queued, so its values still arrive in order.
+		 *
+		 * Tasks still queued when the pool is destroyed are run first, along with any they queue in turn, so
+		 * no observeOn() drain is lost. Tasks that keep queueing more keep the destructor waiting.
+		 */
+		class ThreadPoolExecutor {
+			struct Worker {
+				std::mutex lock;
+				std::deque<Task> tasks;
+			};
+
+			std::vector<std::unique_ptr<Worker>> _workers;
+			std::atomic<size_t> _nextWorker{ 0 };
+			std::atomic<size_t> _queued{ 0 };
+			std::atomic<std::uint64_t> _stolen{ 0 };
+
+			std::mutex _sleepLock;
+			std::condition_variable_any _available;
+			std::vector<std::jthread> _threads;
+
+			static inline thread_local ThreadPoolExecutor* _currentPool{ nullptr };
+			static inline thread_local size_t _currentWorker{ 0 };
+
+			bool take(Worker& worker, Task& task, bool fromBack) {
+				std::lock_guard<std::mutex> lock(worker.lock);
+				if (worker.tasks.empty()) {
+					return false;
+				}
+				if (fromBack) {
+					task = std::move(worker.tasks.back());
+					worker.tasks.pop_back();
+				}
+				else {
+					task = std::move(worker.tasks.front());
+					worker.tasks.pop_front();
+				}
+				_queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+
+			bool next(size_t index, Task& task) {
+				if (take(*_workers[index], task, false)) {
+					return true;
+				}
+				for (size_t i = 1; i < _workers.size(); i++) {
+					if (take(*_workers[(index + i) % _workers.size()], task, true)) {
+						_stolen.fetch_add(1, std::memory_order_relaxed);
+						return true;
+					}
+				}
+				return false;
+			}
+
+			// Once stopped, a worker keeps going until it finds no task in any queue.
+			void run(std::stop_token stop, size_t index) {
+				_currentPool = this;
+				_currentWorker = index;
+
+				Task task;
+				while (true) {
+					if (next(index, task)) {
+						try {
+							task();
+						}
+						catch (...) {
+							// Tasks report their own errors; one failing must not stop the others.
+						}
+						task = Task();
+						continue;
+					}
+					if (stop.stop_requested()) {
+						break;
+					}
+					std::unique_lock<std::mutex> lock(_sleepLock);
+					_available.wait(lock, stop, [this]() { return _queued.load(std::memory_order_relaxed) > 0; });
+				}
+			}
+
+		public:
+			explicit ThreadPoolExecutor(size_t threads = std::thread::hardware_concurrency()) {
+				threads = std::max<size_t>(threads, 1);
+				for (size_t i = 0; i < threads; i++) {
+					_workers.push_back(std::make_unique<Worker>());
+				}
+				for (size_t i = 0; i < threads; i++) {
+					_threads.emplace_back([this, i](std::stop_token stop) { run(stop, i); });
+				}
+			}
+			~ThreadPoolExecutor() {
+				for (auto& thread : _threads) {
+					thread.request_stop();
+				}
+				_available.notify_all();
+			}
+			ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+			ThreadPoolExecutor(ThreadPoolExecutor&&) = delete;
+			ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+			ThreadPoolExecutor& operator=(ThreadPoolExecutor&&) = delete;
+
+			void execute(Task task) {
+				const size_t index{ (_currentPool == this) ? _currentWorker : (_nextWorker.fetch_add(1, std::memory_order_relaxed) % _workers.size()) };
+				{
+					// Counted under the same lock take() holds, so a worker never sees the count before the task.
+					std::lock_guard<std::mutex> lock(_workers[index]->lock);
+					_workers[index]->tasks.push_back(std::move(task));
+					_queued.fetch_add(1, std::memory_order_relaxed);
+				}
+				{
+					// A worker checks the count under this lock, so now it is either before its check, or waiting.
+					std::lock_guard<std::mutex> lock(_sleepLock);
+				}
+				_available.notify_one();
+			}
+
+			inline size_t threads() const noexcept { return _threads.size(); }
+			inline std::uint64_t stolen() const noexcept { return _stolen.load(std::memory_order_relaxed); }
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "Executor.h"
+
+
+namespace CppSimConnect {
+	namespace Reactive {
+
+		/**
+		 * <summary>Runs tasks at a given time, on its own thread.</summary>
+		 *
+		 * Timers are kept in a heap ordered by due time; tasks due at the same time run in the order they
+		 * were scheduled. Tasks should be short, as they delay every timer behind them.
+		 */
+		class TimerQueue {
+		public:
+			using Clock = std::chrono::steady_clock;
+
+		private:
+			struct Timer {
+				Clock::time_point due;
+				std::uint64_t sequence;
+				Task task;
+			};
+			static inline bool later(const Timer& lhs, const Timer& rhs) noexcept {
+				return (lhs.due > rhs.due) || ((lhs.due == rhs.due) && (lhs.sequence > rhs.sequence));
+			}
+
+			std::mutex _lock;
+			std::condition_variable_any _changed;
+			std::vector<Timer> _timers;
+			std::uint64_t _sequence{ 0 };
+			std::jthread _thread;
+
+			void run(std::stop_token stop) {
+				std::unique_lock<std::mutex> lock(_lock);
+				while (!stop.stop_requested()) {
+					if (_timers.empty()) {
+						_changed.wait(lock, stop, [this]() { return !_timers.empty(); });
+						continue;
+					}
+					const auto due{ _timers.front().due };
+					if (Clock::now() < due) {
+						_changed.wait_until(lock, stop, due, [this, due]() { return _timers.front().due < due; });
+						continue;
+					}
+					std::pop_heap(_timers.begin(), _timers.end(), later);
+					Task task{ std::move(_timers.back().task) };
+					_timers.pop_back();
+
+					lock.unlock();
+					try {
+						task();
+					}
+					catch (...) {
+						// A failing task must not take the timers of others down with it.
+					}
+					lock.lock();
+				}
+			}
+
+		public:
+			TimerQueue() {
+				_timers.reserve(64);
+				_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+			}
+			~TimerQueue() = default;	// The jthread stops and joins
+			TimerQueue(const TimerQueue&) = delete;
+			TimerQueue(TimerQueue&&) = delete;
+			TimerQueue& operator=(const TimerQueue&) = delete;
+			TimerQueue& operator=(TimerQueue&&) = delete;
+
+			void schedule(Clock::time_point due, Task task) {
+				{
+					std::lock_guard<std::mutex> lock(_lock);
+					_timers.push_back(Timer{ due, _sequence++, std::move(task) });
+					std::push_heap(_timers.begin(), _timers.end(), later);
+				}
+				_changed.notify_one();
+			}
+
+			inline size_t pending() {
+				std::lock_guard<std::mutex> lock(_lock);
+				return _timers.size();
+			}
+
+			/**
+			 * <summary>The timer queue operators use unless given another.</summary>
+			 */
+			static TimerQueue& shared() {
+				static TimerQueue timers;
+				return timers;
+			}
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "MessageResult.h"
+
+
+namespace CppSimConnect {
+	namespace Reactive {
+
+		namespace detail {
+
+			// Values are collected when each result completes, so results that have already completed count too.
+			template <typename Tresult, typename Tvalues>
+			struct WhenAllState {
+				MessageResult<Tresult> result;
+				Tvalues values;
+				std::atomic<size_t> remaining;
+
+				WhenAllState(size_t count) : remaining{ count } {}
+			};
+
+			template <typename Tstate, typename Tmsg, typename Tstore>
+			void whenAllAdd(const std::shared_ptr<Tstate>& state, const MessageResult<Tmsg>& input, Tstore store) {
+				const _MessageResult<Tmsg>* obs{ &input.obs() };
+				input.withOnComplete([state, obs, store]() {
+					try {
+						store(*state, obs->get());
+					}
+					catch (...) {
+						state->result.onError(std::current_exception());
+					}
+					if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+						state->finish();
+					}
+				});
+			}
+		}
+
+		/**
+		 * <summary>Combine several results into one that completes with all their values, or with the first error.</summary>
+		 */
+		template <typename... Ts>
+		MessageResult<std::tuple<Ts...>> whenAll(const MessageResult<Ts>&... inputs) {
+			static_assert(sizeof...(Ts) > 0, "whenAll() needs at least one result.");
+
+			struct State : detail::WhenAllState<std::tuple<Ts...>, std::tuple<std::optional<Ts>...>> {
+				State() : detail::WhenAllState<std::tuple<Ts...>, std::tuple<std::optional<Ts>...>>(sizeof...(Ts)) {}
+
+				void finish() {
+					if (!this->result.completed()) {
+						this->result.onNext(std::apply([](auto&... value) { return std::tuple<Ts...>{ std::move(*value)... }; }, this->values));
+					}
+				}
+			};
+			auto state = std::make_shared<State>();
+			MessageResult<std::tuple<Ts...>> result{ state->result };
+
+			[&state, &inputs...]<size_t... I>(std::index_sequence<I...>) {
+				(detail::whenAllAdd(state, inputs, [](State& s, const Ts& value) { std::get<I>(s.values) = value; }), ...);
+			}(std::index_sequence_for<Ts...>{});
+
+			return result;
+		}
+
+		/**
+		 * <summary>Combine a batch of results into one that completes with all their values in order, or with the first error.</summary>
+		 */
+		template <typename T>
+		MessageResult<std::vector<T>> whenAll(const std::vector<MessageResult<T>>& inputs) {
+			struct State : detail::WhenAllState<std::vector<T>, std::vector<std::optional<T>>> {
+				State(size_t count) : detail::WhenAllState<std::vector<T>, std::vector<std::optional<T>>>(count) {
+					this->values.resize(count);
+				}
+
+				void finish() {
+					if (!this->result.completed()) {
+						std::vector<T> values;
+						values.reserve(this->values.size());
+						for (auto& value : this->values) {
+							values.push_back(std::move(*value));
+						}
+						this->result.onNext(values);
+					}
+				}
+			};
+			auto state = std::make_shared<State>(inputs.size());
+			MessageResult<std::vector<T>> result{ state->result };
+
+			if (inputs.empty()) {
+				state->finish();
+			}
+			for (size_t i = 0; i < inputs.size(); i++) {
+				detail::whenAllAdd(state, inputs[i], [i](State& s, const T& value) { s.values[i] = value; });
+			}
+			return result;
+		}
+	}
+}
\ No newline at end of file
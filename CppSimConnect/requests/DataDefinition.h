@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>How a simulation variable is sent. The values are those of <c>SIMCONNECT_DATATYPE</c>.</summary>
+	 */
+	enum class DataType : std::uint32_t {
+		Int32 = 1,
+		Int64 = 2,
+		Float32 = 3,
+		Float64 = 4,
+		String8 = 5,
+		String32 = 6,
+		String64 = 7,
+		String128 = 8,
+		String256 = 9,
+		String260 = 10,
+	};
+
+	inline constexpr std::uint32_t UserObjectId{ 0 };		// SIMCONNECT_OBJECT_ID_USER
+
+	/**
+	 * <summary>How often a subscribed data definition is sent. The values are those of <c>SIMCONNECT_PERIOD</c>.</summary>
+	 */
+	enum class DataPeriod : std::uint32_t {
+		VisualFrame = 2,
+		SimFrame = 3,
+		Second = 4,
+	};
+
+	/**
+	 * <summary>The DataType a struct member of type <c>F</c> is sent as. Strings are fixed-size char arrays.</summary>
+	 */
+	template <typename F>
+	consteval DataType dataTypeOf() {
+		if constexpr (std::is_same_v<F, std::int32_t>) { return DataType::Int32; }
+		else if constexpr (std::is_same_v<F, std::int64_t>) { return DataType::Int64; }
+		else if constexpr (std::is_same_v<F, float>) { return DataType::Float32; }
+		else if constexpr (std::is_same_v<F, double>) { return DataType::Float64; }
+		else if constexpr (std::is_same_v<F, char[8]>) { return DataType::String8; }
+		else if constexpr (std::is_same_v<F, char[32]>) { return DataType::String32; }
+		else if constexpr (std::is_same_v<F, char[64]>) { return DataType::String64; }
+		else if constexpr (std::is_same_v<F, char[128]>) { return DataType::String128; }
+		else if constexpr (std::is_same_v<F, char[256]>) { return DataType::String256; }
+		else if constexpr (std::is_same_v<F, char[260]>) { return DataType::String260; }
+		else { static_assert(sizeof(F) == 0, "Data definition fields must be int32_t, int64_t, float, double, or char[8|32|64|128|256|260]."); }
+	}
+
+	/**
+	 * <summary>One member of a data definition struct, with the simulation variable that fills it.</summary>
+	 * The unit is ignored for strings. The epsilon is the smallest change that counts as a change.
+	 */
+	template <typename T, typename F>
+	struct DataField {
+		F T::* member;
+		std::string_view name;
+		std::string_view unit;
+		float epsilon{ 0.0f };
+	};
+
+	template <typename T, typename F>
+	constexpr DataField<T, F> field(F T::* member, std::string_view name, std::string_view unit = {}, float epsilon = 0.0f) {
+		return { member, name, unit, epsilon };
+	}
+
+	/**
+	 * <summary>Describes a struct as a SimConnect data definition. Specialize it for each struct, with a
+	 * <c>fields</c> tuple made with <c>field()</c>, listing every member in declaration order:</summary>
+	 *
+	 * <code>
+	 * struct Position { double latitude; double longitude; double altitude; };
+	 *
+	 * template <> struct CppSimConnect::DataDefinition<Position> {
+	 *     static constexpr auto fields{ std::make_tuple(
+	 *         field(&Position::latitude, "PLANE LATITUDE", "degrees"),
+	 *         field(&Position::longitude, "PLANE LONGITUDE", "degrees"),
+	 *         field(&Position::altitude, "PLANE ALTITUDE", "feet")) };
+	 * };
+	 * </code>
+	 *
+	 * SimConnect sends the values packed, so the struct is used as a view on the received data. That only works if
+	 * the members follow each other without padding; use <c>#pragma pack(push, 1)</c> when mixing sizes.
+	 */
+	template <typename T>
+	struct DataDefinition;
+
+	template <typename T>
+	concept DataStruct = std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T> && requires {
+		{ std::tuple_size<std::remove_cvref_t<decltype(DataDefinition<T>::fields)>>::value };
+	};
+
+	/**
+	 * <summary>A simulation variable in a data definition, at run time.</summary>
+	 */
+	struct DataDatum {
+		std::string name;
+		std::string unit;
+		DataType type;
+		float epsilon;
+		std::uint32_t offset;
+		std::uint32_t size;
+	};
+
+	/**
+	 * <summary>The run-time form of a DataDefinition. There is one per struct, whose address identifies it.</summary>
+	 */
+	class DataLayout {
+		std::vector<DataDatum> _data;
+		size_t _size;
+
+	public:
+		DataLayout(std::vector<DataDatum> data, size_t size) : _data(std::move(data)), _size{ size } {}
+		~DataLayout() = default;
+		DataLayout(DataLayout const&) = delete;
+		DataLayout(DataLayout&&) = delete;
+		DataLayout& operator=(DataLayout const&) = delete;
+		DataLayout& operator=(DataLayout&&) = delete;
+
+		inline const std::vector<DataDatum>& data() const noexcept { return _data; }
+		inline size_t size() const noexcept { return _size; }
+
+		/**
+		 * <summary>Copy tagged data, where each value follows its datum ID, into a struct with this layout, and mark
+		 * the fields it carried. Returns false if the data does not match the layout.</summary>
+		 */
+		bool applyTagged(std::byte* target, const std::byte* data, size_t size, std::uint32_t count, std::uint64_t& fields) const noexcept {
+			size_t pos{ 0 };
+			for (std::uint32_t i = 0; i < count; i++) {
+				std::uint32_t datumId;
+				if ((pos + sizeof(datumId)) > size) {
+					return false;
+				}
+				std::memcpy(&datumId, data + pos, sizeof(datumId));
+				pos += sizeof(datumId);
+				if ((datumId >= _data.size()) || ((pos + _data[datumId].size) > size)) {
+					return false;
+				}
+				std::memcpy(target + _data[datumId].offset, data + pos, _data[datumId].size);
+				pos += _data[datumId].size;
+				fields |= std::uint64_t{ 1 } << datumId;
+			}
+			return true;
+		}
+	};
+
+	/**
+	 * <summary>A value of a tagged subscription: the struct with all values received so far, and which of its fields
+	 * changed in this update. Fields are numbered in the order of their DataDefinition.</summary>
+	 */
+	template <typename T>
+	struct DataUpdate {
+		T value;
+		std::uint64_t fields{ 0 };
+
+		inline bool changed(size_t index) const noexcept { return (fields & (std::uint64_t{ 1 } << index)) != 0; }
+		inline size_t changedCount() const noexcept { return static_cast<size_t>(std::popcount(fields)); }
+	};
+
+	template <DataStruct T>
+	consteval size_t dataFieldCount() {
+		return std::tuple_size_v<std::remove_cvref_t<decltype(DataDefinition<T>::fields)>>;
+	}
+
+	template <DataStruct T>
+	consteval size_t dataFieldsSize() {
+		return std::apply([](const auto&... fields) {
+			return (size_t{ 0 } + ... + sizeof(std::remove_cvref_t<decltype(std::declval<T>().*(fields.member))>));
+		}, DataDefinition<T>::fields);
+	}
+
+	/**
+	 * <summary>The layout of a data definition struct, built and checked on first use.</summary>
+	 * Throws std::logic_error if the fields are not listed in declaration order.
+	 */
+	template <DataStruct T>
+	const DataLayout& dataLayout() {
+		static_assert(dataFieldsSize<T>() == sizeof(T), "The DataDefinition must list all members of the struct, which must not contain padding.");
+
+		static const DataLayout layout{ []() {
+			static const T probe{};
+			const auto base{ reinterpret_cast<const std::byte*>(&probe) };
+
+			std::vector<DataDatum> data;
+			size_t offset{ 0 };
+			std::apply([&](const auto&... fields) {
+				([&](const auto& field) {
+					using F = std::remove_cvref_t<decltype(probe.*(field.member))>;
+					const auto fieldOffset{ static_cast<size_t>(reinterpret_cast<const std::byte*>(&(probe.*(field.member))) - base) };
+					if (fieldOffset != offset) {
+						throw std::logic_error(std::string("The DataDefinition of ") + typeid(T).name() + " does not list its members in declaration order.");
+					}
+					data.push_back({ std::string(field.name), std::string(field.unit), dataTypeOf<F>(), field.epsilon, static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(sizeof(F)) });
+					offset += sizeof(F);
+				}(fields), ...);
+			}, DataDefinition<T>::fields);
+
+			return DataLayout(std::move(data), sizeof(T));
+		}() };
+		return layout;
+	}
+}
\ No newline at end of file
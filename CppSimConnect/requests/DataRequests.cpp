@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../pch.h"
+
+#include "../exceptions/NotConnected.h"
+
+#include "../sim/SimState.h"
+
+using CppSimConnect::DataLayout;
+using CppSimConnect::DataPeriod;
+using CppSimConnect::SimConnect;
+using CppSimConnect::SimException;
+using CppSimConnect::SimState;
+
+
+void SimConnect::simRequestData(const DataLayout& layout, std::uint32_t objectId,
+								std::function<void(const std::byte* data)> onData, std::function<void(std::exception_ptr err)> onError) {
+	if (!connected()) {
+		onError(std::make_exception_ptr(NotConnected()));
+		return;
+	}
+	const DWORD defineId{ _state->dataDefinition(layout) };
+
+	RecvObserver obs;
+	auto reqId = _state->registerRequestResultObserver(obs);
+	_logger.debug("Requesting data definition {} for object {} with RequestID {}", defineId, objectId, reqId);
+	const size_t size{ layout.size() };
+	obs.subscribe([this, reqId, size, onData, onError](SIMCONNECT_RECV* msg) {
+		_state->deRegisterRequestResultObserver(reqId);
+		const std::byte* data{ SimState::simObjectData(msg, size) };
+		if (data == nullptr) {
+			onError(std::make_exception_ptr(SimException(SIMCONNECT_EXCEPTION_SIZE_MISMATCH, "Received less data than the definition holds.", 0)));
+			return;
+		}
+		onData(data);
+	}, [this, reqId, onError](std::exception_ptr err) {
+		_state->deRegisterRequestResultObserver(reqId);
+		onError(err);
+	});
+	_state->simRequestDataOnSimObject(reqId, defineId, objectId, SIMCONNECT_PERIOD_ONCE, 0, obs);
+}
+
+std::function<void()> SimConnect::simSubscribeData(const DataLayout& layout, std::uint32_t objectId, DataPeriod period, bool changedOnly, bool tagged,
+												   std::function<void(std::span<const std::byte> data, std::uint32_t count)> onData,
+												   std::function<void(std::exception_ptr err)> onError) {
+	if (!connected()) {
+		onError(std::make_exception_ptr(NotConnected()));
+		return []() {};
+	}
+	SimState* state{ _state.get() };
+	const DWORD defineId{ state->dataDefinition(layout) };
+
+	// The stream stays registered until it is cancelled, unlike a single request.
+	RecvObserver obs;
+	auto reqId = state->registerRequestResultObserver(obs);
+	_logger.debug("Subscribing to data definition {} for object {} with RequestID {}", defineId, objectId, reqId);
+	const size_t size{ layout.size() };
+	obs.subscribe([this, size, tagged, onData](SIMCONNECT_RECV* msg) {
+		const auto& data{ *static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA*>(msg) };
+		const auto values{ simObjectDataView(data) };
+		if (tagged) {
+			onData(values, data.dwDefineCount);
+		}
+		else if (values.size() >= size) {
+			onData(values.first(size), data.dwDefineCount);
+		}
+		else {
+			_logger.warn("Ignoring data for RequestID {} that is shorter than its definition.", data.dwRequestID);
+		}
+	}, onError);
+
+	DWORD flags{ changedOnly ? static_cast<DWORD>(SIMCONNECT_DATA_REQUEST_FLAG_CHANGED) : 0 };
+	if (tagged) {
+		flags |= SIMCONNECT_DATA_REQUEST_FLAG_TAGGED;
+	}
+	state->simRequestDataOnSimObject(reqId, defineId, objectId, static_cast<SIMCONNECT_PERIOD>(period), flags, obs);
+
+	// The stream may outlive this client and its connection, so the cancel holds neither, and checks both are still there.
+	// The connection is checked under the lock that covers replacing _state, so it can't go away while we use it.
+	auto cancelled = std::make_shared<std::atomic_bool>(false);
+	return [client = weakThis(), connection = state->token(), reqId, defineId, objectId, cancelled]() {
+		auto self = client.lock();
+		if (cancelled->exchange(true) || !self || !self->connected()) {
+			return;
+		}
+		std::lock_guard lock(self->_clientEventLock);
+		SimState* state{ self->_state.get() };
+		const auto token{ connection.lock() };
+		if (!token || (state == nullptr) || (*token != state)) {
+			return;
+		}
+		if (!state->deRegisterRequestResultObserver(reqId)) {
+			return;		// Already ended, as the connection is going away
+		}
+		self->_logger.debug("Cancelling subscription with RequestID {}", reqId);
+		state->submit(
+			[reqId, defineId, objectId](SimBackend& backend) { return backend.requestDataOnSimObject(reqId, defineId, objectId, SIMCONNECT_PERIOD_NEVER, 0, 0, 0, 0); },
+			[self = self.get(), reqId](unsigned, std::string const& msg, unsigned) { self->_logger.warn("Failed to cancel subscription with RequestID {}. ({})", reqId, msg); });
+	};
+}
\ No newline at end of file
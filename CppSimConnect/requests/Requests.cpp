@@ -20,50 +20,115 @@
 
 #include "../exceptions/NotConnected.h"
 
+#include "../sim/RecvViews.h"
 #include "../sim/SimState.h"
 
 #include "../reactive/MessageResult.h"
 
 using CppSimConnect::SimConnect;
+using CppSimConnect::systemStateView;
 using CppSimConnect::Reactive::MessageResult;
 
 
 MessageResult<std::string> SimConnect::simRequestSystemStateString(const std::string& stateName) {
 	MessageResult<std::string> result;
+	simRequestSystemStateString(stateName, result);
+	return result;
+}
 
+void SimConnect::simRequestSystemStateString(const std::string& stateName, MessageResult<std::string> result) {
 	if (connected()) {
-		auto reqId = nextReqId();
+		auto cached = _state->systemStateCache().stringState(stateName);
+		if (cached != nullptr) {
+			if (auto value = cached->get()) {
+				_state->systemStateCache().hit();
+				result.onNext(*value);
+				return;
+			}
+		}
+		if (!_state->stringStateFlights().join(stateName, result)) {
+			_logger.debug("Joining outstanding request for string value '{}'", stateName);
+			return;
+		}
+		RecvObserver obs;
+		auto reqId = _state->registerRequestResultObserver(obs);
 		_logger.debug("Requesting string value for '{}' with RequestID {}", stateName, reqId);
-
-		RecvObserver obs(_state->simRequestSimState(reqId, stateName));
-		result.withOnComplete([reqId,this]() { _state->deRegisterRequestResultObserver(reqId); });
-		obs.subscribe([result](SIMCONNECT_RECV* msg) {
-			std::string value(static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msg)->szString);
-			result.onNext(value);
+		const std::uint64_t generation{ (cached != nullptr) ? cached->generation() : 0 };
+		obs.subscribe([this, reqId, stateName, cached, generation](SIMCONNECT_RECV* msg) {
+			const auto value{ systemStateView(*static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msg)).materialize() };
+			_state->deRegisterRequestResultObserver(reqId);
+			if (cached != nullptr) {
+				cached->store(generation, value);
+			}
+			_state->stringStateFlights().complete(stateName, value);
+		}, [this, reqId, stateName](std::exception_ptr err) {
+			_state->deRegisterRequestResultObserver(reqId);
+			_state->stringStateFlights().fail(stateName, err);
 		});
+		_state->simRequestSimState(reqId, stateName, obs);
 	}
 	else {
 		result.onError(std::make_exception_ptr(NotConnected()));
 	}
-	return result;
 }
 
 MessageResult<bool> SimConnect::simRequestSystemStateBool(const std::string& stateName) {
 	MessageResult<bool> result;
+	simRequestSystemStateBool(stateName, result);
+	return result;
+}
 
+void SimConnect::simRequestSystemStateBool(const std::string& stateName, MessageResult<bool> result) {
 	if (connected()) {
-		auto reqId = nextReqId();
+		auto cached = _state->systemStateCache().boolState(stateName);
+		if (cached != nullptr) {
+			if (auto value = cached->get()) {
+				_state->systemStateCache().hit();
+				result.onNext(*value);
+				return;
+			}
+		}
+		if (!_state->boolStateFlights().join(stateName, result)) {
+			_logger.debug("Joining outstanding request for boolean value '{}'", stateName);
+			return;
+		}
+		RecvObserver obs;
+		auto reqId = _state->registerRequestResultObserver(obs);
 		_logger.debug("Requesting boolean value for '{}' with RequestID {}", stateName, reqId);
-
-		RecvObserver obs(_state->simRequestSimState(reqId, stateName));
-		result.withOnComplete([reqId, this]() { _state->deRegisterRequestResultObserver(reqId); });
-		obs.subscribe([result](SIMCONNECT_RECV* msg) {
-			bool value{ (static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msg)->dwInteger) != 0 };
-			result.onNext(value);
+		const std::uint64_t generation{ (cached != nullptr) ? cached->generation() : 0 };
+		obs.subscribe([this, reqId, stateName, cached, generation](SIMCONNECT_RECV* msg) {
+			const bool value{ systemStateView(*static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msg)).boolean() };
+			_state->deRegisterRequestResultObserver(reqId);
+			if (cached != nullptr) {
+				cached->store(generation, value);
+			}
+			_state->boolStateFlights().complete(stateName, value);
+		}, [this, reqId, stateName](std::exception_ptr err) {
+			_state->deRegisterRequestResultObserver(reqId);
+			_state->boolStateFlights().fail(stateName, err);
 		});
+		_state->simRequestSimState(reqId, stateName, obs);
 	}
 	else {
 		result.onError(std::make_exception_ptr(NotConnected()));
 	}
-	return result;
+}
+
+void SimConnect::requestSystemState(SystemState state, std::function<void(messages::SystemStateView const& view)> onState, std::function<void(std::exception_ptr err)> onError) {
+	if (!connected()) {
+		onError(std::make_exception_ptr(NotConnected()));
+		return;
+	}
+	RecvObserver obs;
+	auto reqId = _state->registerRequestResultObserver(obs);
+	const auto stateName{ systemStateName(state) };
+	_logger.debug("Requesting '{}' with RequestID {}", stateName, reqId);
+	obs.subscribe([this, reqId, onState](SIMCONNECT_RECV* msg) {
+		_state->deRegisterRequestResultObserver(reqId);
+		onState(systemStateView(*static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msg)));
+	}, [this, reqId, onError](std::exception_ptr err) {
+		_state->deRegisterRequestResultObserver(reqId);
+		onError(err);
+	});
+	_state->simRequestSimState(reqId, stateName, obs);
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../reactive/MessageResult.h"
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>Lets identical requests that overlap in time share a single round trip to the simulator.</summary>
+	 *
+	 * The first caller for a key becomes the leader and sends the request; callers arriving before the
+	 * reply is in only add their result to the list of waiters. The reply is delivered to all of them.
+	 * The entry is removed under the same lock that callers join on, so a caller either gets the reply
+	 * or starts a new request.
+	 */
+	template <typename T>
+	class SingleFlight {
+		std::mutex _mutex;
+		std::map<std::string, std::vector<Reactive::MessageResult<T>>, std::less<>> _inFlight;
+
+		std::atomic<std::uint64_t> _issued{ 0 };
+		std::atomic<std::uint64_t> _coalesced{ 0 };
+
+		std::vector<Reactive::MessageResult<T>> land(const std::string& key) {
+			std::vector<Reactive::MessageResult<T>> waiters;
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			auto it = _inFlight.find(key);
+			if (it != _inFlight.end()) {
+				waiters = std::move(it->second);
+				_inFlight.erase(it);
+			}
+			return waiters;
+		}
+
+	public:
+		/**
+		 * <summary>Add the result to the request for this key. Returns true if the caller has to send the request.</summary>
+		 */
+		bool join(const std::string& key, Reactive::MessageResult<T> result) {
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			auto [it, isNew] = _inFlight.try_emplace(key);
+			it->second.push_back(std::move(result));
+			(isNew ? _issued : _coalesced).fetch_add(1, std::memory_order_relaxed);
+
+			return isNew;
+		}
+
+		void complete(const std::string& key, const T& value) {
+			for (auto& waiter : land(key)) {
+				waiter.onNext(value);
+			}
+		}
+
+		void fail(const std::string& key, std::exception_ptr err) {
+			for (auto& waiter : land(key)) {
+				waiter.onError(err);
+			}
+		}
+
+		inline std::uint64_t issued() const noexcept { return _issued.load(std::memory_order_relaxed); }
+		inline std::uint64_t coalesced() const noexcept { return _coalesced.load(std::memory_order_relaxed); }
+	};
+}
\ No newline at end of file
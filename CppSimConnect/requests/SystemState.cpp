@@ -16,6 +16,11 @@
 
 #include "../pch.h"
 
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "../exceptions/NotConnected.h"
 #include "../reactive/MessageResult.h"
 
 
@@ -58,3 +63,96 @@ MessageResult<std::string> SimConnect::requestFlightPlan() {
 MessageResult<bool> SimConnect::requestUserFlying() {
 	return simRequestSystemStateBool(SystemStateName(SystemState::Sim));
 }
+
+
+namespace {
+	// Collects the replies for requestSystemStates() and completes the result with the last one.
+	struct SystemStatesCollector {
+		std::mutex mutex;
+		CppSimConnect::SystemStates states;
+		std::exception_ptr failure;			// Fails the whole result, for a state that has no field to put an error in
+		size_t outstanding;
+		MessageResult<CppSimConnect::SystemStates> result;
+
+		SystemStatesCollector(size_t count, MessageResult<CppSimConnect::SystemStates> res) : outstanding(count), result(std::move(res)) {}
+
+		template <typename T>
+		void set(std::optional<T> CppSimConnect::SystemStates::* field, const T& value) {
+			std::unique_lock lock(mutex);
+			states.*field = value;
+			done(lock);
+		}
+
+		void fail(CppSimConnect::SystemState state, std::exception_ptr err) {
+			std::unique_lock lock(mutex);
+			states.errors[static_cast<size_t>(state)] = err;
+			done(lock);
+		}
+
+		void failAll(std::exception_ptr err) {
+			std::unique_lock lock(mutex);
+			failure = err;
+			done(lock);
+		}
+
+		void done(std::unique_lock<std::mutex>& lock) {
+			if (--outstanding == 0) {
+				lock.unlock();
+				if (failure) {
+					result.onError(failure);
+				}
+				else {
+					result.onNext(states);
+				}
+			}
+		}
+	};
+
+	// The reply is subscribed to before it is requested, so it cannot complete unnoticed.
+	template <typename T>
+	MessageResult<T> collect(std::shared_ptr<SystemStatesCollector> collector, CppSimConnect::SystemState state,
+							 std::optional<T> CppSimConnect::SystemStates::* field)
+	{
+		MessageResult<T> reply;
+		reply.subscribe([collector, field](const T& value) { collector->set(field, value); },
+						[collector, state](std::exception_ptr err) { collector->fail(state, err); });
+		return reply;
+	}
+}
+
+MessageResult<CppSimConnect::SystemStates> SimConnect::requestSystemStates(std::initializer_list<SystemState> states) {
+	MessageResult<SystemStates> result;
+
+	if (!connected()) {
+		result.onError(std::make_exception_ptr(NotConnected()));
+		return result;
+	}
+	if (states.size() == 0) {
+		result.onNext(SystemStates{});
+		return result;
+	}
+	auto collector = std::make_shared<SystemStatesCollector>(states.size(), result);
+	for (auto state : states) {
+		switch (state) {
+		case SystemState::AircraftLoaded:
+			simRequestSystemStateString(SystemStateNames[static_cast<size_t>(state)], collect(collector, state, &SystemStates::aircraftLoaded));
+			break;
+		case SystemState::DialogMode:
+			simRequestSystemStateBool(SystemStateNames[static_cast<size_t>(state)], collect(collector, state, &SystemStates::dialogMode));
+			break;
+		case SystemState::FlightLoaded:
+			simRequestSystemStateString(SystemStateNames[static_cast<size_t>(state)], collect(collector, state, &SystemStates::flightLoaded));
+			break;
+		case SystemState::FlightPlan:
+			simRequestSystemStateString(SystemStateNames[static_cast<size_t>(state)], collect(collector, state, &SystemStates::flightPlan));
+			break;
+		case SystemState::Sim:
+			simRequestSystemStateBool(SystemStateNames[static_cast<size_t>(state)], collect(collector, state, &SystemStates::sim));
+			break;
+		default:
+			collector->failAll(std::make_exception_ptr(std::invalid_argument("Unknown system state " + std::to_string(static_cast<int>(state)))));
+			break;
+		}
+	}
+	return result;
+}
\ No newline at end of file
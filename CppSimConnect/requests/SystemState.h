@@ -17,6 +17,8 @@
 #pragma once
 
 #include <array>
+#include <exception>
+#include <optional>
 #include <string>
 
 namespace CppSimConnect {
@@ -28,6 +30,25 @@ namespace CppSimConnect {
 		FlightPlan,							// Currently loaded flightplan
 		Sim,								// Is the simulator running?
 	};
+	inline constexpr size_t SystemStateCount{ 5 };
+
+	/**
+	 * <summary>The values of several system states, as requested together with <c>SimConnect::requestSystemStates()</c>.</summary>
+	 *
+	 * Values that were not requested, or for which the simulator returned an exception, are empty. In the
+	 * latter case the exception is available through <c>error()</c>.
+	 */
+	struct SystemStates {
+		std::optional<std::string> aircraftLoaded;
+		std::optional<bool> dialogMode;
+		std::optional<std::string> flightLoaded;
+		std::optional<std::string> flightPlan;
+		std::optional<bool> sim;
+
+		std::array<std::exception_ptr, SystemStateCount> errors{};
+
+		inline std::exception_ptr error(SystemState state) const noexcept { return errors[static_cast<size_t>(state)]; }
+	};
 
 	enum class SystemEvent {
 		AircraftLoaded,						// User changed the aircraft
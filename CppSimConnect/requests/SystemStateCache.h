@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "SystemState.h"
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>A cached system-state value, kept up to date by system events.</summary>
+	 *
+	 * Every event that changes or invalidates the value bumps the generation. A reply to a request only
+	 * gets stored if no event arrived while it was in flight, so an older reply never overwrites a newer
+	 * value.
+	 */
+	template <typename T>
+	class CachedSystemState {
+		mutable std::mutex _mutex;
+		std::optional<T> _value;
+		std::uint64_t _generation{ 0 };
+		bool _enabled{ true };
+
+	public:
+		std::optional<T> get() const {
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _value;
+		}
+
+		std::uint64_t generation() const {
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _generation;
+		}
+
+		void store(std::uint64_t requestGeneration, const T& value) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_enabled && (requestGeneration == _generation)) {
+				_value = value;
+			}
+		}
+
+		void refresh(const T& value) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			_generation++;
+			if (_enabled) {
+				_value = value;
+			}
+		}
+
+		void invalidate() {
+			std::lock_guard<std::mutex> lock(_mutex);
+			_generation++;
+			_value.reset();
+		}
+
+		/**
+		 * <summary>Stop caching, for example because we could not subscribe to the events that keep the value valid.</summary>
+		 */
+		void disable() {
+			std::lock_guard<std::mutex> lock(_mutex);
+			_generation++;
+			_value.reset();
+			_enabled = false;
+		}
+	};
+
+	/**
+	 * <summary>The system states that change rarely enough to be worth caching, and the events that change them.</summary>
+	 */
+	class SystemStateCache {
+		CachedSystemState<std::string> _aircraftLoaded;
+		CachedSystemState<std::string> _flightLoaded;
+		CachedSystemState<std::string> _flightPlan;
+		CachedSystemState<bool> _sim;
+
+		std::atomic<std::uint64_t> _hits{ 0 };
+
+	public:
+		inline CachedSystemState<std::string>* stringState(std::string_view stateName) noexcept {
+			if (stateName == "AircraftLoaded") return &_aircraftLoaded;
+			if (stateName == "FlightLoaded") return &_flightLoaded;
+			if (stateName == "FlightPlan") return &_flightPlan;
+			return nullptr;
+		}
+		inline CachedSystemState<bool>* boolState(std::string_view stateName) noexcept {
+			if (stateName == "Sim") return &_sim;
+			return nullptr;
+		}
+
+		inline void hit() noexcept { _hits.fetch_add(1, std::memory_order_relaxed); }
+		inline std::uint64_t hits() const noexcept { return _hits.load(std::memory_order_relaxed); }
+
+		/**
+		 * <summary>The system events to subscribe to.</summary>
+		 */
+		static constexpr std::array<SystemEvent, 5> events{
+			SystemEvent::AircraftLoaded,
+			SystemEvent::FlightLoaded,
+			SystemEvent::FlightPlanActivated,
+			SystemEvent::FlightPlanDeactivated,
+			SystemEvent::Sim,
+		};
+
+		void onEvent(SystemEvent event, std::uint32_t data, const char* fileName) {
+			switch (event) {
+			case SystemEvent::AircraftLoaded:
+				if (fileName != nullptr) { _aircraftLoaded.refresh(fileName); } else { _aircraftLoaded.invalidate(); }
+				break;
+			case SystemEvent::FlightLoaded:
+				if (fileName != nullptr) { _flightLoaded.refresh(fileName); } else { _flightLoaded.invalidate(); }
+				_flightPlan.invalidate();		// A new flight may come with its own flightplan
+				break;
+			case SystemEvent::FlightPlanActivated:
+				if (fileName != nullptr) { _flightPlan.refresh(fileName); } else { _flightPlan.invalidate(); }
+				break;
+			case SystemEvent::FlightPlanDeactivated:
+				_flightPlan.invalidate();
+				break;
+			case SystemEvent::Sim:
+				_sim.refresh(data != 0);
+				break;
+			default:
+				break;
+			}
+		}
+
+		void disable(SystemEvent event) {
+			switch (event) {
+			case SystemEvent::AircraftLoaded: _aircraftLoaded.disable(); break;
+			case SystemEvent::FlightLoaded: _flightLoaded.disable(); _flightPlan.disable(); break;
+			case SystemEvent::FlightPlanActivated:
+			case SystemEvent::FlightPlanDeactivated: _flightPlan.disable(); break;
+			case SystemEvent::Sim: _sim.disable(); break;
+			default: break;
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "../Statistics.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>The recording side of a HistogramSnapshot.</summary>
+	 *
+	 * Only one thread records, so the counters are updated without read-modify-write instructions. Any
+	 * thread may take a snapshot; it sees each counter as it was at some point, not all at one instant.
+	 */
+	class AtomicHistogram {
+		std::array<std::atomic<std::uint64_t>, HistogramSnapshot::bucketCount> _buckets{};
+		std::atomic<std::uint64_t> _sum{ 0 };
+		std::atomic<std::uint64_t> _min{ std::numeric_limits<std::uint64_t>::max() };
+		std::atomic<std::uint64_t> _max{ 0 };
+
+		static inline void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept {
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+	public:
+		AtomicHistogram() = default;
+		~AtomicHistogram() = default;
+		AtomicHistogram(AtomicHistogram const&) = delete;
+		AtomicHistogram(AtomicHistogram&&) = delete;
+		AtomicHistogram& operator=(AtomicHistogram const&) = delete;
+		AtomicHistogram& operator=(AtomicHistogram&&) = delete;
+
+		void record(std::uint64_t value) noexcept {
+			add(_buckets[HistogramSnapshot::bucketOf(value)], 1);
+			add(_sum, value);
+			if (value < _min.load(std::memory_order_relaxed)) {
+				_min.store(value, std::memory_order_relaxed);
+			}
+			if (value > _max.load(std::memory_order_relaxed)) {
+				_max.store(value, std::memory_order_relaxed);
+			}
+		}
+
+		HistogramSnapshot snapshot() const noexcept {
+			HistogramSnapshot result;
+			for (size_t i = 0; i < result.buckets.size(); i++) {
+				result.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+				result.count += result.buckets[i];
+			}
+			if (result.count != 0) {
+				result.sum = _sum.load(std::memory_order_relaxed);
+				result.min = _min.load(std::memory_order_relaxed);
+				result.max = _max.load(std::memory_order_relaxed);
+			}
+			return result;
+		}
+	};
+
+	/**
+	 * <summary>The instrumentation of a connection's dispatcher. Everything is recorded by the dispatcher thread.</summary>
+	 *
+	 * Requests are matched to their replies through a small table indexed by the low bits of the RequestID,
+	 * so timing them costs no allocation. If more requests are outstanding than it has room for, the
+	 * older ones are simply not timed.
+	 */
+	class DispatchTiming {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+	private:
+		static constexpr size_t inFlightSlots{ 4096 };
+		static constexpr std::uint32_t noRequest{ 0xffffffff };
+
+		struct InFlight {
+			std::uint32_t reqId{ noRequest };
+			RequestKind kind{ RequestKind::SystemState };
+			Clock::time_point sent;
+		};
+		std::array<InFlight, inFlightSlots> _inFlight{};
+
+		std::array<AtomicHistogram, requestKinds> _roundTrip;
+		std::array<AtomicHistogram, MessageStats::messageTypes> _handling;
+		AtomicHistogram _drainBatch;
+		AtomicHistogram _subscriberCallback;
+
+		static inline std::uint64_t nanosSince(Clock::time_point start) noexcept {
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+		}
+
+	public:
+		DispatchTiming() = default;
+		~DispatchTiming() = default;
+		DispatchTiming(DispatchTiming const&) = delete;
+		DispatchTiming(DispatchTiming&&) = delete;
+		DispatchTiming& operator=(DispatchTiming const&) = delete;
+		DispatchTiming& operator=(DispatchTiming&&) = delete;
+
+		inline void sent(std::uint32_t reqId, RequestKind kind) noexcept {
+			_inFlight[reqId % inFlightSlots] = { reqId, kind, Clock::now() };
+		}
+		inline void replied(std::uint32_t reqId) noexcept {
+			auto& request{ _inFlight[reqId % inFlightSlots] };
+			if (request.reqId == reqId) {
+				_roundTrip[static_cast<size_t>(request.kind)].record(nanosSince(request.sent));
+				request.reqId = noRequest;
+			}
+		}
+
+		inline void handled(std::uint32_t messageId, Clock::time_point start) noexcept {
+			_handling[messageId].record(nanosSince(start));
+		}
+		inline void drained(std::uint64_t messages) noexcept {
+			if (messages != 0) {
+				_drainBatch.record(messages);
+			}
+		}
+		inline void delivered(Clock::time_point start, size_t subscribers) noexcept {
+			_subscriberCallback.record(nanosSince(start) / std::max<size_t>(subscribers, 1));
+		}
+
+		TimingStats stats() const {
+			TimingStats result;
+			for (size_t kind = 0; kind < requestKinds; kind++) {
+				result.roundTrip[kind] = _roundTrip[kind].snapshot();
+			}
+			for (std::uint32_t id = 0; id < _handling.size(); id++) {
+				auto snapshot{ _handling[id].snapshot() };
+				if (snapshot.count != 0) {
+					result.handling.emplace(id, snapshot);
+				}
+			}
+			result.drainBatch = _drainBatch.snapshot();
+			result.subscriberCallback = _subscriberCallback.snapshot();
+			return result;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "../Statistics.h"
+
+#include "OutboundQueue.h"
+
+
+namespace CppSimConnect {
+
+	struct ExceptionInfo {
+		DWORD exceptionId;
+		DWORD parmIndex;
+	};
+
+	/**
+	 * <summary>Matches exceptions from the simulator with the handlers of the calls that caused them.</summary>
+	 *
+	 * Both handlers and early errors (exceptions that arrive before their handler is known) live in
+	 * fixed-size rings indexed by SendID, so matching is a single lookup. A handler stays in place until a
+	 * later SendID needs the slot, which means the depth bounds how many calls can be waiting for a reply
+	 * at the same time. Early errors older than the maximum age are discarded instead of delivered.
+	 *
+	 * The ring is not thread-safe: it is only used by the dispatcher thread, which sends all calls and
+	 * receives all exceptions. The counters can be read from any thread.
+	 */
+	class ExceptionRing {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+	private:
+		struct Handler {
+			DWORD sendId{ 0 };
+			ExceptionCallback callback;
+		};
+		struct EarlyError {
+			DWORD sendId{ 0 };
+			ExceptionInfo info{ 0, 0 };
+			Clock::time_point received;
+			bool pending{ false };
+		};
+
+		std::vector<Handler> _handlers;
+		std::vector<EarlyError> _earlyErrors;
+		DWORD _mask;
+		Clock::duration _maxAge;
+
+		std::atomic<std::uint64_t> _matched{ 0 };
+		std::atomic<std::uint64_t> _unmatched{ 0 };
+		std::atomic<std::uint64_t> _dropped{ 0 };
+
+	public:
+		ExceptionRing(size_t depth, Clock::duration maxAge) :
+			_handlers(std::bit_ceil(depth)), _earlyErrors(std::bit_ceil(depth)),
+			_mask(static_cast<DWORD>(std::bit_ceil(depth) - 1)), _maxAge(maxAge) {}
+		~ExceptionRing() = default;
+		ExceptionRing(ExceptionRing const&) = delete;
+		ExceptionRing(ExceptionRing&&) = delete;
+		ExceptionRing& operator=(ExceptionRing const&) = delete;
+		ExceptionRing& operator=(ExceptionRing&&) = delete;
+
+		inline size_t depth() const noexcept { return _handlers.size(); }
+
+		/**
+		 * <summary>Register the handler for a SendID and return an empty callback. If an exception for it already
+		 * arrived, the handler is not stored; instead it is handed back, with the exception in earlyError.</summary>
+		 */
+		ExceptionCallback add(DWORD sendId, ExceptionCallback&& callback, ExceptionInfo& earlyError, Clock::time_point now = Clock::now()) {
+			auto& early{ _earlyErrors[sendId & _mask] };
+			if (early.pending && (early.sendId == sendId)) {
+				early.pending = false;
+				if ((now - early.received) <= _maxAge) {
+					earlyError = early.info;
+					_matched.fetch_add(1, std::memory_order_relaxed);
+					return std::move(callback);
+				}
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+			auto& handler{ _handlers[sendId & _mask] };
+			handler.sendId = sendId;
+			handler.callback = std::move(callback);
+
+			return nullptr;
+		}
+
+		/**
+		 * <summary>Find the handler for an exception. If there is none, the exception is kept as an early error
+		 * and an empty callback is returned.</summary>
+		 */
+		ExceptionCallback match(DWORD sendId, ExceptionInfo info, Clock::time_point now = Clock::now()) {
+			auto& handler{ _handlers[sendId & _mask] };
+			if (handler.callback && (handler.sendId == sendId)) {
+				_matched.fetch_add(1, std::memory_order_relaxed);
+				return std::exchange(handler.callback, nullptr);
+			}
+			_unmatched.fetch_add(1, std::memory_order_relaxed);
+
+			auto& early{ _earlyErrors[sendId & _mask] };
+			if (early.pending) {
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+			early = { sendId, info, now, true };
+
+			return {};
+		}
+
+		ExceptionStats stats() const noexcept {
+			return {
+				_matched.load(std::memory_order_relaxed),
+				_unmatched.load(std::memory_order_relaxed),
+				_dropped.load(std::memory_order_relaxed)
+			};
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "FakeSimulator.h"
+#include "RecvViews.h"
+
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::simObjectDataHeaderSize;
+
+
+constexpr size_t recordHeaderSize{ sizeof(std::uint64_t) };
+
+static constexpr size_t alignedSize(size_t size) {
+    return (size + recordHeaderSize - 1) & ~(recordHeaderSize - 1);
+}
+
+template <size_t N>
+static void copyString(char (&dest)[N], std::string_view src) {
+    auto len = std::min(src.size(), N - 1);
+    std::memcpy(dest, src.data(), len);
+    dest[len] = '\0';
+}
+
+static constexpr size_t dataTypeSize(SIMCONNECT_DATATYPE type) {
+    switch (type) {
+    case SIMCONNECT_DATATYPE_INT32: return 4;
+    case SIMCONNECT_DATATYPE_INT64: return 8;
+    case SIMCONNECT_DATATYPE_FLOAT32: return 4;
+    case SIMCONNECT_DATATYPE_FLOAT64: return 8;
+    case SIMCONNECT_DATATYPE_STRING8: return 8;
+    case SIMCONNECT_DATATYPE_STRING32: return 32;
+    case SIMCONNECT_DATATYPE_STRING64: return 64;
+    case SIMCONNECT_DATATYPE_STRING128: return 128;
+    case SIMCONNECT_DATATYPE_STRING256: return 256;
+    case SIMCONNECT_DATATYPE_STRING260: return 260;
+    default: return 0;
+    }
+}
+
+template <typename T>
+static void append(std::vector<std::byte>& data, T value) {
+    const auto offset{ data.size() };
+    data.resize(offset + sizeof(T));
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+
+FakeSimulator::~FakeSimulator()
+{
+    stopGenerating();
+}
+
+FakeSimulator& FakeSimulator::withStringState(const std::string& stateName, std::string value)
+{
+    std::lock_guard lock(_mutex);
+    _systemStates[stateName] = { 0, std::move(value) };
+    return *this;
+}
+
+FakeSimulator& FakeSimulator::withBoolState(const std::string& stateName, bool value)
+{
+    std::lock_guard lock(_mutex);
+    _systemStates[stateName] = { value ? 1u : 0u, "" };
+    return *this;
+}
+
+FakeSimulator& FakeSimulator::withMaxPendingBytes(size_t maxPendingBytes)
+{
+    std::lock_guard lock(_mutex);
+    _maxPendingBytes = maxPendingBytes;
+    return *this;
+}
+
+FakeSimulator& FakeSimulator::withSimVar(const std::string& name, double value)
+{
+    std::lock_guard lock(_mutex);
+    _simVars[name] = { value, "" };
+    return *this;
+}
+
+FakeSimulator& FakeSimulator::withSimVar(const std::string& name, std::string value)
+{
+    std::lock_guard lock(_mutex);
+    _simVars[name] = { 0.0, std::move(value) };
+    return *this;
+}
+
+FakeSimulator& FakeSimulator::withUnknownEvent(const std::string& eventName)
+{
+    std::lock_guard lock(_mutex);
+    _unknownEvents.insert(eventName);
+    return *this;
+}
+
+
+void FakeSimulator::postLocked(const SIMCONNECT_RECV& msg, size_t length)
+{
+    const size_t offset{ _pending.size() };
+    const std::uint64_t len{ length };
+
+    _pending.resize(offset + recordHeaderSize + alignedSize(length));
+    std::memcpy(_pending.data() + offset, &len, recordHeaderSize);
+    std::memcpy(_pending.data() + offset + recordHeaderSize, &msg, length);
+    _messagesPosted++;
+
+    if (offset == 0) {
+        _dataAvailable.notify_one();
+    }
+}
+
+void FakeSimulator::post(const SIMCONNECT_RECV& msg)
+{
+    std::lock_guard lock(_mutex);
+    postLocked(msg);
+}
+
+void FakeSimulator::post(const SIMCONNECT_RECV& msg, size_t length)
+{
+    std::lock_guard lock(_mutex);
+    postLocked(msg, length);
+}
+
+void FakeSimulator::postOpenLocked()
+{
+    SIMCONNECT_RECV_OPEN msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwVersion = protocolVersion;
+    msg.dwID = SIMCONNECT_RECV_ID_OPEN;
+    copyString(msg.szApplicationName, _appName);
+    msg.dwApplicationVersionMajor = 1;
+    msg.dwSimConnectVersionMajor = 11;
+    postLocked(msg);
+}
+
+void FakeSimulator::postOpen()
+{
+    std::lock_guard lock(_mutex);
+    postOpenLocked();
+}
+
+void FakeSimulator::postQuit()
+{
+    SIMCONNECT_RECV_QUIT msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwVersion = protocolVersion;
+    msg.dwID = SIMCONNECT_RECV_ID_QUIT;
+    post(msg);
+}
+
+void FakeSimulator::postExceptionLocked(DWORD sendId, DWORD exceptionId, DWORD index)
+{
+    SIMCONNECT_RECV_EXCEPTION msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwVersion = protocolVersion;
+    msg.dwID = SIMCONNECT_RECV_ID_EXCEPTION;
+    msg.dwException = exceptionId;
+    msg.dwSendID = sendId;
+    msg.dwIndex = index;
+    postLocked(msg);
+}
+
+void FakeSimulator::postException(DWORD sendId, DWORD exceptionId, DWORD index)
+{
+    std::lock_guard lock(_mutex);
+    postExceptionLocked(sendId, exceptionId, index);
+}
+
+void FakeSimulator::postSystemStateLocked(DWORD reqId, const SystemStateValue& value)
+{
+    SIMCONNECT_RECV_SYSTEM_STATE msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwVersion = protocolVersion;
+    msg.dwID = SIMCONNECT_RECV_ID_SYSTEM_STATE;
+    msg.dwRequestID = reqId;
+    msg.dwInteger = value.intValue;
+    copyString(msg.szString, value.stringValue);
+    postLocked(msg);
+}
+
+void FakeSimulator::postSystemState(DWORD reqId, DWORD intValue, std::string_view stringValue)
+{
+    std::lock_guard lock(_mutex);
+    postSystemStateLocked(reqId, { intValue, std::string(stringValue) });
+}
+
+void FakeSimulator::postSimObjectDataLocked(DWORD reqId, DWORD defineId, DWORD objectId, DWORD flags, DWORD count, std::span<const std::byte> data)
+{
+    std::vector<std::byte> buffer(simObjectDataHeaderSize + data.size());
+    SIMCONNECT_RECV_SIMOBJECT_DATA header{};
+    header.dwSize = static_cast<DWORD>(buffer.size());
+    header.dwVersion = protocolVersion;
+    header.dwID = SIMCONNECT_RECV_ID_SIMOBJECT_DATA;
+    header.dwRequestID = reqId;
+    header.dwObjectID = objectId;
+    header.dwDefineID = defineId;
+    header.dwFlags = flags;
+    header.dwentrynumber = 1;
+    header.dwoutof = 1;
+    header.dwDefineCount = count;
+    std::memcpy(buffer.data(), &header, simObjectDataHeaderSize);
+    std::memcpy(buffer.data() + simObjectDataHeaderSize, data.data(), data.size());
+    postLocked(*reinterpret_cast<const SIMCONNECT_RECV*>(buffer.data()));
+}
+
+void FakeSimulator::postSimObjectData(DWORD reqId, DWORD defineId, DWORD objectId, std::span<const std::byte> data, DWORD flags)
+{
+    std::lock_guard lock(_mutex);
+    postSimObjectDataLocked(reqId, defineId, objectId, flags, 0, data);
+}
+
+// Lay out the current values of the definition's variables as SimConnect does: packed, in definition order.
+std::vector<std::byte> FakeSimulator::encodeLocked(const std::vector<Datum>& definition) const
+{
+    std::vector<std::byte> data;
+    for (const auto& datum : definition) {
+        SimVarValue value{ 0.0, "" };
+        if (auto it = _simVars.find(datum.name); it != _simVars.end()) {
+            value = it->second;
+        }
+        switch (datum.type) {
+        case SIMCONNECT_DATATYPE_INT32:
+            append(data, static_cast<std::int32_t>(value.number));
+            break;
+        case SIMCONNECT_DATATYPE_INT64:
+            append(data, static_cast<std::int64_t>(value.number));
+            break;
+        case SIMCONNECT_DATATYPE_FLOAT32:
+            append(data, static_cast<float>(value.number));
+            break;
+        case SIMCONNECT_DATATYPE_FLOAT64:
+            append(data, value.number);
+            break;
+        default:
+        {
+            const auto size{ dataTypeSize(datum.type) };
+            const auto offset{ data.size() };
+            data.resize(offset + size);
+            std::memcpy(data.data() + offset, value.text.data(), std::min(value.text.size(), size - 1));
+        }
+        break;
+        }
+    }
+    return data;
+}
+
+
+void FakeSimulator::fireSystemEvent(std::string_view eventName, DWORD data)
+{
+    std::lock_guard lock(_mutex);
+    auto [first, last] = _systemEventSubscriptions.equal_range(eventName);
+    for (auto it = first; it != last; ++it) {
+        SIMCONNECT_RECV_EVENT msg{};
+        msg.dwSize = sizeof(msg);
+        msg.dwVersion = protocolVersion;
+        msg.dwID = SIMCONNECT_RECV_ID_EVENT;
+        msg.uGroupID = SIMCONNECT_UNUSED;
+        msg.uEventID = it->second;
+        msg.dwData = data;
+        postLocked(msg);
+    }
+}
+
+void FakeSimulator::fireSystemEvent(std::string_view eventName, std::string_view fileName)
+{
+    std::lock_guard lock(_mutex);
+    auto [first, last] = _systemEventSubscriptions.equal_range(eventName);
+    for (auto it = first; it != last; ++it) {
+        SIMCONNECT_RECV_EVENT_FILENAME msg{};
+        msg.dwSize = sizeof(msg);
+        msg.dwVersion = protocolVersion;
+        msg.dwID = SIMCONNECT_RECV_ID_EVENT_FILENAME;
+        msg.uGroupID = SIMCONNECT_UNUSED;
+        msg.uEventID = it->second;
+        copyString(msg.szFileName, fileName);
+        postLocked(msg);
+    }
+}
+
+size_t FakeSimulator::systemEventSubscriptions() const
+{
+    std::lock_guard lock(_mutex);
+    return _systemEventSubscriptions.size();
+}
+
+void FakeSimulator::fireEvent(std::string_view eventName, DWORD data)
+{
+    std::lock_guard lock(_mutex);
+
+    std::vector<std::pair<DWORD, DWORD>> byPriority;	// Priority and GroupID
+    for (const auto& [groupId, group] : _notificationGroups) {
+        byPriority.emplace_back(group.priority, groupId);
+    }
+    std::sort(byPriority.begin(), byPriority.end());
+
+    for (const auto& [priority, groupId] : byPriority) {
+        for (const auto& member : _notificationGroups[groupId].members) {
+            auto mapped = _clientEvents.find(member.eventId);
+            if ((mapped == _clientEvents.end()) || (mapped->second != eventName)) {
+                continue;
+            }
+            SIMCONNECT_RECV_EVENT msg{};
+            msg.dwSize = sizeof(msg);
+            msg.dwVersion = protocolVersion;
+            msg.dwID = SIMCONNECT_RECV_ID_EVENT;
+            msg.uGroupID = groupId;
+            msg.uEventID = member.eventId;
+            msg.dwData = data;
+            postLocked(msg);
+            if (member.maskable) {
+                return;
+            }
+        }
+    }
+}
+
+size_t FakeSimulator::clientEvents() const
+{
+    std::lock_guard lock(_mutex);
+    return _clientEvents.size();
+}
+
+size_t FakeSimulator::notificationGroups() const
+{
+    std::lock_guard lock(_mutex);
+    return _notificationGroups.size();
+}
+
+DWORD FakeSimulator::groupPriority(DWORD groupId) const
+{
+    std::lock_guard lock(_mutex);
+    auto it = _notificationGroups.find(groupId);
+    return (it != _notificationGroups.end()) ? it->second.priority : 0;
+}
+
+
+void FakeSimulator::generate(unsigned callsPerSecond, Script script)
+{
+    using namespace std::chrono;
+
+    stopGenerating();
+    _generator = std::jthread([this, callsPerSecond, script = std::move(script)](std::stop_token stop) {
+        const auto start{ steady_clock::now() };
+
+        for (std::uint64_t seqNr = 0; !stop.stop_requested(); ++seqNr) {
+            if (callsPerSecond != 0) {
+                const auto due{ start + nanoseconds(seqNr * 1'000'000'000ull / callsPerSecond) };
+                if (due - steady_clock::now() > milliseconds(1)) {
+                    std::this_thread::sleep_until(due);
+                }
+            }
+            {
+                // Don't run away from the dispatcher.
+                std::unique_lock lock(_mutex);
+                if (!_spaceAvailable.wait(lock, stop, [this] { return _pending.size() < _maxPendingBytes; })) {
+                    break;
+                }
+            }
+            script(*this, seqNr);
+        }
+    });
+}
+
+void FakeSimulator::stopGenerating()
+{
+    if (_generator.joinable()) {
+        _generator.request_stop();
+        _generator.join();
+    }
+}
+
+
+HRESULT FakeSimulator::open(const std::string& clientName)
+{
+    std::lock_guard lock(_mutex);
+
+    _open = true;
+    _clientName = clientName;
+    _lastSendId = 0;
+    _systemEventSubscriptions.clear();
+    _dataDefinitions.clear();
+    _dataSubscriptions.clear();
+    _clientEvents.clear();
+    _notificationGroups.clear();
+    _pending.clear();
+    _delivering.clear();
+    _readPos = 0;
+    postOpenLocked();
+
+    return S_OK;
+}
+
+HRESULT FakeSimulator::close()
+{
+    stopGenerating();
+
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    _open = false;
+
+    return S_OK;
+}
+
+bool FakeSimulator::isOpen() const noexcept
+{
+    std::lock_guard lock(_mutex);
+    return _open;
+}
+
+HRESULT FakeSimulator::callDispatch(DispatchProc handler, void* context)
+{
+    SIMCONNECT_RECV* msgPtr;
+    DWORD msgLen;
+    while (SUCCEEDED(getNextDispatch(&msgPtr, &msgLen))) {
+        handler(msgPtr, msgLen, context);
+    }
+    return S_OK;
+}
+
+HRESULT FakeSimulator::getNextDispatch(SIMCONNECT_RECV** msgPtr, DWORD* msgLen)
+{
+    if (_readPos >= _delivering.size()) {
+        _delivering.clear();
+        _readPos = 0;
+        {
+            std::lock_guard lock(_mutex);
+            if (!_open) {
+                return E_FAIL;
+            }
+            std::swap(_pending, _delivering);
+        }
+        _spaceAvailable.notify_all();
+
+        if (_delivering.empty()) {
+            return E_FAIL;
+        }
+    }
+    std::uint64_t len;
+    std::memcpy(&len, _delivering.data() + _readPos, recordHeaderSize);
+
+    *msgPtr = reinterpret_cast<SIMCONNECT_RECV*>(_delivering.data() + _readPos + recordHeaderSize);
+    *msgLen = static_cast<DWORD>(len);
+    _readPos += recordHeaderSize + alignedSize(len);
+    _messagesDelivered++;
+
+    return S_OK;
+}
+
+bool FakeSimulator::waitForDispatch(std::chrono::milliseconds timeout)
+{
+    if (_readPos < _delivering.size()) {
+        return true;
+    }
+    std::unique_lock lock(_mutex);
+    bool result = _dataAvailable.wait_for(lock, timeout, [this] { return _wakeUp || !_pending.empty(); });
+    _wakeUp = false;
+
+    return result;
+}
+
+void FakeSimulator::wakeUp() noexcept
+{
+    {
+        std::lock_guard lock(_mutex);
+        _wakeUp = true;
+    }
+    _dataAvailable.notify_one();
+}
+
+HRESULT FakeSimulator::getLastSentPacketId(DWORD* sendId)
+{
+    std::lock_guard lock(_mutex);
+    *sendId = _lastSendId;
+    return S_OK;
+}
+
+HRESULT FakeSimulator::requestSystemState(DWORD reqId, const char* stateName)
+{
+    _requestsReceived++;
+
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    const DWORD sendId{ ++_lastSendId };
+
+    auto it = _systemStates.find(std::string_view(stateName));
+    if (it != _systemStates.end()) {
+        postSystemStateLocked(reqId, it->second);
+    }
+    else {
+        postExceptionLocked(sendId, SIMCONNECT_EXCEPTION_NAME_UNRECOGNIZED, 2);
+    }
+    return S_OK;
+}
+
+HRESULT FakeSimulator::subscribeToSystemEvent(DWORD eventId, const char* eventName)
+{
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    ++_lastSendId;
+    _systemEventSubscriptions.emplace(eventName, eventId);
+
+    return S_OK;
+}
+
+HRESULT FakeSimulator::addToDataDefinition(DWORD defineId, const char* datumName, [[maybe_unused]] const char* unitsName, SIMCONNECT_DATATYPE datumType, [[maybe_unused]] float epsilon, DWORD datumId)
+{
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    const DWORD sendId{ ++_lastSendId };
+
+    if (dataTypeSize(datumType) == 0) {
+        postExceptionLocked(sendId, SIMCONNECT_EXCEPTION_INVALID_DATA_TYPE, 5);
+    }
+    else {
+        _dataDefinitions[defineId].push_back({ datumName, datumType, datumId });
+    }
+    return S_OK;
+}
+
+HRESULT FakeSimulator::requestDataOnSimObject(DWORD reqId, DWORD defineId, DWORD objectId, SIMCONNECT_PERIOD period, DWORD flags, [[maybe_unused]] DWORD origin, [[maybe_unused]] DWORD interval, [[maybe_unused]] DWORD limit)
+{
+    _dataRequestsReceived++;
+
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    const DWORD sendId{ ++_lastSendId };
+
+    auto it = _dataDefinitions.find(defineId);
+    if (it == _dataDefinitions.end()) {
+        postExceptionLocked(sendId, SIMCONNECT_EXCEPTION_UNRECOGNIZED_ID, 3);
+    }
+    else if (period == SIMCONNECT_PERIOD_ONCE) {
+        const auto data{ encodeLocked(it->second) };
+        postSimObjectDataLocked(reqId, defineId, objectId, flags, static_cast<DWORD>(it->second.size()), data);
+    }
+    else if (period == SIMCONNECT_PERIOD_NEVER) {
+        _dataSubscriptions.erase(reqId);
+    }
+    else {
+        _dataSubscriptions[reqId] = { defineId, objectId, period, flags, {} };
+    }
+    return S_OK;
+}
+
+HRESULT FakeSimulator::mapClientEventToSimEvent(DWORD eventId, const char* eventName)
+{
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    const DWORD sendId{ ++_lastSendId };
+
+    if (_unknownEvents.contains(std::string_view(eventName))) {
+        postExceptionLocked(sendId, SIMCONNECT_EXCEPTION_NAME_UNRECOGNIZED, 2);
+    }
+    else if (!_clientEvents.emplace(eventId, eventName).second) {
+        postExceptionLocked(sendId, SIMCONNECT_EXCEPTION_EVENT_ID_DUPLICATE, 1);
+    }
+    return S_OK;
+}
+
+HRESULT FakeSimulator::addClientEventToNotificationGroup(DWORD groupId, DWORD eventId, bool maskable)
+{
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    const DWORD sendId{ ++_lastSendId };
+
+    if (!_clientEvents.contains(eventId)) {
+        postExceptionLocked(sendId, SIMCONNECT_EXCEPTION_UNRECOGNIZED_ID, 2);
+    }
+    else {
+        _notificationGroups[groupId].members.push_back({ eventId, maskable });
+    }
+    return S_OK;
+}
+
+HRESULT FakeSimulator::setNotificationGroupPriority(DWORD groupId, DWORD priority)
+{
+    std::lock_guard lock(_mutex);
+    if (!_open) {
+        return E_FAIL;
+    }
+    const DWORD sendId{ ++_lastSendId };
+
+    auto it = _notificationGroups.find(groupId);
+    if (it == _notificationGroups.end()) {
+        postExceptionLocked(sendId, SIMCONNECT_EXCEPTION_UNRECOGNIZED_ID, 1);
+    }
+    else {
+        it->second.priority = priority;
+    }
+    return S_OK;
+}
+
+void FakeSimulator::sendDataLocked(DWORD reqId, DataSubscription& subscription)
+{
+    auto it = _dataDefinitions.find(subscription.defineId);
+    if (it == _dataDefinitions.end()) {
+        return;
+    }
+    const auto& definition{ it->second };
+    auto data{ encodeLocked(definition) };
+    const bool first{ subscription.lastSent.empty() };
+
+    if ((subscription.flags & SIMCONNECT_DATA_REQUEST_FLAG_CHANGED) != 0) {
+        if (!first && (data == subscription.lastSent)) {
+            return;
+        }
+        if ((subscription.flags & SIMCONNECT_DATA_REQUEST_FLAG_TAGGED) != 0) {
+            std::vector<std::byte> tagged;
+            DWORD count{ 0 };
+            size_t offset{ 0 };
+            for (const auto& datum : definition) {
+                const auto size{ dataTypeSize(datum.type) };
+                if (first || (std::memcmp(data.data() + offset, subscription.lastSent.data() + offset, size) != 0)) {
+                    append(tagged, datum.datumId);
+                    tagged.insert(tagged.end(), data.begin() + offset, data.begin() + offset + size);
+                    count++;
+                }
+                offset += size;
+            }
+            postSimObjectDataLocked(reqId, subscription.defineId, subscription.objectId, subscription.flags, count, tagged);
+            subscription.lastSent = std::move(data);
+            return;
+        }
+    }
+    postSimObjectDataLocked(reqId, subscription.defineId, subscription.objectId, subscription.flags, static_cast<DWORD>(definition.size()), data);
+    subscription.lastSent = std::move(data);
+}
+
+void FakeSimulator::tick(SIMCONNECT_PERIOD period)
+{
+    std::lock_guard lock(_mutex);
+    for (auto& [reqId, subscription] : _dataSubscriptions) {
+        if ((subscription.period == period) || ((period == SIMCONNECT_PERIOD_VISUAL_FRAME) && (subscription.period == SIMCONNECT_PERIOD_SIM_FRAME))) {
+            sendDataLocked(reqId, subscription);
+        }
+    }
+}
+
+size_t FakeSimulator::dataDefinitions() const
+{
+    std::lock_guard lock(_mutex);
+    return _dataDefinitions.size();
+}
+
+size_t FakeSimulator::dataSubscriptions() const
+{
+    std::lock_guard lock(_mutex);
+    return _dataSubscriptions.size();
+}
\ No newline at end of file
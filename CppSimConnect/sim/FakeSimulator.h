@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "SimBackend.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>An in-process stand-in for the simulator.</summary>
+	 *
+	 * FakeSimulator answers requests from a table of scripted values and can generate messages at a
+	 * configurable rate, which lets the dispatch path be tested and benchmarked without a simulator.
+	 * Everything it sends is laid out exactly like the real <c>SIMCONNECT_RECV</c> messages.
+	 */
+	class FakeSimulator : public SimBackend {
+	public:
+		using Script = std::function<void(FakeSimulator& sim, std::uint64_t seqNr)>;
+
+		static constexpr DWORD protocolVersion{ 4 };
+
+	private:
+		struct SystemStateValue {
+			DWORD intValue;
+			std::string stringValue;
+		};
+		struct SimVarValue {
+			double number;
+			std::string text;
+		};
+		struct Datum {
+			std::string name;
+			SIMCONNECT_DATATYPE type;
+			DWORD datumId;
+		};
+		struct DataSubscription {
+			DWORD defineId;
+			DWORD objectId;
+			SIMCONNECT_PERIOD period;
+			DWORD flags;
+			std::vector<std::byte> lastSent;
+		};
+		struct GroupMember {
+			DWORD eventId;
+			bool maskable;
+		};
+		struct NotificationGroup {
+			DWORD priority{ SIMCONNECT_GROUP_PRIORITY_DEFAULT };
+			std::vector<GroupMember> members;
+		};
+
+		mutable std::mutex _mutex;
+		bool _open{ false };
+		std::string _clientName;
+		std::string _appName;
+		DWORD _lastSendId{ 0 };
+		std::map<std::string, SystemStateValue, std::less<>> _systemStates;
+		std::multimap<std::string, DWORD, std::less<>> _systemEventSubscriptions;
+		std::map<std::string, SimVarValue, std::less<>> _simVars;
+		std::map<DWORD, std::vector<Datum>> _dataDefinitions;
+		std::map<DWORD, DataSubscription> _dataSubscriptions;		// By RequestID
+		std::set<std::string, std::less<>> _unknownEvents;
+		std::map<DWORD, std::string> _clientEvents;					// Mapped client events, by EventID
+		std::map<DWORD, NotificationGroup> _notificationGroups;		// By GroupID
+
+		// Messages are queued as a length followed by the message, padded to keep the next one aligned.
+		// The dispatcher reads from _delivering, and swaps it with _pending when it runs dry.
+		std::vector<std::byte> _pending;
+		std::vector<std::byte> _delivering;
+		size_t _readPos{ 0 };
+		size_t _maxPendingBytes{ 64 * 1024 * 1024 };
+		std::condition_variable_any _spaceAvailable;
+		std::condition_variable _dataAvailable;
+		bool _wakeUp{ false };
+
+		std::atomic<std::uint64_t> _requestsReceived{ 0 };
+		std::atomic<std::uint64_t> _dataRequestsReceived{ 0 };
+		std::atomic<std::uint64_t> _messagesPosted{ 0 };
+		std::atomic<std::uint64_t> _messagesDelivered{ 0 };
+
+		std::jthread _generator;
+
+		void postLocked(const SIMCONNECT_RECV& msg, size_t length);
+		inline void postLocked(const SIMCONNECT_RECV& msg) { postLocked(msg, msg.dwSize); }
+		void postSystemStateLocked(DWORD reqId, const SystemStateValue& value);
+		void postExceptionLocked(DWORD sendId, DWORD exceptionId, DWORD index);
+		void postOpenLocked();
+		void postSimObjectDataLocked(DWORD reqId, DWORD defineId, DWORD objectId, DWORD flags, DWORD count, std::span<const std::byte> data);
+		std::vector<std::byte> encodeLocked(const std::vector<Datum>& definition) const;
+		void sendDataLocked(DWORD reqId, DataSubscription& subscription);
+
+	public:
+		FakeSimulator(std::string appName = "CppSimConnect FakeSimulator") : _appName(std::move(appName)) {}
+		~FakeSimulator() override;
+
+		// Scripting
+		FakeSimulator& withStringState(const std::string& stateName, std::string value);
+		FakeSimulator& withBoolState(const std::string& stateName, bool value);
+		FakeSimulator& withMaxPendingBytes(size_t maxPendingBytes);
+		FakeSimulator& withSimVar(const std::string& name, double value);
+		FakeSimulator& withSimVar(const std::string& name, std::string value);
+		FakeSimulator& withUnknownEvent(const std::string& eventName);	// Mapping it raises an exception
+
+		void post(const SIMCONNECT_RECV& msg);
+		void post(const SIMCONNECT_RECV& msg, size_t length);	// Only the first length bytes, whatever dwSize says
+		void postOpen();
+		void postQuit();
+		void postException(DWORD sendId, DWORD exceptionId, DWORD index);
+		void postSystemState(DWORD reqId, DWORD intValue, std::string_view stringValue);
+		void postSimObjectData(DWORD reqId, DWORD defineId, DWORD objectId, std::span<const std::byte> data, DWORD flags = 0);
+
+		/**
+		 * <summary>Send a system event to all clients subscribed to it, either with a data value or a filename.</summary>
+		 */
+		void fireSystemEvent(std::string_view eventName, DWORD data = 0);
+		void fireSystemEvent(std::string_view eventName, std::string_view fileName);
+
+		/**
+		 * <summary>Send a simulator event to the client, if it mapped the event and added it to a notification group.</summary>
+		 * Groups are notified in order of priority, and a maskable event stops at the first group that has it.
+		 */
+		void fireEvent(std::string_view eventName, DWORD data = 0);
+
+		/**
+		 * <summary>Let a period pass, sending the data of all subscriptions with that period.</summary>
+		 * A visual frame is also a sim frame. Subscriptions with the CHANGED flag are skipped if no value
+		 * changed, and with the TAGGED flag only the changed values are sent.
+		 */
+		void tick(SIMCONNECT_PERIOD period);
+
+		/**
+		 * <summary>Call the script from a background thread, the given number of times per second.</summary>
+		 * A rate of 0 runs the script as fast as the dispatcher can keep up with.
+		 */
+		void generate(unsigned callsPerSecond, Script script);
+		void stopGenerating();
+
+		// Statistics
+		inline std::uint64_t requestsReceived() const noexcept { return _requestsReceived; }	// System-state requests
+		inline std::uint64_t dataRequestsReceived() const noexcept { return _dataRequestsReceived; }
+		size_t dataDefinitions() const;
+		size_t dataSubscriptions() const;
+		size_t systemEventSubscriptions() const;
+		size_t clientEvents() const;
+		size_t notificationGroups() const;
+		DWORD groupPriority(DWORD groupId) const;
+		inline std::uint64_t messagesPosted() const noexcept { return _messagesPosted; }
+		inline std::uint64_t messagesDelivered() const noexcept { return _messagesDelivered; }	// Handed to the dispatcher
+		inline const std::string& clientName() const noexcept { return _clientName; }
+
+		// SimBackend
+		HRESULT open(const std::string& clientName) override;
+		HRESULT close() override;
+		bool isOpen() const noexcept override;
+
+		HRESULT callDispatch(DispatchProc handler, void* context) override;
+		HRESULT getNextDispatch(SIMCONNECT_RECV** msgPtr, DWORD* msgLen) override;
+
+		bool waitForDispatch(std::chrono::milliseconds timeout) override;
+		void wakeUp() noexcept override;
+
+		HRESULT getLastSentPacketId(DWORD* sendId) override;
+		HRESULT requestSystemState(DWORD reqId, const char* stateName) override;
+		HRESULT subscribeToSystemEvent(DWORD eventId, const char* eventName) override;
+		HRESULT addToDataDefinition(DWORD defineId, const char* datumName, const char* unitsName, SIMCONNECT_DATATYPE datumType, float epsilon, DWORD datumId) override;
+		HRESULT requestDataOnSimObject(DWORD reqId, DWORD defineId, DWORD objectId, SIMCONNECT_PERIOD period, DWORD flags, DWORD origin, DWORD interval, DWORD limit) override;
+		HRESULT mapClientEventToSimEvent(DWORD eventId, const char* eventName) override;
+		HRESULT addClientEventToNotificationGroup(DWORD groupId, DWORD eventId, bool maskable) override;
+		HRESULT setNotificationGroupPriority(DWORD groupId, DWORD priority) override;
+	};
+}
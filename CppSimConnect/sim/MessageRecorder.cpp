@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../pch.h"
+
+#include <stdexcept>
+
+#include "MessageRecorder.h"
+
+using CppSimConnect::MessageRecorder;
+
+
+MessageRecorder::MessageRecorder(const std::filesystem::path& file) :
+    _out(file, std::ios::binary | std::ios::trunc),
+    _start{ std::chrono::steady_clock::now() }
+{
+    if (!_out) {
+        throw std::runtime_error("Cannot create message recording '" + file.string() + "'");
+    }
+    _out.write(magic, sizeof(magic));
+    put(version);
+}
+
+MessageRecorder::~MessageRecorder()
+{
+    _out.flush();
+}
+
+void MessageRecorder::record(const SIMCONNECT_RECV* msg, DWORD msgLen)
+{
+    static constexpr char padding[alignment]{};
+
+    const auto timestamp{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start) };
+    put(static_cast<std::uint64_t>(timestamp.count()));
+    put(static_cast<std::uint32_t>(msg->dwID));
+    put(static_cast<std::uint32_t>(msgLen));
+    _out.write(reinterpret_cast<const char*>(msg), msgLen);
+    _out.write(padding, paddedSize(msgLen) - msgLen);
+    _recorded++;
+}
+
+void MessageRecorder::flush()
+{
+    _out.flush();
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+#include "SimBackend.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>Appends every received message to a file, so the stream can be replayed later.</summary>
+	 *
+	 * The file starts with an 8-byte header ("CSCREC" and a 16-bit version). Each message follows as a 64-bit
+	 * timestamp in nanoseconds since the recording started, the 32-bit message ID, the 32-bit length, and the
+	 * message exactly as received, padded to a multiple of 8 bytes. Everything is 8-byte aligned, so a
+	 * ReplayBackend can hand out the messages where they lie in the mapped file. All numbers are little-endian.
+	 * Not thread-safe; the dispatcher thread calls it for each message before handling it.
+	 */
+	class MessageRecorder {
+		std::ofstream _out;
+		std::chrono::steady_clock::time_point _start;
+		std::uint64_t _recorded{ 0 };
+
+		template <typename T>
+		inline void put(T value) { _out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+	public:
+		static constexpr char magic[6]{ 'C', 'S', 'C', 'R', 'E', 'C' };
+		static constexpr std::uint16_t version{ 1 };
+		static constexpr size_t headerSize{ sizeof(magic) + sizeof(version) };
+		static constexpr size_t entryHeaderSize{ sizeof(std::uint64_t) + 2 * sizeof(std::uint32_t) };
+		static constexpr size_t alignment{ 8 };
+
+		static constexpr size_t paddedSize(size_t size) noexcept { return (size + alignment - 1) & ~(alignment - 1); }
+
+		MessageRecorder(const std::filesystem::path& file);
+		~MessageRecorder();
+		MessageRecorder(MessageRecorder const&) = delete;
+		MessageRecorder(MessageRecorder&&) = delete;
+		MessageRecorder& operator=(MessageRecorder const&) = delete;
+		MessageRecorder& operator=(MessageRecorder&&) = delete;
+
+		void record(const SIMCONNECT_RECV* msg, DWORD msgLen);
+		void flush();
+
+		inline std::uint64_t recorded() const noexcept { return _recorded; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "SimBackend.h"
+
+
+namespace CppSimConnect {
+
+	using ExceptionCallback = std::function<void(unsigned exceptionId, std::string const& msg, unsigned parmIndex)>;
+
+	/**
+	 * <summary>A call to the simulator, waiting to be sent by the dispatcher thread.</summary>
+	 */
+	struct OutboundCall {
+		OutboundCall* next{ nullptr };
+		ExceptionCallback onError;
+
+		OutboundCall(ExceptionCallback&& errorHandler) : onError(std::move(errorHandler)) {}
+		virtual ~OutboundCall() = default;
+
+		virtual HRESULT send(SimBackend& backend) = 0;
+
+		// For a call that will never be sent, or whose SendID is lost, so whoever waits for it does not wait forever.
+		void fail(std::string const& msg) noexcept {
+			try {
+				if (onError) {
+					onError(SIMCONNECT_EXCEPTION_ERROR, msg, 0);
+				}
+			}
+			catch (...) {
+			}
+		}
+	};
+
+	template <typename F>
+	class OutboundCallOf : public OutboundCall {
+		F _send;
+
+	public:
+		OutboundCallOf(F&& send, ExceptionCallback&& errorHandler) : OutboundCall(std::move(errorHandler)), _send(std::move(send)) {}
+		~OutboundCallOf() override = default;
+
+		HRESULT send(SimBackend& backend) override { return _send(backend); }
+	};
+
+	/**
+	 * <summary>Multi-producer, single-consumer queue of outbound calls.</summary>
+	 *
+	 * Any thread can push without taking a lock; the dispatcher thread takes the whole queue in one go
+	 * and gets the calls back in the order they were pushed.
+	 */
+	class OutboundQueue {
+		std::atomic<OutboundCall*> _head{ nullptr };
+
+	public:
+		OutboundQueue() = default;
+		~OutboundQueue() {
+			failAll("Error");		// The name of SIMCONNECT_EXCEPTION_ERROR
+		}
+		OutboundQueue(OutboundQueue const&) = delete;
+		OutboundQueue(OutboundQueue&&) = delete;
+		OutboundQueue& operator=(OutboundQueue const&) = delete;
+		OutboundQueue& operator=(OutboundQueue&&) = delete;
+
+		/**
+		 * <summary>Add a call to the queue, returning true if the queue was empty.</summary>
+		 */
+		bool push(std::unique_ptr<OutboundCall> call) noexcept {
+			OutboundCall* node = call.release();
+			OutboundCall* head = _head.load(std::memory_order_relaxed);
+			do {
+				node->next = head;
+			} while (!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+			return head == nullptr;
+		}
+
+		/**
+		 * <summary>Remove all queued calls, returning them as a list in FIFO order. The caller owns the nodes.</summary>
+		 */
+		OutboundCall* takeAll() noexcept {
+			OutboundCall* lifo = _head.exchange(nullptr, std::memory_order_acquire);
+			OutboundCall* fifo{ nullptr };
+			while (lifo != nullptr) {
+				OutboundCall* next = lifo->next;
+				lifo->next = fifo;
+				fifo = lifo;
+				lifo = next;
+			}
+			return fifo;
+		}
+
+		/**
+		 * <summary>Remove all queued calls without sending them, failing each with SIMCONNECT_EXCEPTION_ERROR.</summary>
+		 */
+		void failAll(std::string const& msg) noexcept {
+			OutboundCall* call = takeAll();
+			while (call != nullptr) {
+				std::unique_ptr<OutboundCall> failed{ std::exchange(call, call->next) };
+				failed->fail(msg);
+			}
+		}
+
+		inline bool empty() const noexcept { return _head.load(std::memory_order_relaxed) == nullptr; }
+	};
+}
\ No newline at end of file
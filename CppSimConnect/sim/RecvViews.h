@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "SimBackend.h"
+
+#include "../MessageViews.h"
+
+
+namespace CppSimConnect {
+
+	// Views on received messages read the fields where they lie, instead of copying the message.
+
+	inline messages::AppInfoView appInfoView(const SIMCONNECT_RECV_OPEN& msg) noexcept {
+		return {
+			messages::textView(msg.szApplicationName),
+			msg.dwApplicationVersionMajor, msg.dwApplicationVersionMinor,
+			msg.dwApplicationBuildMajor, msg.dwApplicationBuildMinor,
+			msg.dwSimConnectVersionMajor, msg.dwSimConnectVersionMinor,
+			msg.dwSimConnectBuildMajor, msg.dwSimConnectBuildMinor
+		};
+	}
+
+	inline messages::SystemStateView systemStateView(const SIMCONNECT_RECV_SYSTEM_STATE& msg) noexcept {
+		return { msg.dwInteger, msg.fFloat, messages::textView(msg.szString) };
+	}
+
+	// The data of a SIMOBJECT_DATA message starts at its last member, dwData.
+	constexpr size_t simObjectDataHeaderSize{ sizeof(SIMCONNECT_RECV_SIMOBJECT_DATA) - sizeof(DWORD) };
+
+	/**
+	 * <summary>The data block of a SIMOBJECT_DATA message, as far as dwSize says it goes.</summary>
+	 */
+	inline std::span<const std::byte> simObjectDataView(const SIMCONNECT_RECV_SIMOBJECT_DATA& msg) noexcept {
+		const size_t size{ (msg.dwSize > simObjectDataHeaderSize) ? (msg.dwSize - simObjectDataHeaderSize) : 0 };
+		return { reinterpret_cast<const std::byte*>(&msg) + simObjectDataHeaderSize, size };
+	}
+}
\ No newline at end of file
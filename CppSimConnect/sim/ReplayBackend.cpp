@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../pch.h"
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MessageRecorder.h"
+#include "ReplayBackend.h"
+
+using CppSimConnect::MessageRecorder;
+using CppSimConnect::ReplayBackend;
+
+
+/**
+ * <summary>A file mapped copy-on-write, so the messages in it can be handed out as writable pointers.</summary>
+ */
+class ReplayBackend::MappedFile {
+    std::byte* _data{ nullptr };
+    size_t _size{ 0 };
+#ifdef _WIN32
+    HANDLE _file{ INVALID_HANDLE_VALUE };
+    HANDLE _mapping{ nullptr };
+#endif
+
+public:
+    MappedFile(const std::filesystem::path& path) {
+        const std::string error{ "Cannot map message recording '" + path.string() + "'" };
+#ifdef _WIN32
+        _file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size;
+        if ((_file == INVALID_HANDLE_VALUE) || !GetFileSizeEx(_file, &size)) {
+            close();
+            throw std::runtime_error(error);
+        }
+        _size = static_cast<size_t>(size.QuadPart);
+        _mapping = CreateFileMappingW(_file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        _data = (_mapping == nullptr) ? nullptr : static_cast<std::byte*>(MapViewOfFile(_mapping, FILE_MAP_COPY, 0, 0, 0));
+        if (_data == nullptr) {
+            close();
+            throw std::runtime_error(error);
+        }
+#else
+        const int fd{ ::open(path.c_str(), O_RDONLY) };
+        struct stat st;
+        if ((fd < 0) || (::fstat(fd, &st) != 0)) {
+            if (fd >= 0) { ::close(fd); }
+            throw std::runtime_error(error);
+        }
+        _size = static_cast<size_t>(st.st_size);
+        void* data{ (_size == 0) ? MAP_FAILED : ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) };
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error(error);
+        }
+        _data = static_cast<std::byte*>(data);
+#endif
+    }
+    ~MappedFile() { close(); }
+    MappedFile(MappedFile const&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    void close() noexcept {
+#ifdef _WIN32
+        if (_data != nullptr) { UnmapViewOfFile(_data); }
+        if (_mapping != nullptr) { CloseHandle(_mapping); }
+        if (_file != INVALID_HANDLE_VALUE) { CloseHandle(_file); }
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data != nullptr) { ::munmap(_data, _size); }
+#endif
+        _data = nullptr;
+    }
+
+    inline std::byte* data() const noexcept { return _data; }
+    inline size_t size() const noexcept { return _size; }
+};
+
+
+ReplayBackend::ReplayBackend(const std::filesystem::path& file, double speed) :
+    _file{ std::make_unique<MappedFile>(file) },
+    _data{ _file->data() },
+    _size{ _file->size() },
+    _speed{ speed }
+{
+    if ((_size < MessageRecorder::headerSize) ||
+        (std::memcmp(_data, MessageRecorder::magic, sizeof(MessageRecorder::magic)) != 0)) {
+        throw std::runtime_error("'" + file.string() + "' is not a message recording");
+    }
+    std::uint16_t version;
+    std::memcpy(&version, _data + sizeof(MessageRecorder::magic), sizeof(version));
+    if (version != MessageRecorder::version) {
+        throw std::runtime_error("Unsupported message recording version " + std::to_string(version) + " in '" + file.string() + "'");
+    }
+    _pos = MessageRecorder::headerSize;
+
+    std::uint32_t length;
+    if (!nextEntry(_firstTimestamp, length)) {
+        _firstTimestamp = 0;
+    }
+}
+
+ReplayBackend::~ReplayBackend() = default;
+
+bool ReplayBackend::nextEntry(std::uint64_t& timestamp, std::uint32_t& length) const noexcept
+{
+    const size_t pos{ _pos.load(std::memory_order_relaxed) };
+    if ((pos + MessageRecorder::entryHeaderSize) > _size) {
+        return false;
+    }
+    std::memcpy(&timestamp, _data + pos, sizeof(timestamp));
+    std::memcpy(&length, _data + pos + sizeof(timestamp) + sizeof(std::uint32_t), sizeof(length));
+    if ((length < sizeof(SIMCONNECT_RECV)) || ((pos + MessageRecorder::entryHeaderSize + length) > _size)) {
+        return false;
+    }
+    // The dispatcher trusts dwSize, so a message that claims to be longer than its entry ends the replay.
+    DWORD msgSize;
+    std::memcpy(&msgSize, _data + pos + MessageRecorder::entryHeaderSize + offsetof(SIMCONNECT_RECV, dwSize), sizeof(msgSize));
+    return msgSize <= length;
+}
+
+std::chrono::steady_clock::time_point ReplayBackend::due(std::uint64_t timestamp) const noexcept
+{
+    if (_speed <= 0.0) {
+        return _start;
+    }
+    const auto offset{ static_cast<double>(timestamp - _firstTimestamp) / _speed };
+    return _start + std::chrono::nanoseconds(static_cast<std::int64_t>(offset));
+}
+
+bool ReplayBackend::finished() const noexcept
+{
+    std::uint64_t timestamp;
+    std::uint32_t length;
+    return !nextEntry(timestamp, length);
+}
+
+HRESULT ReplayBackend::open([[maybe_unused]] const std::string& clientName)
+{
+    _pos = MessageRecorder::headerSize;
+    _lastSendId = 0;
+    _start = std::chrono::steady_clock::now();
+    _open = true;
+
+    return S_OK;
+}
+
+HRESULT ReplayBackend::close()
+{
+    if (!_open.exchange(false)) {
+        return E_FAIL;
+    }
+    wakeUp();
+    return S_OK;
+}
+
+HRESULT ReplayBackend::callDispatch(DispatchProc handler, void* context)
+{
+    SIMCONNECT_RECV* msgPtr;
+    DWORD msgLen;
+    while (SUCCEEDED(getNextDispatch(&msgPtr, &msgLen))) {
+        handler(msgPtr, msgLen, context);
+    }
+    return S_OK;
+}
+
+HRESULT ReplayBackend::getNextDispatch(SIMCONNECT_RECV** msgPtr, DWORD* msgLen)
+{
+    std::uint64_t timestamp;
+    std::uint32_t length;
+    if (!_open || !nextEntry(timestamp, length) || (std::chrono::steady_clock::now() < due(timestamp))) {
+        return E_FAIL;
+    }
+    const size_t pos{ _pos.load(std::memory_order_relaxed) };
+    *msgPtr = reinterpret_cast<SIMCONNECT_RECV*>(_file->data() + pos + MessageRecorder::entryHeaderSize);
+    *msgLen = length;
+    _pos.store(pos + MessageRecorder::entryHeaderSize + MessageRecorder::paddedSize(length), std::memory_order_relaxed);
+    _replayed++;
+
+    return S_OK;
+}
+
+bool ReplayBackend::waitForDispatch(std::chrono::milliseconds timeout)
+{
+    auto until{ std::chrono::steady_clock::now() + timeout };
+
+    std::uint64_t timestamp;
+    std::uint32_t length;
+    const bool pending{ _open && nextEntry(timestamp, length) };
+    if (pending) {
+        const auto next{ due(timestamp) };
+        if (next <= std::chrono::steady_clock::now()) {
+            return true;
+        }
+        until = std::min(until, next);
+    }
+    std::unique_lock lock(_mutex);
+    const bool woken{ _wakeUpCv.wait_until(lock, until, [this] { return _wakeUp; }) };
+    _wakeUp = false;
+
+    return woken || (pending && (std::chrono::steady_clock::now() >= until));
+}
+
+void ReplayBackend::wakeUp() noexcept
+{
+    {
+        std::lock_guard lock(_mutex);
+        _wakeUp = true;
+    }
+    _wakeUpCv.notify_one();
+}
+
+HRESULT ReplayBackend::getLastSentPacketId(DWORD* sendId)
+{
+    *sendId = _lastSendId;
+    return S_OK;
+}
+
+HRESULT ReplayBackend::requestSystemState([[maybe_unused]] DWORD reqId, [[maybe_unused]] const char* stateName)
+{
+    ++_lastSendId;
+    return _open ? S_OK : E_FAIL;
+}
+
+HRESULT ReplayBackend::subscribeToSystemEvent([[maybe_unused]] DWORD eventId, [[maybe_unused]] const char* eventName)
+{
+    ++_lastSendId;
+    return _open ? S_OK : E_FAIL;
+}
+
+HRESULT ReplayBackend::addToDataDefinition([[maybe_unused]] DWORD defineId, [[maybe_unused]] const char* datumName, [[maybe_unused]] const char* unitsName,
+                                           [[maybe_unused]] SIMCONNECT_DATATYPE datumType, [[maybe_unused]] float epsilon, [[maybe_unused]] DWORD datumId)
+{
+    ++_lastSendId;
+    return _open ? S_OK : E_FAIL;
+}
+
+HRESULT ReplayBackend::requestDataOnSimObject([[maybe_unused]] DWORD reqId, [[maybe_unused]] DWORD defineId, [[maybe_unused]] DWORD objectId, [[maybe_unused]] SIMCONNECT_PERIOD period,
+                                              [[maybe_unused]] DWORD flags, [[maybe_unused]] DWORD origin, [[maybe_unused]] DWORD interval, [[maybe_unused]] DWORD limit)
+{
+    ++_lastSendId;
+    return _open ? S_OK : E_FAIL;
+}
+
+HRESULT ReplayBackend::mapClientEventToSimEvent([[maybe_unused]] DWORD eventId, [[maybe_unused]] const char* eventName)
+{
+    ++_lastSendId;
+    return _open ? S_OK : E_FAIL;
+}
+
+HRESULT ReplayBackend::addClientEventToNotificationGroup([[maybe_unused]] DWORD groupId, [[maybe_unused]] DWORD eventId, [[maybe_unused]] bool maskable)
+{
+    ++_lastSendId;
+    return _open ? S_OK : E_FAIL;
+}
+
+HRESULT ReplayBackend::setNotificationGroupPriority([[maybe_unused]] DWORD groupId, [[maybe_unused]] DWORD priority)
+{
+    ++_lastSendId;
+    return _open ? S_OK : E_FAIL;
+}
\ No newline at end of file
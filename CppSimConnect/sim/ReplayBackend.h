@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+#include "SimBackend.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>A backend that plays back a file written by a MessageRecorder.</summary>
+	 *
+	 * The file is memory-mapped, and the messages are handed to the dispatcher where they lie in it. They
+	 * arrive at the recorded pace, a multiple of it, or as fast as the dispatcher takes them. Each open()
+	 * starts from the beginning. Requests are accepted but never answered; the replies are whatever was
+	 * recorded. A file that isn't a recording causes a std::runtime_error; one that ends in the middle of a
+	 * message, or holds a message whose dwSize is larger than its entry, just ends early.
+	 */
+	class ReplayBackend : public SimBackend {
+		class MappedFile;
+
+		std::unique_ptr<MappedFile> _file;
+		const std::byte* _data{ nullptr };
+		size_t _size{ 0 };
+		double _speed;
+
+		std::atomic_bool _open{ false };
+		std::atomic<size_t> _pos{ 0 };		// Only the dispatcher thread moves it
+		std::uint64_t _firstTimestamp{ 0 };
+		std::chrono::steady_clock::time_point _start;
+		DWORD _lastSendId{ 0 };
+
+		std::mutex _mutex;
+		std::condition_variable _wakeUpCv;
+		bool _wakeUp{ false };
+
+		std::atomic<std::uint64_t> _replayed{ 0 };
+
+		bool nextEntry(std::uint64_t& timestamp, std::uint32_t& length) const noexcept;
+		std::chrono::steady_clock::time_point due(std::uint64_t timestamp) const noexcept;
+
+	public:
+		static constexpr double recordedSpeed{ 1.0 };
+		static constexpr double asFastAsPossible{ 0.0 };
+
+		/**
+		 * <summary>Replay a recording at <c>speed</c> times the recorded pace, or as fast as possible for 0.</summary>
+		 */
+		ReplayBackend(const std::filesystem::path& file, double speed = recordedSpeed);
+		~ReplayBackend() override;
+
+		inline std::uint64_t messagesReplayed() const noexcept { return _replayed; }
+		bool finished() const noexcept;		// All messages have been handed out
+
+		// SimBackend
+		HRESULT open(const std::string& clientName) override;
+		HRESULT close() override;
+		bool isOpen() const noexcept override { return _open; }
+
+		HRESULT callDispatch(DispatchProc handler, void* context) override;
+		HRESULT getNextDispatch(SIMCONNECT_RECV** msgPtr, DWORD* msgLen) override;
+
+		bool waitForDispatch(std::chrono::milliseconds timeout) override;
+		void wakeUp() noexcept override;
+
+		HRESULT getLastSentPacketId(DWORD* sendId) override;
+		HRESULT requestSystemState(DWORD reqId, const char* stateName) override;
+		HRESULT subscribeToSystemEvent(DWORD eventId, const char* eventName) override;
+		HRESULT addToDataDefinition(DWORD defineId, const char* datumName, const char* unitsName, SIMCONNECT_DATATYPE datumType, float epsilon, DWORD datumId) override;
+		HRESULT requestDataOnSimObject(DWORD reqId, DWORD defineId, DWORD objectId, SIMCONNECT_PERIOD period, DWORD flags, DWORD origin, DWORD interval, DWORD limit) override;
+		HRESULT mapClientEventToSimEvent(DWORD eventId, const char* eventName) override;
+		HRESULT addClientEventToNotificationGroup(DWORD groupId, DWORD eventId, bool maskable) override;
+		HRESULT setNotificationGroupPriority(DWORD groupId, DWORD priority) override;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>Maps RequestIDs to their observers.</summary>
+	 *
+	 * A RequestID is the index of a slot in the table, with the slot's generation in the top bits. Slots
+	 * are recycled, and the generation is bumped on each reuse, so a late reply for an old request is not
+	 * delivered to a new one.
+	 *
+	 * Any thread can register and retire requests without taking a lock. Lookups are meant for the
+	 * dispatcher thread: it gets a reference to the value, which stays valid until the dispatcher calls
+	 * reclaim(). Only then are the values of retired slots released and their slots made available again.
+	 */
+	template <typename T>
+	class RequestTable {
+	public:
+		static constexpr unsigned indexBits{ 22 };
+		static constexpr std::uint32_t indexMask{ (1u << indexBits) - 1 };
+		static constexpr std::uint32_t invalidId{ 0xffffffff };
+
+	private:
+		static constexpr unsigned pageBits{ 12 };
+		static constexpr std::uint32_t pageSize{ 1u << pageBits };
+		static constexpr std::uint32_t maxPages{ (indexMask + 1) >> pageBits };
+		static constexpr std::uint32_t maxSlots{ indexMask };	// Index "all ones" is never used, so invalidId can never be live
+		static constexpr std::uint32_t noSlot{ 0xffffffff };
+
+		struct Slot {
+			std::atomic<std::uint32_t> id{ invalidId };	// The live RequestID, or invalidId
+			std::uint32_t generation{ 0 };
+			std::atomic<std::uint32_t> nextFree{ noSlot };
+			std::atomic<std::uint32_t> nextRetired{ noSlot };
+			T value;
+		};
+		using Page = std::array<Slot, pageSize>;
+
+		std::array<std::atomic<Page*>, maxPages> _pages{};
+		std::atomic<std::uint32_t> _highWater{ 0 };
+		std::atomic<std::uint64_t> _freeList{ noSlot };		// Slot index in the low half, ABA counter in the high half
+		std::atomic<std::uint32_t> _retired{ noSlot };
+		std::atomic<size_t> _size{ 0 };
+
+		Slot& slot(std::uint32_t index) const noexcept {
+			return (*_pages[index >> pageBits].load(std::memory_order_acquire))[index & (pageSize - 1)];
+		}
+
+		Slot* findSlot(std::uint32_t id) const noexcept {
+			const std::uint32_t index{ id & indexMask };
+			if (index >= _highWater.load(std::memory_order_acquire)) {
+				return nullptr;
+			}
+			Page* page = _pages[index >> pageBits].load(std::memory_order_acquire);
+			return (page == nullptr) ? nullptr : &(*page)[index & (pageSize - 1)];
+		}
+
+		std::uint32_t popFree() noexcept {
+			std::uint64_t head = _freeList.load(std::memory_order_acquire);
+			while (static_cast<std::uint32_t>(head) != noSlot) {
+				const std::uint32_t index{ static_cast<std::uint32_t>(head) };
+				const std::uint64_t next{ ((head >> 32) + 1) << 32 | slot(index).nextFree.load(std::memory_order_relaxed) };
+				if (_freeList.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+					return index;
+				}
+			}
+			return noSlot;
+		}
+
+		void pushFree(std::uint32_t index) noexcept {
+			std::uint64_t head = _freeList.load(std::memory_order_relaxed);
+			std::uint64_t next;
+			do {
+				slot(index).nextFree.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+				next = ((head >> 32) + 1) << 32 | index;
+			} while (!_freeList.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		void pushRetired(Slot& s, std::uint32_t index) noexcept {
+			std::uint32_t head = _retired.load(std::memory_order_relaxed);
+			do {
+				s.nextRetired.store(head, std::memory_order_relaxed);
+			} while (!_retired.compare_exchange_weak(head, index, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		std::uint32_t allocate() {
+			std::uint32_t index = popFree();
+			if (index != noSlot) {
+				return index;
+			}
+			index = _highWater.load(std::memory_order_relaxed);
+			do {
+				if (index >= maxSlots) {
+					throw std::length_error("Too many outstanding requests");
+				}
+				auto& page = _pages[index >> pageBits];
+				if (page.load(std::memory_order_acquire) == nullptr) {
+					auto newPage = std::make_unique<Page>();
+					Page* expected{ nullptr };
+					if (page.compare_exchange_strong(expected, newPage.get(), std::memory_order_acq_rel)) {
+						newPage.release();
+					}
+				}
+			} while (!_highWater.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+			return index;
+		}
+
+	public:
+		RequestTable() = default;
+		~RequestTable() {
+			for (auto& page : _pages) {
+				delete page.load(std::memory_order_relaxed);
+			}
+		}
+		RequestTable(RequestTable const&) = delete;
+		RequestTable(RequestTable&&) = delete;
+		RequestTable& operator=(RequestTable const&) = delete;
+		RequestTable& operator=(RequestTable&&) = delete;
+
+		/**
+		 * <summary>Store the value in a free slot and return its RequestID.</summary>
+		 */
+		std::uint32_t add(T value) {
+			const std::uint32_t index{ allocate() };
+			Slot& s{ slot(index) };
+			const std::uint32_t id{ (s.generation << indexBits) | index };
+
+			s.value = std::move(value);
+			s.id.store(id, std::memory_order_release);
+			_size.fetch_add(1, std::memory_order_relaxed);
+
+			return id;
+		}
+
+		/**
+		 * <summary>Look up the value for a RequestID, returning nullptr for unknown, retired, or stale IDs.</summary>
+		 */
+		T* find(std::uint32_t id) noexcept {
+			Slot* s = findSlot(id);
+			return ((s != nullptr) && (s->id.load(std::memory_order_acquire) == id)) ? &s->value : nullptr;
+		}
+
+		/**
+		 * <summary>Stop delivering to the RequestID. Returns false if it was not live.</summary>
+		 */
+		bool retire(std::uint32_t id) noexcept {
+			Slot* s = findSlot(id);
+			std::uint32_t expected{ id };
+			if ((s == nullptr) || !s->id.compare_exchange_strong(expected, invalidId, std::memory_order_acq_rel)) {
+				return false;
+			}
+			_size.fetch_sub(1, std::memory_order_relaxed);
+			pushRetired(*s, id & indexMask);
+
+			return true;
+		}
+
+		/**
+		 * <summary>Retire every live RequestID, and pass each a copy of its value. Returns the number retired.</summary>
+		 *
+		 * The value is copied before its slot can be reclaimed, so the dispatcher may go on reclaiming meanwhile.
+		 */
+		template <typename F>
+		size_t retireAll(F&& f) {
+			size_t count{ 0 };
+			const std::uint32_t highWater{ _highWater.load(std::memory_order_acquire) };
+			for (std::uint32_t index = 0; index < highWater; index++) {
+				Slot* s = findSlot(index);
+				std::uint32_t id{ (s == nullptr) ? invalidId : s->id.load(std::memory_order_acquire) };
+				if ((id == invalidId) || !s->id.compare_exchange_strong(id, invalidId, std::memory_order_acq_rel)) {
+					continue;
+				}
+				_size.fetch_sub(1, std::memory_order_relaxed);
+				T value{ s->value };
+				pushRetired(*s, index);
+
+				f(value);
+				count++;
+			}
+			return count;
+		}
+
+		/**
+		 * <summary>Release the values of retired slots and make the slots available again. Only to be called by
+		 * the dispatcher thread, when it holds no references obtained through find().</summary>
+		 */
+		void reclaim() {
+			std::uint32_t index = _retired.exchange(noSlot, std::memory_order_acquire);
+			while (index != noSlot) {
+				Slot& s{ slot(index) };
+				const std::uint32_t next{ s.nextRetired.load(std::memory_order_relaxed) };
+
+				s.value = T{};
+				s.generation = (s.generation + 1) & (0xffffffff >> indexBits);
+				pushFree(index);
+
+				index = next;
+			}
+		}
+
+		inline size_t size() const noexcept { return _size.load(std::memory_order_relaxed); }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "SimConnectTypes.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>The transport underneath a connection.</summary>
+	 *
+	 * All calls that go out to the simulator pass through here, so the rest of the library never calls
+	 * <c>SimConnect_*</c> functions directly. The default implementation forwards to the SimConnect
+	 * library, but anything that produces <c>SIMCONNECT_RECV</c> messages can take its place.
+	 * A backend serves a single connection at a time and is not expected to be thread-safe; SimState
+	 * serializes access.
+	 */
+	class SimBackend {
+	public:
+		SimBackend() = default;
+		virtual ~SimBackend() = default;
+		SimBackend(SimBackend const&) = delete;
+		SimBackend(SimBackend&&) = delete;
+		SimBackend& operator=(SimBackend const&) = delete;
+		SimBackend& operator=(SimBackend&&) = delete;
+
+		// Connection management
+		virtual HRESULT open(const std::string& clientName) = 0;
+		virtual HRESULT close() = 0;
+		virtual bool isOpen() const noexcept = 0;
+
+		// Receiving messages. A message returned by getNextDispatch() stays valid until the next call.
+		virtual HRESULT callDispatch(DispatchProc handler, void* context) = 0;
+		virtual HRESULT getNextDispatch(SIMCONNECT_RECV** msgPtr, DWORD* msgLen) = 0;
+
+		// Waiting for messages. waitForDispatch() returns true if messages may have arrived, and false if it timed out.
+		// wakeUp() makes a (current or next) call to waitForDispatch() return early, and may be called from any thread.
+		virtual bool waitForDispatch(std::chrono::milliseconds timeout) = 0;
+		virtual void wakeUp() noexcept = 0;
+
+		// Sending requests
+		virtual HRESULT getLastSentPacketId(DWORD* sendId) = 0;
+		virtual HRESULT requestSystemState(DWORD reqId, const char* stateName) = 0;
+		virtual HRESULT subscribeToSystemEvent(DWORD eventId, const char* eventName) = 0;
+		virtual HRESULT addToDataDefinition(DWORD defineId, const char* datumName, const char* unitsName, SIMCONNECT_DATATYPE datumType, float epsilon, DWORD datumId) = 0;
+		virtual HRESULT requestDataOnSimObject(DWORD reqId, DWORD defineId, DWORD objectId, SIMCONNECT_PERIOD period, DWORD flags, DWORD origin, DWORD interval, DWORD limit) = 0;
+
+		// Client events
+		virtual HRESULT mapClientEventToSimEvent(DWORD eventId, const char* eventName) = 0;
+		virtual HRESULT addClientEventToNotificationGroup(DWORD groupId, DWORD eventId, bool maskable) = 0;
+		virtual HRESULT setNotificationGroupPriority(DWORD groupId, DWORD priority) = 0;
+	};
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../pch.h"
+
+#include "SimConnectBackend.h"
+
+using CppSimConnect::SimConnectBackend;
+
+
+SimConnectBackend::SimConnectBackend() :
+    _dataReady{ CreateEvent(nullptr, FALSE, FALSE, nullptr) }
+{
+}
+
+SimConnectBackend::~SimConnectBackend()
+{
+    if (_handle != nullptr) {
+        close();
+    }
+    if (_dataReady != nullptr) {
+        CloseHandle(_dataReady);
+    }
+}
+
+HRESULT SimConnectBackend::open(const std::string& clientName)
+{
+    HANDLE h;
+    HRESULT result = SimConnect_Open(&h, clientName.c_str(), nullptr, 0, _dataReady, 0);
+    if (SUCCEEDED(result)) {
+        _handle = h;
+    }
+    return result;
+}
+
+HRESULT SimConnectBackend::close()
+{
+    HANDLE h{ _handle };
+    _handle = nullptr;
+
+    return SimConnect_Close(h);
+}
+
+HRESULT SimConnectBackend::callDispatch(DispatchProc handler, void* context)
+{
+    return SimConnect_CallDispatch(_handle, handler, context);
+}
+
+HRESULT SimConnectBackend::getNextDispatch(SIMCONNECT_RECV** msgPtr, DWORD* msgLen)
+{
+    return SimConnect_GetNextDispatch(_handle, msgPtr, msgLen);
+}
+
+bool SimConnectBackend::waitForDispatch(std::chrono::milliseconds timeout)
+{
+    return WaitForSingleObject(_dataReady, static_cast<DWORD>(timeout.count())) == WAIT_OBJECT_0;
+}
+
+void SimConnectBackend::wakeUp() noexcept
+{
+    SetEvent(_dataReady);
+}
+
+HRESULT SimConnectBackend::getLastSentPacketId(DWORD* sendId)
+{
+    return SimConnect_GetLastSentPacketID(_handle, sendId);
+}
+
+HRESULT SimConnectBackend::requestSystemState(DWORD reqId, const char* stateName)
+{
+    return SimConnect_RequestSystemState(_handle, reqId, stateName);
+}
+
+HRESULT SimConnectBackend::subscribeToSystemEvent(DWORD eventId, const char* eventName)
+{
+    return SimConnect_SubscribeToSystemEvent(_handle, eventId, eventName);
+}
+
+HRESULT SimConnectBackend::addToDataDefinition(DWORD defineId, const char* datumName, const char* unitsName, SIMCONNECT_DATATYPE datumType, float epsilon, DWORD datumId)
+{
+    return SimConnect_AddToDataDefinition(_handle, defineId, datumName, unitsName, datumType, epsilon, datumId);
+}
+
+HRESULT SimConnectBackend::requestDataOnSimObject(DWORD reqId, DWORD defineId, DWORD objectId, SIMCONNECT_PERIOD period, DWORD flags, DWORD origin, DWORD interval, DWORD limit)
+{
+    return SimConnect_RequestDataOnSimObject(_handle, reqId, defineId, objectId, period, flags, origin, interval, limit);
+}
+
+HRESULT SimConnectBackend::mapClientEventToSimEvent(DWORD eventId, const char* eventName)
+{
+    return SimConnect_MapClientEventToSimEvent(_handle, eventId, eventName);
+}
+
+HRESULT SimConnectBackend::addClientEventToNotificationGroup(DWORD groupId, DWORD eventId, bool maskable)
+{
+    return SimConnect_AddClientEventToNotificationGroup(_handle, groupId, eventId, maskable ? TRUE : FALSE);
+}
+
+HRESULT SimConnectBackend::setNotificationGroupPriority(DWORD groupId, DWORD priority)
+{
+    return SimConnect_SetNotificationGroupPriority(_handle, groupId, priority);
+}
\ No newline at end of file
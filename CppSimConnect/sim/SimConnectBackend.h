@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "SimBackend.h"
+
+
+namespace CppSimConnect {
+
+	/**
+	 * <summary>The SimBackend that talks to a real simulator through the SimConnect library.</summary>
+	 */
+	class SimConnectBackend : public SimBackend {
+		HANDLE _handle{ nullptr };
+		HANDLE _dataReady{ nullptr };	// Signalled by SimConnect when messages arrive
+
+	public:
+		SimConnectBackend();
+		~SimConnectBackend() override;
+
+		HRESULT open(const std::string& clientName) override;
+		HRESULT close() override;
+		bool isOpen() const noexcept override { return _handle != nullptr; }
+
+		HRESULT callDispatch(DispatchProc handler, void* context) override;
+		HRESULT getNextDispatch(SIMCONNECT_RECV** msgPtr, DWORD* msgLen) override;
+
+		bool waitForDispatch(std::chrono::milliseconds timeout) override;
+		void wakeUp() noexcept override;
+
+		HRESULT getLastSentPacketId(DWORD* sendId) override;
+		HRESULT requestSystemState(DWORD reqId, const char* stateName) override;
+		HRESULT subscribeToSystemEvent(DWORD eventId, const char* eventName) override;
+		HRESULT addToDataDefinition(DWORD defineId, const char* datumName, const char* unitsName, SIMCONNECT_DATATYPE datumType, float epsilon, DWORD datumId) override;
+		HRESULT requestDataOnSimObject(DWORD reqId, DWORD defineId, DWORD objectId, SIMCONNECT_PERIOD period, DWORD flags, DWORD origin, DWORD interval, DWORD limit) override;
+		HRESULT mapClientEventToSimEvent(DWORD eventId, const char* eventName) override;
+		HRESULT addClientEventToNotificationGroup(DWORD groupId, DWORD eventId, bool maskable) override;
+		HRESULT setNotificationGroupPriority(DWORD groupId, DWORD priority) override;
+	};
+}
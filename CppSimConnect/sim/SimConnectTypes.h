@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/*
+ * The Windows and SimConnect types the library uses. On Windows these come from the SDK. Elsewhere only the
+ * fake and replay backends can be used, and they need no more than the message layouts and constants below,
+ * which follow the SDK's SimConnect.h.
+ */
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#pragma warning(disable:4245)
+#include <windows.h>
+#include <SimConnect.h>
+#pragma warning(default:4245)
+
+#else
+
+#include <cstdint>
+
+using DWORD = std::uint32_t;
+using HRESULT = std::int32_t;
+
+#define S_OK ((HRESULT)0L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#ifndef MAX_PATH
+#define MAX_PATH 260
+#endif
+
+constexpr DWORD SIMCONNECT_UNUSED{ 0xFFFFFFFF };
+constexpr DWORD SIMCONNECT_OBJECT_ID_USER{ 0 };
+constexpr DWORD SIMCONNECT_GROUP_PRIORITY_HIGHEST{ 1 };
+constexpr DWORD SIMCONNECT_GROUP_PRIORITY_HIGHEST_MASKABLE{ 10000000 };
+constexpr DWORD SIMCONNECT_GROUP_PRIORITY_STANDARD{ 1900000000 };
+constexpr DWORD SIMCONNECT_GROUP_PRIORITY_DEFAULT{ 2000000000 };
+constexpr DWORD SIMCONNECT_GROUP_PRIORITY_LOWEST{ 4000000000 };
+
+constexpr DWORD SIMCONNECT_DATA_REQUEST_FLAG_DEFAULT{ 0x00000000 };
+constexpr DWORD SIMCONNECT_DATA_REQUEST_FLAG_CHANGED{ 0x00000001 };
+constexpr DWORD SIMCONNECT_DATA_REQUEST_FLAG_TAGGED{ 0x00000002 };
+
+enum SIMCONNECT_RECV_ID {
+	SIMCONNECT_RECV_ID_NULL,
+	SIMCONNECT_RECV_ID_EXCEPTION,
+	SIMCONNECT_RECV_ID_OPEN,
+	SIMCONNECT_RECV_ID_QUIT,
+	SIMCONNECT_RECV_ID_EVENT,
+	SIMCONNECT_RECV_ID_EVENT_OBJECT_ADDREMOVE,
+	SIMCONNECT_RECV_ID_EVENT_FILENAME,
+	SIMCONNECT_RECV_ID_EVENT_FRAME,
+	SIMCONNECT_RECV_ID_SIMOBJECT_DATA,
+	SIMCONNECT_RECV_ID_SIMOBJECT_DATA_BYTYPE,
+	SIMCONNECT_RECV_ID_WEATHER_OBSERVATION,
+	SIMCONNECT_RECV_ID_CLOUD_STATE,
+	SIMCONNECT_RECV_ID_ASSIGNED_OBJECT_ID,
+	SIMCONNECT_RECV_ID_RESERVED_KEY,
+	SIMCONNECT_RECV_ID_CUSTOM_ACTION,
+	SIMCONNECT_RECV_ID_SYSTEM_STATE,
+	SIMCONNECT_RECV_ID_CLIENT_DATA,
+};
+
+enum SIMCONNECT_DATATYPE {
+	SIMCONNECT_DATATYPE_INVALID,
+	SIMCONNECT_DATATYPE_INT32,
+	SIMCONNECT_DATATYPE_INT64,
+	SIMCONNECT_DATATYPE_FLOAT32,
+	SIMCONNECT_DATATYPE_FLOAT64,
+	SIMCONNECT_DATATYPE_STRING8,
+	SIMCONNECT_DATATYPE_STRING32,
+	SIMCONNECT_DATATYPE_STRING64,
+	SIMCONNECT_DATATYPE_STRING128,
+	SIMCONNECT_DATATYPE_STRING256,
+	SIMCONNECT_DATATYPE_STRING260,
+	SIMCONNECT_DATATYPE_STRINGV,
+};
+
+enum SIMCONNECT_EXCEPTION {
+	SIMCONNECT_EXCEPTION_NONE,
+	SIMCONNECT_EXCEPTION_ERROR,
+	SIMCONNECT_EXCEPTION_SIZE_MISMATCH,
+	SIMCONNECT_EXCEPTION_UNRECOGNIZED_ID,
+	SIMCONNECT_EXCEPTION_UNOPENED,
+	SIMCONNECT_EXCEPTION_VERSION_MISMATCH,
+	SIMCONNECT_EXCEPTION_TOO_MANY_GROUPS,
+	SIMCONNECT_EXCEPTION_NAME_UNRECOGNIZED,
+	SIMCONNECT_EXCEPTION_TOO_MANY_EVENT_NAMES,
+	SIMCONNECT_EXCEPTION_EVENT_ID_DUPLICATE,
+	SIMCONNECT_EXCEPTION_TOO_MANY_MAPS,
+	SIMCONNECT_EXCEPTION_TOO_MANY_OBJECTS,
+	SIMCONNECT_EXCEPTION_TOO_MANY_REQUESTS,
+	SIMCONNECT_EXCEPTION_WEATHER_INVALID_PORT,
+	SIMCONNECT_EXCEPTION_WEATHER_INVALID_METAR,
+	SIMCONNECT_EXCEPTION_WEATHER_UNABLE_TO_GET_OBSERVATION,
+	SIMCONNECT_EXCEPTION_WEATHER_UNABLE_TO_CREATE_STATION,
+	SIMCONNECT_EXCEPTION_WEATHER_UNABLE_TO_REMOVE_STATION,
+	SIMCONNECT_EXCEPTION_INVALID_DATA_TYPE,
+	SIMCONNECT_EXCEPTION_INVALID_DATA_SIZE,
+	SIMCONNECT_EXCEPTION_DATA_ERROR,
+	SIMCONNECT_EXCEPTION_INVALID_ARRAY,
+	SIMCONNECT_EXCEPTION_CREATE_OBJECT_FAILED,
+	SIMCONNECT_EXCEPTION_LOAD_FLIGHTPLAN_FAILED,
+	SIMCONNECT_EXCEPTION_OPERATION_INVALID_FOR_OBJECT_TYPE,
+	SIMCONNECT_EXCEPTION_ILLEGAL_OPERATION,
+	SIMCONNECT_EXCEPTION_ALREADY_SUBSCRIBED,
+	SIMCONNECT_EXCEPTION_INVALID_ENUM,
+	SIMCONNECT_EXCEPTION_DEFINITION_ERROR,
+	SIMCONNECT_EXCEPTION_DUPLICATE_ID,
+	SIMCONNECT_EXCEPTION_DATUM_ID,
+	SIMCONNECT_EXCEPTION_OUT_OF_BOUNDS,
+	SIMCONNECT_EXCEPTION_ALREADY_CREATED,
+	SIMCONNECT_EXCEPTION_OBJECT_OUTSIDE_REALITY_BUBBLE,
+	SIMCONNECT_EXCEPTION_OBJECT_CONTAINER,
+	SIMCONNECT_EXCEPTION_OBJECT_AI,
+	SIMCONNECT_EXCEPTION_OBJECT_ATC,
+	SIMCONNECT_EXCEPTION_OBJECT_SCHEDULE,
+};
+
+enum SIMCONNECT_PERIOD {
+	SIMCONNECT_PERIOD_NEVER,
+	SIMCONNECT_PERIOD_ONCE,
+	SIMCONNECT_PERIOD_VISUAL_FRAME,
+	SIMCONNECT_PERIOD_SIM_FRAME,
+	SIMCONNECT_PERIOD_SECOND,
+};
+
+#pragma pack(push, 1)
+
+struct SIMCONNECT_RECV {
+	DWORD dwSize;
+	DWORD dwVersion;
+	DWORD dwID;
+};
+
+struct SIMCONNECT_RECV_EXCEPTION : public SIMCONNECT_RECV {
+	DWORD dwException;
+	DWORD dwSendID;
+	DWORD dwIndex;
+};
+
+struct SIMCONNECT_RECV_OPEN : public SIMCONNECT_RECV {
+	char szApplicationName[256];
+	DWORD dwApplicationVersionMajor;
+	DWORD dwApplicationVersionMinor;
+	DWORD dwApplicationBuildMajor;
+	DWORD dwApplicationBuildMinor;
+	DWORD dwSimConnectVersionMajor;
+	DWORD dwSimConnectVersionMinor;
+	DWORD dwSimConnectBuildMajor;
+	DWORD dwSimConnectBuildMinor;
+	DWORD dwReserved1;
+	DWORD dwReserved2;
+};
+
+struct SIMCONNECT_RECV_QUIT : public SIMCONNECT_RECV {
+};
+
+struct SIMCONNECT_RECV_EVENT : public SIMCONNECT_RECV {
+	DWORD uGroupID;
+	DWORD uEventID;
+	DWORD dwData;
+};
+
+struct SIMCONNECT_RECV_EVENT_FILENAME : public SIMCONNECT_RECV_EVENT {
+	char szFileName[MAX_PATH];
+	DWORD dwFlags;
+};
+
+struct SIMCONNECT_RECV_EVENT_FRAME : public SIMCONNECT_RECV_EVENT {
+	float fFrameRate;
+	float fSimSpeed;
+};
+
+struct SIMCONNECT_RECV_SIMOBJECT_DATA : public SIMCONNECT_RECV {
+	DWORD dwRequestID;
+	DWORD dwObjectID;
+	DWORD dwDefineID;
+	DWORD dwFlags;
+	DWORD dwentrynumber;
+	DWORD dwoutof;
+	DWORD dwDefineCount;
+	DWORD dwData;
+};
+
+struct SIMCONNECT_RECV_SYSTEM_STATE : public SIMCONNECT_RECV {
+	DWORD dwRequestID;
+	DWORD dwInteger;
+	float fFloat;
+	char szString[MAX_PATH];
+};
+
+#pragma pack(pop)
+
+typedef void (*DispatchProc)(SIMCONNECT_RECV* pData, DWORD cbData, void* pContext);
+
+#endif
@@ -16,6 +16,9 @@
 
 #include "../pch.h"
 
+#include "../exceptions/NotConnected.h"
+
+#include "MessageRecorder.h"
 #include "SimState.h"
 
 using CppSimConnect::LogLevel;
@@ -29,11 +32,19 @@ bool SimConnect::simConnect(bool byAutoConnect)
         _logger.warn("Forcing SimConnect_Close() to clean up old handle.");
         simDisconnect();
     }
-    HANDLE h;
-    HRESULT result = SimConnect_Open(&h, _clientName.c_str(), nullptr, 0, nullptr, 0);
+    HRESULT result = _backend->open(_clientName);
     if (SUCCEEDED(result)) {
-        _state = std::make_unique<SimState>(_logger);
-        _state->_handle = h;
+        auto state = std::make_unique<SimState>(_logger, *_backend, _exceptionDepth, _earlyErrorMaxAge);
+        if (_cacheSystemStates) {
+            state->enableSystemStateCache();
+        }
+        else {
+            state->disableSystemStateCache();
+        }
+        if (_timingStats) {
+            state->enableTiming();
+        }
+        simActivateState(std::move(state));
     }
     else if (!byAutoConnect) {
         long long bigInt = static_cast<unsigned long>(result);
@@ -47,39 +58,59 @@ bool SimConnect::simDisconnect() noexcept
     if (!_state) {
         return false; // Already disconnected
     }
-    if (_state->_handle == nullptr) {
+    if (!_backend->isOpen()) {
         _logger.warn("Not connected, but cleaning up state.");
+        _state->failOutbound();
+        _state->failRequests();
+        std::lock_guard lock(_clientEventLock);
         _state.reset(nullptr);
 
         return false; // Already disconnected.. assuming we just forgot to clean up?
     }
-    HANDLE h{ _state->_handle };
-    _state->_handle = nullptr;
-
-    HRESULT result = SimConnect_Close(h);
+    HRESULT result = _backend->close();
     if (FAILED(result)) {
         _logger.error("Failed to disconnect from simulator.");
     }
+    _state->failOutbound();     // Nothing can be sent after closing
+    _state->failRequests();     // Nor will replies arrive for what was sent
     return SUCCEEDED(result);
 }
 
 void SimConnect::simDispatch() noexcept
 {
-    HRESULT dpResult = SimConnect_CallDispatch(_state->_handle, &SimState::cppSimConnect_handleMessage, this);
+    HRESULT dpResult = _backend->callDispatch(&SimState::cppSimConnect_handleMessage, this);
     if (FAILED(dpResult)) {
         _logger.error("Failed to start message dispatcher. (0x{:08x})", dpResult);
     }
+    if (_recorder) {
+        _recorder->flush();
+    }
 }
 
 void SimConnect::simDrainDispatchQueue() noexcept
 {
+    if (_state) {
+        _state->flushOutbound();
+    }
+
     SIMCONNECT_RECV* msgPtr;
     DWORD msgLen;
-    while (SUCCEEDED(SimConnect_GetNextDispatch(_state->_handle, &msgPtr, &msgLen))) {
+    std::uint64_t drained{ 0 };
+    while (SUCCEEDED(_backend->getNextDispatch(&msgPtr, &msgLen))) {
         if ((msgPtr == nullptr) || (msgLen < sizeof(SIMCONNECT_RECV)) || (msgPtr->dwID == SIMCONNECT_RECV_ID_NULL)) {
             break;
         }
         SimState::cppSimConnect_handleMessage(msgPtr, msgLen, this);
+        drained++;
+    }
+    if (_state) {
+        _state->reclaimRequests();
+        if (_state->_timing) {
+            _state->_timing->drained(drained);
+        }
+    }
+    if (_recorder) {
+        _recorder->flush();
     }
 }
 
@@ -127,45 +158,208 @@ static const std::array<std::string, cppSimConnect_NumExceptions> cppSimConnect_
     "AI: Scheduling error"
 };
 
+static const std::string& exceptionName(unsigned exceptionId) {
+    static const std::string unknown{ "Unknown exception" };
+    return (exceptionId < cppSimConnect_NumExceptions) ? cppSimConnect_Exceptions[exceptionId] : unknown;
+}
+
 void SimState::addExceptionHandler(DWORD sendID, ExceptionCallback handler) {
     ExceptionInfo earlyError{ SIMCONNECT_EXCEPTION_NONE, 0 };
-    bool haveError{ false };
-    {
-        std::lock_guard<std::mutex> lock(_onExceptMutex);
-
-        auto it = _earlyErrors.find(sendID);
-        if (it != _earlyErrors.end()) {
-            earlyError = it->second;
-            haveError = true;
-            _earlyErrors.erase(it);
+    ExceptionCallback unmatched{ _exceptions.add(sendID, std::move(handler), earlyError) };
+    if (unmatched) {
+        unmatched(earlyError.exceptionId, exceptionName(earlyError.exceptionId), earlyError.parmIndex);
+    }
+}
+
+void SimState::onExcept(DWORD sendID, unsigned exceptionId, unsigned parmIndex)
+{
+    ExceptionCallback handler{ _exceptions.match(sendID, { exceptionId, parmIndex }) };
+    if (handler) {
+        handler(exceptionId, exceptionName(exceptionId), parmIndex);
+    }
+    else {
+        _logger.debug("Exception '{}' for SendID {} arrived before its handler.", exceptionName(exceptionId), sendID);
+    }
+}
+
+/*
+ * Send all queued calls. SimConnect numbers the packets it sends on a connection consecutively, and
+ * only the dispatcher thread sends, so a single SimConnect_GetLastSentPacketID() after the batch gives
+ * us the SendIDs of all successful calls in it.
+ */
+void SimState::flushOutbound()
+{
+    OutboundCall* call = _outbound.takeAll();
+    if (call == nullptr) {
+        return;
+    }
+    _sentBatch.clear();
+    while (call != nullptr) {
+        OutboundCall* next = call->next;
+        if (SUCCEEDED(call->send(_backend))) {
+            _sentBatch.push_back(call);
         }
         else {
-            while (_onExcept.size() > _maxSenders) _onExcept.pop_front();
-            _onExcept.push_back({ sendID, handler });
+            _logger.error("Failed to send call to simulator.");
+            call->fail(exceptionName(SIMCONNECT_EXCEPTION_ERROR));
+            delete call;
         }
+        call = next;
     }
-    if (haveError) {
-        handler(earlyError.exceptionId, cppSimConnect_Exceptions[earlyError.exceptionId], earlyError.parmIndex);
+    if (_sentBatch.empty()) {
+        return;
     }
+
+    DWORD lastSendId{ 0 };
+    if (FAILED(_backend.getLastSentPacketId(&lastSendId))) {
+        _logger.error("Failed to retrieve SendID for {} call(s).", _sentBatch.size());
+        for (auto sent : _sentBatch) {
+            sent->fail(exceptionName(SIMCONNECT_EXCEPTION_ERROR));
+            delete sent;
+        }
+        _sentBatch.clear();
+        return;
+    }
+    DWORD sendId{ lastSendId - static_cast<DWORD>(_sentBatch.size() - 1) };
+    for (auto sent : _sentBatch) {
+        addExceptionHandler(sendId++, std::move(sent->onError));
+        delete sent;
+    }
+    _sentBatch.clear();
 }
 
-void SimState::onExcept(DWORD sendID, unsigned exceptionId, unsigned parmIndex)
+void SimState::failOutbound()
+{
+    if (!_outbound.empty()) {
+        _logger.warn("Dropping calls that were queued but not sent.");
+    }
+    _outbound.failAll(exceptionName(SIMCONNECT_EXCEPTION_ERROR));
+}
+
+/*
+ * Requests don't survive their connection, so end them all. Their streams and results get an error,
+ * rather than waiting for replies that will never come.
+ */
+void SimState::failRequests()
+{
+    const size_t failed{ _requests.retireAll([](RecvObserver& obs) { obs.onError(std::make_exception_ptr(NotConnected())); }) };
+    if (failed > 0) {
+        _logger.debug("Ended {} outstanding request(s) on disconnect.", failed);
+    }
+}
+
+void SimState::enableSystemStateCache()
+{
+    for (auto event : SystemStateCache::events) {
+        subscribeToSystemEvent(event, [this, event](unsigned, std::string const& msg, unsigned) {
+            _logger.warn("Failed to subscribe to system event '{}', not caching the states it affects. ({})", SystemEventNames[static_cast<size_t>(event)], msg);
+            _systemStateCache.disable(event);
+        });
+    }
+}
+
+void SimState::disableSystemStateCache()
 {
-    ExceptionCallback handler;
-    {
-        std::lock_guard<std::mutex> lock(_onExceptMutex);
-
-        for (const auto& exceptionHandler : _onExcept) {
-            if (sendID == exceptionHandler.sendID) {
-                handler = exceptionHandler.handler;
-                break;
+    for (auto event : SystemStateCache::events) {
+        _systemStateCache.disable(event);
+    }
+}
+
+void SimState::dispatchEvent(DWORD eventId, DWORD groupId, DWORD data, const char* fileName)
+{
+    if ((eventId >= systemEventIdBase) && ((eventId - systemEventIdBase) < SystemEventNames.size())) {
+        _systemStateCache.onEvent(static_cast<SystemEvent>(eventId - systemEventIdBase), data, fileName);
+    }
+    else if (eventId < _clientEventHandlers.size()) {
+        for (const auto& target : _clientEventHandlers[eventId]) {
+            if (target.groupId == groupId) {
+                target.handler(data);
             }
         }
-        if (!handler) {
-            _earlyErrors[sendID] = { exceptionId, parmIndex };
+    }
+    else {
+        _logger.debug("Ignoring event {}.", eventId);
+    }
+}
+
+void SimState::addClientEventHandler(EventID eventId, GroupID groupId, const ClientEventHandler& handler)
+{
+    if (!handler) {
+        return;
+    }
+    if (eventId >= _clientEventHandlers.size()) {
+        _clientEventHandlers.resize(eventId + 1);
+    }
+    _clientEventHandlers[eventId].push_back({ groupId, handler });
+}
+
+/*
+ * All calls go into the outbound queue without waiting for anything, so the dispatcher sends them in a
+ * single batch. Any exceptions come back later, and are matched to the event by their SendID.
+ */
+void SimState::registerClientEvents(const RegisteredEventSet& set)
+{
+    const auto& events{ set.events.events() };
+    auto onError = [this, &set](size_t index) -> ExceptionCallback {
+        return [this, &set, index](unsigned exceptionId, std::string const& msg, unsigned parmIndex) {
+            const auto& name{ set.events.events()[index].name };
+            _logger.warn("Failed to register client event '{}'. ({})", name, msg);
+            if (set.events.errorHandler()) {
+                set.events.errorHandler()(name, std::make_exception_ptr(SimException(exceptionId, msg, parmIndex)));
+            }
+        };
+    };
+
+    for (size_t i = 0; i < events.size(); i++) {
+        if (set.mapping[i]) {
+            submit(
+                [eventId = set.ids[i], &name = events[i].name](SimBackend& backend) { return backend.mapClientEventToSimEvent(eventId, name.c_str()); },
+                onError(i));
         }
     }
-    if (handler) {
-        handler(exceptionId, cppSimConnect_Exceptions[exceptionId], parmIndex);
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].notify) {
+            submit(
+                [this, eventId = set.ids[i], groupId = set.groupOf[i], &event = events[i]](SimBackend& backend) {
+                    addClientEventHandler(eventId, groupId, event.handler);
+                    return backend.addClientEventToNotificationGroup(groupId, eventId, event.maskable);
+                },
+                onError(i));
+        }
+    }
+    for (const auto& group : set.groups) {
+        submit(
+            [group](SimBackend& backend) { return backend.setNotificationGroupPriority(group.id, group.priority); },
+            [this, group](unsigned, std::string const& msg, unsigned) {
+                _logger.warn("Failed to set the priority of notification group {}. ({})", group.id, msg);
+            });
+    }
+    _logger.debug("Queued {} client event(s) in {} notification group(s).", events.size(), set.groups.size());
+}
+
+DWORD SimState::dataDefinition(const DataLayout& layout)
+{
+    std::lock_guard lock(_definitionLock);
+
+    auto it = _dataDefinitions.find(&layout);
+    if (it != _dataDefinitions.end()) {
+        return it->second;
+    }
+    const DWORD defineId{ static_cast<DWORD>(_dataDefinitions.size() + 1) };
+    _dataDefinitions.emplace(&layout, defineId);
+
+    DWORD datumId{ 0 };
+    for (const auto& datum : layout.data()) {
+        submit(
+            [defineId, &datum, datumId](SimBackend& backend) {
+                return backend.addToDataDefinition(defineId, datum.name.c_str(), datum.unit.empty() ? nullptr : datum.unit.c_str(),
+                                                   static_cast<SIMCONNECT_DATATYPE>(datum.type), datum.epsilon, datumId);
+            },
+            [this, defineId, &datum](unsigned, std::string const& msg, unsigned) {
+                _logger.error("Failed to add '{}' to data definition {}. ({})", datum.name, defineId, msg);
+            });
+        datumId++;
     }
+    _logger.debug("Registered data definition {} with {} variable(s).", defineId, layout.data().size());
+    return defineId;
 }
\ No newline at end of file
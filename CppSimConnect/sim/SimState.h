@@ -16,114 +16,216 @@
 
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
-#pragma warning(disable:4245)
-#include <windows.h>
-#include <SimConnect.h>
-#pragma warning(default:4245)
-
-#include <deque>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "../Logger.h"
 
+#include "../events/ClientEvent.h"
 #include "../exceptions/SimException.h"
+#include "../requests/DataDefinition.h"
+#include "../requests/SingleFlight.h"
+#include "../requests/SystemStateCache.h"
 #include "../reactive/StreamResult.h"
 
+#include "SimBackend.h"
+#include "DispatchTiming.h"
+#include "OutboundQueue.h"
+#include "ExceptionRing.h"
+#include "RecvViews.h"
+#include "RequestTable.h"
 
-namespace CppSimConnect {
 
-	struct ExceptionInfo {
-		DWORD exceptionId;
-		DWORD parmIndex;
-	};
+namespace CppSimConnect {
 
-	using ExceptionCallback = std::function<void(unsigned exceptionId, std::string const& msg, unsigned parmIndex)>;
-	struct ExceptionHandler {
-		DWORD sendID;
-		ExceptionCallback handler;
-	};
+	class SimConnect;
 
 	using RecvObserver = Reactive::StreamResult<SIMCONNECT_RECV*>;
 
 	class SimState {
 		Logger _logger;
-		std::mutex _simConnectMutex;		// SimConnect is not thread-safe
 
-		HANDLE _handle{ nullptr };
+		SimBackend& _backend;
 
-		unsigned _maxSenders{ 16 };
-		std::deque<ExceptionHandler> _onExcept;
-		std::map<DWORD, ExceptionInfo> _earlyErrors;
-		std::mutex _onExceptMutex;
+		// SimConnect is not thread-safe, so all calls are queued and sent by the dispatcher thread.
+		OutboundQueue _outbound;
+		std::vector<OutboundCall*> _sentBatch;
 
-		std::map<DWORD, RecvObserver> _messageObservers;
-		std::mutex _observerMutex;
+		ExceptionRing _exceptions;
 
-		inline DWORD sendIdOf(std::function<HRESULT()> call) {
-			std::lock_guard<std::mutex> lock(_simConnectMutex);
+		RequestTable<RecvObserver> _requests;
 
-			DWORD sendId{ 0 };
-			HRESULT hr = call();
+		SingleFlight<std::string> _stringStateFlights;
+		SingleFlight<bool> _boolStateFlights;
+		SystemStateCache _systemStateCache;
 
-			if (SUCCEEDED(hr)) {
-				if (FAILED(SimConnect_GetLastSentPacketID(_handle, &sendId))) {
-					_logger.error("Failed to retrieve SendID for call.");
-				}
-			}
-			return SUCCEEDED(hr) ? sendId : hr;
-		}
+		// Handlers for client events, by EventID. The simulator sends an event once for each group it is in, and
+		// each group has its own handler. They are installed as the events are sent, so only the dispatcher
+		// thread touches them.
+		struct ClientEventTarget {
+			GroupID groupId;
+			ClientEventHandler handler;
+		};
+		std::vector<std::vector<ClientEventTarget>> _clientEventHandlers;
+		void addClientEventHandler(EventID eventId, GroupID groupId, const ClientEventHandler& handler);
+
+		// Data definitions are registered with the simulator on first use, keyed by the layout of their struct.
+		std::mutex _definitionLock;
+		std::unordered_map<const DataLayout*, DWORD> _dataDefinitions;
+
+		// Only the dispatcher thread counts, but anyone may read.
+		std::array<std::atomic<std::uint64_t>, MessageStats::messageTypes> _messagesReceived{};
+		std::atomic<std::uint64_t> _messagesUnhandled{ 0 };
+		std::atomic<std::uint64_t> _messagesUndersized{ 0 };
+
+		// Only there if asked for, so an uninstrumented dispatcher doesn't even read the clock.
+		std::unique_ptr<DispatchTiming> _timing;
+
+		// Expires with this state, so whoever holds on to it can tell the connection is gone, even if a new state
+		// got the same address.
+		std::shared_ptr<const SimState*> _token{ std::make_shared<const SimState*>(this) };
 
 	public:
-		SimState(const Logger& logger) : _logger(logger) {}
+		static constexpr size_t defaultExceptionDepth{ 1024 };
+		static constexpr std::chrono::milliseconds defaultEarlyErrorMaxAge{ 5000 };
+
+		SimState(const Logger& logger, SimBackend& backend,
+				 size_t exceptionDepth = defaultExceptionDepth, std::chrono::milliseconds earlyErrorMaxAge = defaultEarlyErrorMaxAge)
+			: _logger(logger), _backend(backend), _exceptions(exceptionDepth, earlyErrorMaxAge) {}
 		~SimState() = default;
 
-		inline HANDLE handle() const noexcept { return _handle; }
+		inline SimBackend& backend() const noexcept { return _backend; }
+		inline std::weak_ptr<const SimState*> token() const noexcept { return _token; }
+
+		/**
+		 * <summary>Queue a call for the dispatcher thread. The error handler is called if the simulator reports an
+		 * exception for it, or if it could not be sent at all, which includes still being queued on disconnect.</summary>
+		 */
+		template <typename F>
+		void submit(F&& send, ExceptionCallback onError) {
+			if (_outbound.push(std::make_unique<OutboundCallOf<std::decay_t<F>>>(std::forward<F>(send), std::move(onError)))) {
+				_backend.wakeUp();
+			}
+		}
+		void flushOutbound();
+		void failOutbound();
+		void failRequests();
 
 		void addExceptionHandler(DWORD sendID, ExceptionCallback handler);
 		void onExcept(DWORD sendID, unsigned exceptionId, unsigned parmIndex);
+		inline ExceptionStats exceptionStats() const noexcept { return _exceptions.stats(); }
+
+		inline SingleFlight<std::string>& stringStateFlights() noexcept { return _stringStateFlights; }
+		inline SingleFlight<bool>& boolStateFlights() noexcept { return _boolStateFlights; }
+		inline SystemStateCache& systemStateCache() noexcept { return _systemStateCache; }
+		inline RequestStats requestStats() const noexcept {
+			return {
+				_stringStateFlights.issued() + _boolStateFlights.issued(),
+				_stringStateFlights.coalesced() + _boolStateFlights.coalesced(),
+				_systemStateCache.hits()
+			};
+		}
 
-		inline RecvObserver registerRequestResultObserver(DWORD reqId) {
-			std::lock_guard<std::mutex> lock(_observerMutex);
+		// System events use client event IDs from here on, which keeps them apart from mapped client events.
+		static constexpr DWORD systemEventIdBase{ 0xff000000 };
 
-			auto result = _messageObservers[reqId];
-			_logger.debug("Register result handler for RequestID {} (now {} registration(s)).", reqId, _messageObservers.size());
-			return result;
+		inline void subscribeToSystemEvent(SystemEvent event, ExceptionCallback onError) {
+			const DWORD eventId{ systemEventIdBase + static_cast<DWORD>(event) };
+			submit(
+				[eventId, event](SimBackend& backend) { return backend.subscribeToSystemEvent(eventId, SystemEventNames[static_cast<size_t>(event)].c_str()); },
+				std::move(onError));
 		}
-		inline void deRegisterRequestResultObserver(DWORD reqId) {
-			std::lock_guard<std::mutex> lock(_observerMutex);
-
-			auto it = _messageObservers.find(reqId);
-			if (it != _messageObservers.end()) {
-				_messageObservers.erase(it);
-				_logger.debug("Deregistered result handler for RequestID {} (now {} registration(s)).", reqId, _messageObservers.size());
+		void enableSystemStateCache();
+		void disableSystemStateCache();
+		void dispatchEvent(DWORD eventId, DWORD groupId, DWORD data, const char* fileName);
+
+		/**
+		 * <summary>Queue the calls that map a set of client events, add them to their notification groups, and set the
+		 * priorities of those groups. The set must outlive the connection.</summary>
+		 */
+		void registerClientEvents(const RegisteredEventSet& set);
+
+		inline DWORD registerRequestResultObserver(RecvObserver obs) {
+			DWORD reqId{ _requests.add(std::move(obs)) };
+			_logger.debug("Register result handler for RequestID {} (now {} registration(s)).", reqId, _requests.size());
+			return reqId;
+		}
+		inline bool deRegisterRequestResultObserver(DWORD reqId) {
+			if (!_requests.retire(reqId)) {
+				return false;
 			}
+			_logger.debug("Deregistered result handler for RequestID {} (now {} registration(s)).", reqId, _requests.size());
+			return true;
 		}
+		inline void reclaimRequests() { _requests.reclaim(); }
 
 		static void cppSimConnect_handleMessage(SIMCONNECT_RECV* msgPtr, DWORD msgLen, void* context) noexcept;
 
-		inline RecvObserver simRequestSimState(DWORD reqId, const std::string& stateName) {
-			RecvObserver obs = registerRequestResultObserver(reqId);
-			addExceptionHandler(
-				sendIdOf([handle = handle(), reqId, stateName]() { return SimConnect_RequestSystemState(handle, reqId, stateName.c_str()); }),
-				[&obs](unsigned exceptionId, std::string const& msg, unsigned parmIndex) { obs.onError(std::make_exception_ptr(SimException(exceptionId, msg, parmIndex))); });
+		/**
+		 * <summary>The handler for messages with the given ID. It is specialized per message type in SimDispatcher.cpp,
+		 * and only called for messages of at least the size registered in the dispatch table there.</summary>
+		 */
+		template <DWORD Id>
+		static void handleMessage(SimConnect& sim, SIMCONNECT_RECV* msgPtr);
+
+		MessageStats messageStats() const noexcept;
+
+		inline void enableTiming() { _timing = std::make_unique<DispatchTiming>(); }
+		inline TimingStats timingStats() const { return _timing ? _timing->stats() : TimingStats{}; }
+
+		inline void simRequestSimState(DWORD reqId, const std::string& stateName, RecvObserver obs) {
+			submit(
+				[this, reqId, stateName](SimBackend& backend) {
+					if (_timing) { _timing->sent(reqId, RequestKind::SystemState); }
+					return backend.requestSystemState(reqId, stateName.c_str());
+				},
+				[obs](unsigned exceptionId, std::string const& msg, unsigned parmIndex) { obs.onError(std::make_exception_ptr(SimException(exceptionId, msg, parmIndex))); });
+		}
+
+		/**
+		 * <summary>The DefineID of a data definition, which is sent to the simulator the first time it is asked for.</summary>
+		 */
+		DWORD dataDefinition(const DataLayout& layout);
+
+		inline void simRequestDataOnSimObject(DWORD reqId, DWORD defineId, DWORD objectId, SIMCONNECT_PERIOD period, DWORD flags, RecvObserver obs) {
+			submit(
+				[this, reqId, defineId, objectId, period, flags](SimBackend& backend) {
+					if (_timing && (period != SIMCONNECT_PERIOD_NEVER)) {
+						_timing->sent(reqId, (period == SIMCONNECT_PERIOD_ONCE) ? RequestKind::Data : RequestKind::Subscription);
+					}
+					return backend.requestDataOnSimObject(reqId, defineId, objectId, period, flags, 0, 0, 0);
+				},
+				[obs](unsigned exceptionId, std::string const& msg, unsigned parmIndex) { obs.onError(std::make_exception_ptr(SimException(exceptionId, msg, parmIndex))); });
+		}
 
-			return obs;
+		/**
+		 * <summary>The data carried by a SIMOBJECT_DATA message, or nullptr if it holds less than the expected size.</summary>
+		 */
+		static inline const std::byte* simObjectData(const SIMCONNECT_RECV* msg, size_t expectedSize) noexcept {
+			const auto data{ simObjectDataView(*static_cast<const SIMCONNECT_RECV_SIMOBJECT_DATA*>(msg)) };
+			return (data.size() < expectedSize) ? nullptr : data.data();
 		}
 
 		void dispatchRequestData(DWORD reqId, SIMCONNECT_RECV* msg) {
-			RecvObserver obs;
-			{
-				std::lock_guard<std::mutex> lock(_observerMutex);
-
-				auto obsIt = _messageObservers.find(reqId);
-				if (obsIt != _messageObservers.end()) {
-					obs = obsIt->second;
-				}
-				else {
-					_logger.warn("Received data for unknown request id {}.", reqId);
-				}
+			RecvObserver* obs = _requests.find(reqId);
+			if ((obs != nullptr) && _timing) {
+				_timing->replied(reqId);
+				const auto start{ DispatchTiming::Clock::now() };
+				const size_t subscribers{ obs->subscribers() };
+				obs->onNext(msg);
+				_timing->delivered(start, subscribers);
+			}
+			else if (obs != nullptr) {
+				obs->onNext(msg);
+			}
+			else {
+				_logger.warn("Received data for unknown request id {}.", reqId);
 			}
-			obs.onNext(msg);
 		}
 
 		friend class SimConnect;
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/reactive/Callbacks.h"
+
+#include "Benchmark.h"
+
+
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::CallbackResult;
+
+
+// CleanableCallbackList as it was before snapshots: every invocation copies the list under a lock.
+template <typename... Tparm>
+class LegacyCleanableCallbackList {
+public:
+    using Callback = std::function<CallbackResult(Tparm...)>;
+    using CallbackVector = std::vector<std::pair<unsigned, Callback>>;
+
+private:
+    CallbackVector _callbacks;
+    std::atomic_uint _nextId{ 0 };
+    std::mutex _mutex;
+
+public:
+    inline unsigned add(Callback cb) { auto id = _nextId++; _callbacks.emplace_back(id, cb); return id; }
+    CallbackResult operator()(Tparm... parms) {
+        CallbackResult result{ CallbackResult::Ok };
+
+        CallbackVector callbacks(_callbacks.size());
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            callbacks = _callbacks;
+        }
+        std::set<unsigned> idsToGo;
+        for (auto pair : callbacks)
+        {
+            switch (pair.second(parms...)) {
+            case CallbackResult::Done:
+            case CallbackResult::AbortDone:
+                idsToGo.emplace(pair.first);
+                result = CallbackResult::Done;
+                break;
+
+            default:
+                break;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto end = std::remove_if(_callbacks.begin(), _callbacks.end(), [&idsToGo](const auto& it) { return idsToGo.contains(it.first); });
+            _callbacks.erase(end, _callbacks.end());
+        }
+        return result;
+    }
+};
+
+
+// Keep the total number of calls bounded, so the larger subscriber counts don't dominate the run.
+static std::uint64_t invocationsFor(unsigned subscribers) {
+    return std::min<std::uint64_t>(200'000, 20'000'000 / subscribers);
+}
+
+template <typename List>
+static void invoke(State& state, unsigned subscribers) {
+    const std::uint64_t invocations{ invocationsFor(subscribers) };
+
+    List callbacks;
+    std::uint64_t total{ 0 };
+    std::string captured{ "A capture too big for std::function's small buffer" };
+    for (unsigned i = 0; i < subscribers; i++) {
+        callbacks.add([&total, captured, i](int value) {
+            total += value + i + captured.size();
+            return CallbackResult::Ok;
+        });
+    }
+
+    state.measure(invocations * subscribers, [&]() {
+        for (std::uint64_t i = 0; i < invocations; i++) {
+            callbacks(1);
+        }
+    });
+    state.counter("ns/invocation", static_cast<double>(state.elapsed().count()) / invocations);
+}
+
+// The plain list, as used by the observers, has no results to check and no removal.
+static void invokePlain(State& state, unsigned subscribers) {
+    const std::uint64_t invocations{ invocationsFor(subscribers) };
+
+    CppSimConnect::CallbackList<int> callbacks;
+    std::uint64_t total{ 0 };
+    std::string captured{ "A capture too big for std::function's small buffer" };
+    for (unsigned i = 0; i < subscribers; i++) {
+        callbacks.add([&total, captured, i](int value) { total += value + i + captured.size(); });
+    }
+
+    state.measure(invocations * subscribers, [&]() {
+        for (std::uint64_t i = 0; i < invocations; i++) {
+            callbacks(1);
+        }
+    });
+    state.counter("ns/invocation", static_cast<double>(state.elapsed().count()) / invocations);
+}
+
+// Invoking while another thread keeps subscribing and unsubscribing.
+static void invokeWithChurn(State& state, unsigned subscribers) {
+    const std::uint64_t invocations{ invocationsFor(subscribers) };
+
+    CppSimConnect::CleanableCallbackList<int> callbacks;
+    std::uint64_t total{ 0 };
+    for (unsigned i = 0; i < subscribers; i++) {
+        callbacks.add([&total](int value) { total += value; return CallbackResult::Ok; });
+    }
+
+    std::atomic_bool done{ false };
+    std::jthread churn([&]() {
+        while (!done) {
+            callbacks -= callbacks.add([](int) { return CallbackResult::Ok; });
+            std::this_thread::yield();
+        }
+    });
+    state.measure(invocations * subscribers, [&]() {
+        for (std::uint64_t i = 0; i < invocations; i++) {
+            callbacks(1);
+        }
+    });
+    done = true;
+    state.counter("ns/invocation", static_cast<double>(state.elapsed().count()) / invocations);
+}
+
+
+// The read side on its own, with every thread reading at once. Reading a snapshot only announces an epoch in the
+// reading thread's own record, so it should stay flat as threads are added; copying a plain std::shared_ptr makes
+// every thread update the same reference count.
+template <typename Read>
+static void readConcurrently(State& state, unsigned threads, Read read) {
+    constexpr std::uint64_t reads{ 1'000'000 };
+
+    std::atomic<std::uint64_t> total{ 0 };
+    state.measure(reads * threads, [&]() {
+        std::vector<std::jthread> readers;
+        for (unsigned t = 0; t < threads; t++) {
+            readers.emplace_back([&total, &read]() {
+                std::uint64_t sum{ 0 };
+                for (std::uint64_t i = 0; i < reads; i++) {
+                    sum += read();
+                }
+                total += sum;
+            });
+        }
+    });
+}
+
+static void readSnapshots(State& state, unsigned threads) {
+    CppSimConnect::CallbackSnapshots<std::function<void()>> snapshots;
+    snapshots.add([]() {});
+    readConcurrently(state, threads, [&snapshots]() {
+        CppSimConnect::EpochDomain::ReadGuard guard;
+        return snapshots.snapshot()->size();
+    });
+    state.counter("lockFree", std::atomic<const void*>::is_always_lock_free ? 1.0 : 0.0);
+}
+
+static void readSharedPtr(State& state, unsigned threads) {
+    const auto shared = std::make_shared<const std::vector<int>>(1);
+    readConcurrently(state, threads, [&shared]() { return std::shared_ptr<const std::vector<int>>(shared)->size(); });
+}
+
+
+static bool registered = []() {
+    for (unsigned subscribers : { 1, 10, 100, 1000 }) {
+        Registration("callbacks/plain/" + std::to_string(subscribers), [subscribers](State& state) { invokePlain(state, subscribers); });
+        Registration("callbacks/legacyCleanable/" + std::to_string(subscribers), [subscribers](State& state) { invoke<LegacyCleanableCallbackList<int>>(state, subscribers); });
+        Registration("callbacks/cleanable/" + std::to_string(subscribers), [subscribers](State& state) { invoke<CppSimConnect::CleanableCallbackList<int>>(state, subscribers); });
+        Registration("callbacks/cleanableWithChurn/" + std::to_string(subscribers), [subscribers](State& state) { invokeWithChurn(state, subscribers); });
+    }
+    for (unsigned threads : { 1, 2, 4, 8 }) {
+        Registration("callbacks/snapshotRead/" + std::to_string(threads), [threads](State& state) { readSnapshots(state, threads); });
+        Registration("callbacks/sharedPtrRead/" + std::to_string(threads), [threads](State& state) { readSharedPtr(state, threads); });
+    }
+    return true;
+}();
\ No newline at end of file
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "../CppSimConnect/CppSimConnect.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+#include "../CppSimConnect/sim/SimState.h"
+
+#include "Benchmark.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::DataDefinition;
+using CppSimConnect::DataType;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimState;
+using CppSimConnect::dataLayout;
+using CppSimConnect::field;
+using CppSimConnect::simObjectDataHeaderSize;
+
+
+#pragma pack(push, 1)
+struct BenchAircraft {
+    double latitude;
+    double longitude;
+    double altitude;
+    double heading;
+    double airspeed;
+    std::int32_t onGround;
+    char title[32];
+};
+#pragma pack(pop)
+
+template <>
+struct CppSimConnect::DataDefinition<BenchAircraft> {
+    static constexpr auto fields{ std::make_tuple(
+        field(&BenchAircraft::latitude, "PLANE LATITUDE", "degrees"),
+        field(&BenchAircraft::longitude, "PLANE LONGITUDE", "degrees"),
+        field(&BenchAircraft::altitude, "PLANE ALTITUDE", "feet"),
+        field(&BenchAircraft::heading, "PLANE HEADING DEGREES TRUE", "degrees"),
+        field(&BenchAircraft::airspeed, "AIRSPEED INDICATED", "knots"),
+        field(&BenchAircraft::onGround, "SIM ON GROUND", "bool"),
+        field(&BenchAircraft::title, "TITLE")) };
+};
+
+
+// A SIMOBJECT_DATA message carrying one BenchAircraft, laid out as the simulator sends it.
+static std::vector<std::byte> aircraftMessage(DWORD reqId) {
+    BenchAircraft aircraft{ 52.3, 4.76, 3500.0, 270.0, 120.0, 0, "Benchmark Aircraft" };
+
+    std::vector<std::byte> buffer(simObjectDataHeaderSize + sizeof(aircraft));
+    SIMCONNECT_RECV_SIMOBJECT_DATA header{};
+    header.dwSize = static_cast<DWORD>(buffer.size());
+    header.dwID = SIMCONNECT_RECV_ID_SIMOBJECT_DATA;
+    header.dwRequestID = reqId;
+    header.dwDefineCount = static_cast<DWORD>(dataLayout<BenchAircraft>().data().size());
+    std::memcpy(buffer.data(), &header, simObjectDataHeaderSize);
+    std::memcpy(buffer.data() + simObjectDataHeaderSize, &aircraft, sizeof(aircraft));
+    return buffer;
+}
+
+// The typed view: the struct is read where the message lies.
+static Registration decodeView("data/decodeView", [](State& state) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchData", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    SimState simState(logger, fake);
+
+    double altitude{ 0.0 };
+    CppSimConnect::RecvObserver obs;
+    obs.subscribe([&altitude](SIMCONNECT_RECV* msg) {
+        if (auto data = SimState::simObjectData(msg, sizeof(BenchAircraft))) {
+            altitude += reinterpret_cast<const BenchAircraft*>(data)->altitude;
+        }
+    });
+    const DWORD reqId{ simState.registerRequestResultObserver(obs) };
+    auto buffer{ aircraftMessage(reqId) };
+    auto msg{ reinterpret_cast<SIMCONNECT_RECV*>(buffer.data()) };
+
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            simState.dispatchRequestData(reqId, msg);
+        }
+    });
+    state.counter("altitude", altitude / messages);
+});
+
+// Decoding field by field from the layout, into values that own their data, as a generic client would.
+static Registration decodeFields("data/decodeFields", [](State& state) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchData", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    SimState simState(logger, fake);
+
+    const auto& layout{ dataLayout<BenchAircraft>() };
+    double altitude{ 0.0 };
+    CppSimConnect::RecvObserver obs;
+    obs.subscribe([&altitude, &layout](SIMCONNECT_RECV* msg) {
+        auto data = SimState::simObjectData(msg, layout.size());
+        if (data == nullptr) {
+            return;
+        }
+        std::vector<std::variant<std::int64_t, double, std::string>> values;
+        for (const auto& datum : layout.data()) {
+            const auto pos{ data + datum.offset };
+            switch (datum.type) {
+            case DataType::Int32: { std::int32_t v; std::memcpy(&v, pos, sizeof(v)); values.emplace_back(std::int64_t{ v }); } break;
+            case DataType::Int64: { std::int64_t v; std::memcpy(&v, pos, sizeof(v)); values.emplace_back(v); } break;
+            case DataType::Float32: { float v; std::memcpy(&v, pos, sizeof(v)); values.emplace_back(double{ v }); } break;
+            case DataType::Float64: { double v; std::memcpy(&v, pos, sizeof(v)); values.emplace_back(v); } break;
+            default: values.emplace_back(std::string(reinterpret_cast<const char*>(pos), strnlen(reinterpret_cast<const char*>(pos), datum.size))); break;
+            }
+        }
+        altitude += std::get<double>(values[2]);
+    });
+    const DWORD reqId{ simState.registerRequestResultObserver(obs) };
+    auto buffer{ aircraftMessage(reqId) };
+    auto msg{ reinterpret_cast<SIMCONNECT_RECV*>(buffer.data()) };
+
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            simState.dispatchRequestData(reqId, msg);
+        }
+    });
+    state.counter("altitude", altitude / messages);
+});
+
+// A subscription where one of the seven values changes: the whole struct each time, or only the changed value, tagged.
+static void streamUpdates(State& state, bool tagged) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchData", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    SimState simState(logger, fake);
+
+    const auto& layout{ dataLayout<BenchAircraft>() };
+    BenchAircraft current{};
+    std::uint64_t changes{ 0 };
+    CppSimConnect::RecvObserver obs;
+    obs.subscribe([&](SIMCONNECT_RECV* msg) {
+        if (tagged) {
+            std::uint64_t fields{ 0 };
+            layout.applyTagged(reinterpret_cast<std::byte*>(&current), SimState::simObjectData(msg, 0), msg->dwSize - simObjectDataHeaderSize,
+                               static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA*>(msg)->dwDefineCount, fields);
+            changes += std::popcount(fields);
+        }
+        else if (auto data = SimState::simObjectData(msg, sizeof(BenchAircraft))) {
+            std::memcpy(&current, data, sizeof(BenchAircraft));
+            changes++;
+        }
+    });
+    const DWORD reqId{ simState.registerRequestResultObserver(obs) };
+
+    std::vector<std::byte> buffer;
+    if (tagged) {
+        const DWORD datumId{ 2 };
+        const double altitude{ 3500.0 };
+        buffer.resize(simObjectDataHeaderSize + sizeof(datumId) + sizeof(altitude));
+        SIMCONNECT_RECV_SIMOBJECT_DATA header{};
+        header.dwSize = static_cast<DWORD>(buffer.size());
+        header.dwID = SIMCONNECT_RECV_ID_SIMOBJECT_DATA;
+        header.dwRequestID = reqId;
+        header.dwFlags = SIMCONNECT_DATA_REQUEST_FLAG_CHANGED | SIMCONNECT_DATA_REQUEST_FLAG_TAGGED;
+        header.dwDefineCount = 1;
+        std::memcpy(buffer.data(), &header, simObjectDataHeaderSize);
+        std::memcpy(buffer.data() + simObjectDataHeaderSize, &datumId, sizeof(datumId));
+        std::memcpy(buffer.data() + simObjectDataHeaderSize + sizeof(datumId), &altitude, sizeof(altitude));
+    }
+    else {
+        buffer = aircraftMessage(reqId);
+    }
+    auto msg{ reinterpret_cast<SIMCONNECT_RECV*>(buffer.data()) };
+
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            simState.dispatchRequestData(reqId, msg);
+        }
+    });
+    state.counter("bytes/msg", static_cast<double>(buffer.size()));
+    state.counter("changes", static_cast<double>(changes));
+}
+
+static Registration streamAll("data/streamAll", [](State& state) { streamUpdates(state, false); });
+static Registration streamTagged("data/streamTagged", [](State& state) { streamUpdates(state, true); });
+
+// The fake backend sends 100k messages per second, which are drained and decoded as the dispatcher thread does.
+static Registration generated100k("data/generated100k", [](State& state) {
+    constexpr unsigned rate{ 100'000 };
+
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchData", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    SimState simState(logger, fake);
+    (void) fake.open("BenchData.generated100k");
+
+    std::uint64_t decoded{ 0 };
+    double altitude{ 0.0 };
+    CppSimConnect::RecvObserver obs;
+    obs.subscribe([&decoded, &altitude](SIMCONNECT_RECV* msg) {
+        if (auto data = SimState::simObjectData(msg, sizeof(BenchAircraft))) {
+            altitude += reinterpret_cast<const BenchAircraft*>(data)->altitude;
+            decoded++;
+        }
+    });
+    const DWORD reqId{ simState.registerRequestResultObserver(obs) };
+    const auto buffer{ aircraftMessage(reqId) };
+    const std::span<const std::byte> data{ buffer.data() + simObjectDataHeaderSize, sizeof(BenchAircraft) };
+
+    state.measure(0, [&]() {
+        fake.generate(rate, [reqId, data](FakeSimulator& fakeSim, std::uint64_t) { fakeSim.postSimObjectData(reqId, 1, CppSimConnect::UserObjectId, data); });
+        const auto end{ std::chrono::steady_clock::now() + 1s };
+        while (std::chrono::steady_clock::now() < end) {
+            fake.waitForDispatch(10ms);
+            SIMCONNECT_RECV* msg;
+            DWORD len;
+            while (SUCCEEDED(fake.getNextDispatch(&msg, &len))) {
+                if (msg->dwID == SIMCONNECT_RECV_ID_SIMOBJECT_DATA) {
+                    simState.dispatchRequestData(static_cast<SIMCONNECT_RECV_SIMOBJECT_DATA*>(msg)->dwRequestID, msg);
+                }
+            }
+        }
+        fake.stopGenerating();
+    });
+    state.counter("decoded/s", static_cast<double>(decoded) * 1e9 / static_cast<double>(state.elapsed().count()));
+    state.counter("posted", static_cast<double>(fake.messagesPosted()));
+    (void) fake.close();
+});
\ No newline at end of file
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/CppSimConnect.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+#include "../CppSimConnect/sim/RecvViews.h"
+#include "../CppSimConnect/sim/SimState.h"
+
+#include "Benchmark.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimConnect;
+
+
+static SimConnect& connectTo(const std::string& name, std::shared_ptr<FakeSimulator> fake, bool cacheSystemStates = true, bool timingStats = false) {
+    SimConnect::Builder builder;
+    builder
+        .withName(name)
+        .withBackend(std::move(fake))
+        .withAutoConnect()
+        .startRunning();
+    if (!cacheSystemStates) {
+        builder.withoutSystemStateCache();
+    }
+    if (timingStats) {
+        builder.withTimingStats();
+    }
+    auto& sim = builder.build();
+
+    while (!sim.connected()) {
+        std::this_thread::sleep_for(1ms);
+    }
+    return sim;
+}
+
+
+static SIMCONNECT_RECV_SYSTEM_STATE systemStateMessage() {
+    SIMCONNECT_RECV_SYSTEM_STATE msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwID = SIMCONNECT_RECV_ID_SYSTEM_STATE;
+    return msg;
+}
+
+static void dispatchRequestData(State& state, unsigned requests) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchDispatch", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    CppSimConnect::SimState simState(logger, fake);
+
+    std::uint64_t received{ 0 };
+    std::vector<DWORD> reqIds;
+    reqIds.reserve(requests);
+    for (unsigned i = 0; i < requests; i++) {
+        CppSimConnect::RecvObserver obs;
+        obs.subscribe([&received](SIMCONNECT_RECV*) { received++; });
+        reqIds.push_back(simState.registerRequestResultObserver(obs));
+    }
+    auto msg{ systemStateMessage() };
+
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            simState.dispatchRequestData(reqIds[i % requests], &msg);
+        }
+    });
+    state.counter("received", static_cast<double>(received));
+}
+
+// What SimState did before the RequestTable: a std::map behind a mutex, copying the observer.
+static void dispatchRequestDataMap(State& state, unsigned requests) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    std::map<DWORD, CppSimConnect::RecvObserver> observers;
+    std::mutex observerMutex;
+
+    std::uint64_t received{ 0 };
+    for (DWORD reqId = 0; reqId < requests; reqId++) {
+        observers[reqId].subscribe([&received](SIMCONNECT_RECV*) { received++; });
+    }
+    auto msg{ systemStateMessage() };
+
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            CppSimConnect::RecvObserver obs;
+            {
+                std::lock_guard<std::mutex> lock(observerMutex);
+                auto it = observers.find(static_cast<DWORD>(i % requests));
+                if (it != observers.end()) {
+                    obs = it->second;
+                }
+            }
+            obs.onNext(&msg);
+        }
+    });
+    state.counter("received", static_cast<double>(received));
+}
+
+// Requests come and go while the given number stay in flight.
+static void registerRetire(State& state, unsigned requests) {
+    constexpr std::uint64_t operations{ 1'000'000 };
+
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchDispatch", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    CppSimConnect::SimState simState(logger, fake);
+
+    CppSimConnect::RecvObserver obs;
+    std::vector<DWORD> reqIds;
+    for (unsigned i = 0; i < requests; i++) {
+        reqIds.push_back(simState.registerRequestResultObserver(obs));
+    }
+
+    state.measure(operations, [&]() {
+        for (std::uint64_t i = 0; i < operations; i++) {
+            auto& reqId{ reqIds[i % requests] };
+            simState.deRegisterRequestResultObserver(reqId);
+            reqId = simState.registerRequestResultObserver(obs);
+            if ((i % 64) == 0) {
+                simState.reclaimRequests();
+            }
+        }
+    });
+}
+
+static bool registered = []() {
+    for (unsigned requests : { 1'000, 10'000, 100'000 }) {
+        Registration("dispatch/dispatchRequestData/" + std::to_string(requests), [requests](State& state) { dispatchRequestData(state, requests); });
+        Registration("dispatch/dispatchRequestDataMap/" + std::to_string(requests), [requests](State& state) { dispatchRequestDataMap(state, requests); });
+        Registration("dispatch/registerRetire/" + std::to_string(requests), [requests](State& state) { registerRetire(state, requests); });
+    }
+    return true;
+}();
+
+
+// Reading a string reply as a view on the message, or copying it out as the owning requests do.
+static void decodeSystemState(State& state, bool materialize) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchDispatch", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    CppSimConnect::SimState simState(logger, fake);
+
+    size_t length{ 0 };
+    CppSimConnect::RecvObserver obs;
+    obs.subscribe([&length, materialize](SIMCONNECT_RECV* msg) {
+        const auto view{ CppSimConnect::systemStateView(*static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msg)) };
+        length += materialize ? view.materialize().size() : view.string.size();
+    });
+    const DWORD reqId{ simState.registerRequestResultObserver(obs) };
+
+    auto msg{ systemStateMessage() };
+    std::strcpy(msg.szString, "SimObjects\\Airplanes\\Benchmark Aircraft With A Long Name\\aircraft.cfg");
+
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            simState.dispatchRequestData(reqId, &msg);
+        }
+    });
+    state.counter("length", static_cast<double>(length / messages));
+}
+
+static Registration systemStateView("dispatch/systemStateView", [](State& state) { decodeSystemState(state, false); });
+static Registration systemStateMaterialize("dispatch/systemStateMaterialize", [](State& state) { decodeSystemState(state, true); });
+
+
+static Registration drainGenerated("dispatch/drainGenerated", [](State& state) {
+    auto fake = std::make_shared<FakeSimulator>();
+    auto& sim = connectTo("BenchDispatch.drainGenerated", fake);
+
+    SIMCONNECT_RECV_SYSTEM_STATE msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwID = SIMCONNECT_RECV_ID_SYSTEM_STATE;
+    msg.dwRequestID = 0xffffffff;
+
+    const auto before{ fake->messagesPosted() };
+    state.measure(0, [&]() {
+        fake->generate(0, [&msg](FakeSimulator& fakeSim, std::uint64_t) { fakeSim.post(msg); });
+        std::this_thread::sleep_for(1s);
+        fake->stopGenerating();
+    });
+    const auto generated{ fake->messagesPosted() - before };
+    state.counter("messages/s", static_cast<double>(generated) * 1e9 / static_cast<double>(state.elapsed().count()));
+
+    sim.stop();
+});
+
+
+// Without the cache, so every request goes out to the simulator and back.
+static void systemStateRoundTrips(State& state, bool timed) {
+    constexpr unsigned requests{ 10'000 };
+
+    auto fake = std::make_shared<FakeSimulator>();
+    fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Benchmark\\aircraft.cfg");
+    auto& sim = connectTo(timed ? "BenchDispatch.systemStateRoundTripsTimed" : "BenchDispatch.systemStateRoundTrips", fake, false, timed);
+
+    std::vector<CppSimConnect::Reactive::MessageResult<std::string>> results;
+    results.reserve(requests);
+
+    // Concurrent requests for the same state share a round trip, so the timed run waits for each in turn.
+    state.measure(requests, [&]() {
+        for (unsigned i = 0; i < requests; i++) {
+            results.push_back(sim.requestAircraftLoaded());
+            if (timed) {
+                results.back().get();
+            }
+        }
+        for (auto& result : results) {
+            result.get();
+        }
+    });
+    if (timed) {
+        const auto stats{ sim.timingStats() };
+        const auto& roundTrip{ stats.roundTrip[static_cast<size_t>(CppSimConnect::RequestKind::SystemState)] };
+        state.counter("roundTrip p50 ns", static_cast<double>(roundTrip.percentile(50.0)));
+        state.counter("roundTrip p99 ns", static_cast<double>(roundTrip.percentile(99.0)));
+        state.counter("handling p50 ns", static_cast<double>(stats.handling.at(SIMCONNECT_RECV_ID_SYSTEM_STATE).percentile(50.0)));
+        state.counter("subscriberCallback p50 ns", static_cast<double>(stats.subscriberCallback.percentile(50.0)));
+    }
+
+    sim.stop();
+}
+
+static Registration untimedRoundTrips("dispatch/systemStateRoundTrips", [](State& state) { systemStateRoundTrips(state, false); });
+static Registration timedRoundTrips("dispatch/systemStateRoundTripsTimed", [](State& state) { systemStateRoundTrips(state, true); });
\ No newline at end of file
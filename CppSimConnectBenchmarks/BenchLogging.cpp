@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "../CppSimConnect/CppSimConnect.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+
+#include "Benchmark.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::LogLevel;
+using CppSimConnect::SimConnect;
+
+
+enum class LogMode {
+    Sync,           // Format and write on the dispatcher thread
+    Async,          // Format on the dispatcher thread, write on the logging thread
+    Deferred,       // Format and write on the logging thread
+    Binary          // Write unformatted to a binary log on the logging thread
+};
+
+// The dispatcher logs every system state message at Debug, so with that threshold each message costs a log line.
+static void dispatchWithDebugLogging(State& state, const std::string& name, LogMode mode) {
+    constexpr std::uint64_t messages{ 100'000 };
+
+    auto fake = std::make_shared<FakeSimulator>();
+    SimConnect::Builder builder;
+    builder
+        .withName(name)
+        .withBackend(fake)
+        .withoutSystemStateCache()
+        .withLogThreshold(LogLevel::Debug)
+        .withAutoConnect()
+        .startRunning();
+    if (mode == LogMode::Binary) {
+        builder.withBinaryLog(std::filesystem::temp_directory_path() / (name + ".bin"));
+    }
+    else {
+        // The client outlives this function, so the sink shares ownership of the file.
+        auto out = std::make_shared<std::ofstream>(std::filesystem::temp_directory_path() / (name + ".log"), std::ios::trunc);
+        builder.withLogger([out](LogLevel, std::string msg) { *out << msg << '\n'; });
+    }
+    if (mode == LogMode::Async) {
+        builder.withAsyncLogging();
+    }
+    else if (mode == LogMode::Deferred) {
+        builder.withDeferredFormatting();
+    }
+    auto& sim = builder.build();
+    while (!sim.connected()) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    SIMCONNECT_RECV_SYSTEM_STATE msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwID = SIMCONNECT_RECV_ID_SYSTEM_STATE;
+    msg.dwRequestID = 0xffffffff;
+
+    const auto before{ fake->messagesDelivered() };
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            fake->post(msg);
+        }
+        while ((fake->messagesDelivered() - before) < messages) {
+            std::this_thread::yield();
+        }
+    });
+    state.counter("dropped", static_cast<double>(sim.logStats().dropped));
+
+    sim.stop();
+    sim.flushLog();
+}
+
+static Registration syncLogging("logging/dispatchDebug/sync", [](State& state) {
+    dispatchWithDebugLogging(state, "BenchLogging.sync", LogMode::Sync);
+});
+
+static Registration asyncLogging("logging/dispatchDebug/async", [](State& state) {
+    dispatchWithDebugLogging(state, "BenchLogging.async", LogMode::Async);
+});
+
+static Registration deferredLogging("logging/dispatchDebug/deferred", [](State& state) {
+    dispatchWithDebugLogging(state, "BenchLogging.deferred", LogMode::Deferred);
+});
+
+static Registration binaryLogging("logging/dispatchDebug/binary", [](State& state) {
+    dispatchWithDebugLogging(state, "BenchLogging.binary", LogMode::Binary);
+});
+
+
+// What a log call costs the caller, with a sink that does nothing.
+static void callSite(State& state, bool deferred) {
+    constexpr std::uint64_t calls{ 1'000'000 };
+
+    CppSimConnect::LogSink sink{ [](LogLevel, const std::string&) {} };
+    CppSimConnect::LogRecordSink recordSink{ [](const CppSimConnect::LogRecord&) {} };
+    CppSimConnect::Logger logger("BenchLogging", sink, LogLevel::Debug, deferred ? &recordSink : nullptr);
+    const std::string stateName{ "AircraftLoaded" };
+
+    state.measure(calls, [&]() {
+        for (std::uint64_t i = 0; i < calls; i++) {
+            logger.debug("Requesting string value for '{}' with RequestID {}", stateName, i);
+        }
+    });
+}
+
+static Registration eagerCallSite("logging/callSite/eager", [](State& state) { callSite(state, false); });
+static Registration deferredCallSite("logging/callSite/deferred", [](State& state) { callSite(state, true); });
+
+// One call at every level per operation, so each threshold shows the mix of filtered and formatted calls.
+static void underThreshold(State& state, LogLevel threshold) {
+    constexpr std::uint64_t rounds{ 200'000 };
+
+    std::uint64_t emitted{ 0 };
+    CppSimConnect::LogSink sink{ [&emitted](LogLevel, const std::string&) { emitted++; } };
+    CppSimConnect::Logger logger("BenchLogging", sink, threshold);
+    const std::string stateName{ "AircraftLoaded" };
+
+    state.measure(rounds, [&]() {
+        for (std::uint64_t i = 0; i < rounds; i++) {
+            logger.trace("Received value for '{}' with RequestID {}", stateName, i);
+            logger.debug("Received value for '{}' with RequestID {}", stateName, i);
+            logger.info("Received value for '{}' with RequestID {}", stateName, i);
+            logger.warn("Received value for '{}' with RequestID {}", stateName, i);
+            logger.error("Received value for '{}' with RequestID {}", stateName, i);
+            logger.fatal("Received value for '{}' with RequestID {}", stateName, i);
+        }
+    });
+    state.counter("lines/round", static_cast<double>(emitted) / rounds);
+}
+
+static bool thresholdsRegistered = []() {
+    const std::pair<const char*, LogLevel> thresholds[]{
+        { "trace", LogLevel::Trace }, { "debug", LogLevel::Debug }, { "info", LogLevel::Info },
+        { "warn", LogLevel::Warn }, { "error", LogLevel::Error }, { "fatal", LogLevel::Fatal }
+    };
+    for (const auto& [name, threshold] : thresholds) {
+        Registration(std::string("logging/threshold/") + name, [threshold](State& state) { underThreshold(state, threshold); });
+    }
+    return true;
+}();
\ No newline at end of file
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "../CppSimConnect/CppSimConnect.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+
+#include "Benchmark.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::Benchmarks::Clock;
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimConnect;
+
+
+// Sequential round trips with a random pause in between, so requests land at a random point of the poll period.
+static void roundTrips(State& state, SimConnect::Builder& builder) {
+    constexpr unsigned requests{ 200 };
+
+    auto fake = std::make_shared<FakeSimulator>();
+    fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Benchmark\\aircraft.cfg");
+    auto& sim = builder
+        .withBackend(fake)
+        .withAutoConnect()
+        .startRunning()
+        .build();
+    while (!sim.connected()) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    std::mt19937 rng{ 42 };
+    std::uniform_int_distribution<int> pause{ 0, 5000 };
+
+    state.reserveSamples(requests);
+    for (unsigned i = 0; i < requests; i++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(pause(rng)));
+
+        auto start{ Clock::now() };
+        state.measure(1, [&sim]() { sim.requestAircraftLoaded().get(); });
+        state.addSample(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start));
+    }
+
+    sim.stop();
+}
+
+
+static Registration polled("messagePump/polled10ms", [](State& state) {
+    SimConnect::Builder builder;
+    builder.withName("BenchMessagePump.polled").withPolledDispatch().withMessagePollerRetryPeriod(10ms);
+    roundTrips(state, builder);
+});
+
+
+static Registration eventDriven("messagePump/eventDriven", [](State& state) {
+    SimConnect::Builder builder;
+    builder.withName("BenchMessagePump.eventDriven").withEventDrivenDispatch();
+    roundTrips(state, builder);
+});
\ No newline at end of file
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/sim/FakeSimulator.h"
+#include "../CppSimConnect/sim/SimState.h"
+
+#include "Benchmark.h"
+
+
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimBackend;
+
+
+static constexpr unsigned totalCalls{ 200'000 };
+static const std::string stateName{ "AircraftLoaded" };
+
+
+// Drains replies from the fake, so its buffers don't grow without bound.
+static void drain(FakeSimulator& fake) {
+    SIMCONNECT_RECV* msgPtr;
+    DWORD msgLen;
+    while (SUCCEEDED(fake.getNextDispatch(&msgPtr, &msgLen))) {}
+}
+
+static void runProducers(unsigned producers, std::function<void(unsigned reqId)> const& call) {
+    std::vector<std::jthread> threads;
+    for (unsigned p = 0; p < producers; p++) {
+        threads.emplace_back([p, producers, &call]() {
+            for (unsigned i = p; i < totalCalls; i += producers) {
+                call(i);
+            }
+        });
+    }
+}
+
+
+// The old way: every caller takes the lock, sends, and retrieves its own SendID.
+static void mutexSend(State& state, unsigned producers) {
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchOutbound", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    fake.open("BenchOutbound");
+    CppSimConnect::SimState simState(logger, fake);
+    std::mutex simConnectMutex;
+
+    std::atomic_bool done{ false };
+    std::jthread consumer([&]() {
+        while (!done) {
+            std::lock_guard<std::mutex> lock(simConnectMutex);
+            drain(fake);
+        }
+    });
+
+    state.measure(totalCalls, [&]() {
+        runProducers(producers, [&](unsigned reqId) {
+            std::function<HRESULT()> call{ [&fake, reqId]() { return fake.requestSystemState(reqId, stateName.c_str()); } };
+            std::lock_guard<std::mutex> lock(simConnectMutex);
+
+            DWORD sendId{ 0 };
+            if (SUCCEEDED(call()) && SUCCEEDED(fake.getLastSentPacketId(&sendId))) {
+                simState.addExceptionHandler(sendId, [](unsigned, std::string const&, unsigned) {});
+            }
+        });
+    });
+    done = true;
+}
+
+// Callers queue their calls, the dispatcher sends them in batches.
+static void queuedSend(State& state, unsigned producers) {
+    CppSimConnect::LogSink sink;
+    CppSimConnect::Logger logger("BenchOutbound", sink, CppSimConnect::LogLevel::Error);
+    FakeSimulator fake;
+    fake.open("BenchOutbound");
+    CppSimConnect::SimState simState(logger, fake);
+
+    std::atomic_bool done{ false };
+    std::jthread consumer([&]() {
+        while (!done || fake.requestsReceived() < totalCalls) {
+            simState.flushOutbound();
+            drain(fake);
+        }
+    });
+
+    std::chrono::nanoseconds submitted{ 0 };
+    state.measure(totalCalls, [&]() {
+        auto start{ CppSimConnect::Benchmarks::Clock::now() };
+        runProducers(producers, [&simState](unsigned reqId) {
+            simState.submit(
+                [reqId](SimBackend& backend) { return backend.requestSystemState(reqId, stateName.c_str()); },
+                [](unsigned, std::string const&, unsigned) {});
+        });
+        submitted = CppSimConnect::Benchmarks::Clock::now() - start;
+        done = true;
+        consumer.join();
+    });
+    state.counter("submit ns/op", static_cast<double>(submitted.count()) / totalCalls);
+}
+
+
+static bool registered = []() {
+    for (unsigned producers : { 1, 2, 4, 8, 16, 32 }) {
+        Registration("outbound/mutex/" + std::to_string(producers), [producers](State& state) { mutexSend(state, producers); });
+        Registration("outbound/queued/" + std::to_string(producers), [producers](State& state) { queuedSend(state, producers); });
+    }
+    return true;
+}();
\ No newline at end of file
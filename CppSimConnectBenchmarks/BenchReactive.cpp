@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <string>
+
+#include "../CppSimConnect/reactive/MessageObserver.h"
+#include "../CppSimConnect/reactive/MessageResult.h"
+
+#include "Benchmark.h"
+
+
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::Reactive::MessageObserver;
+using CppSimConnect::Reactive::MessageResult;
+using CppSimConnect::Reactive::_MessageObserver;
+
+
+using IntObserver = MessageObserver<std::uint64_t, _MessageObserver<std::uint64_t>>;
+
+// The whole life of an observer: create, subscribe, one message, complete.
+static Registration observerLifecycle("reactive/observerLifecycle", [](State& state) {
+    constexpr std::uint64_t observers{ 1'000'000 };
+
+    std::uint64_t total{ 0 };
+    std::uint64_t completed{ 0 };
+    state.measure(observers, [&]() {
+        for (std::uint64_t i = 0; i < observers; i++) {
+            IntObserver obs;
+            obs.subscribe([&total](const std::uint64_t& value) { total += value; }, [&completed]() { completed++; });
+            obs.onNext(i);
+            obs.onCompleted();
+        }
+    });
+    state.counter("completed", static_cast<double>(completed));
+});
+
+// Delivering to an observer that already has its subscribers.
+static void observerOnNext(State& state, unsigned subscribers) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    IntObserver obs;
+    std::uint64_t total{ 0 };
+    for (unsigned i = 0; i < subscribers; i++) {
+        obs.subscribe([&total](const std::uint64_t& value) { total += value; });
+    }
+
+    state.measure(messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; i++) {
+            obs.onNext(i);
+        }
+    });
+    state.counter("ns/subscriber", static_cast<double>(state.elapsed().count()) / static_cast<double>(messages * subscribers));
+}
+
+// Creating a result, completing it, and collecting the value through the future.
+template <typename T, typename F>
+static void resultGet(State& state, F&& makeValue) {
+    constexpr std::uint64_t results{ 500'000 };
+
+    T last{};
+    state.measure(results, [&]() {
+        for (std::uint64_t i = 0; i < results; i++) {
+            MessageResult<T> result;
+            result.onNext(makeValue(i));
+            last = result.get();
+        }
+    });
+}
+
+
+static bool registered = []() {
+    for (unsigned subscribers : { 1, 10, 100 }) {
+        Registration("reactive/observerOnNext/" + std::to_string(subscribers), [subscribers](State& state) { observerOnNext(state, subscribers); });
+    }
+    Registration("reactive/resultGet/integer", [](State& state) {
+        resultGet<std::uint64_t>(state, [](std::uint64_t i) { return i; });
+    });
+    Registration("reactive/resultGet/string", [](State& state) {
+        resultGet<std::string>(state, [](std::uint64_t) { return std::string("SimObjects\\Airplanes\\Benchmark\\aircraft.cfg"); });
+    });
+    return true;
+}();
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <thread>
+
+#include "../CppSimConnect/CppSimConnect.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+#include "../CppSimConnect/sim/MessageRecorder.h"
+#include "../CppSimConnect/sim/ReplayBackend.h"
+
+#include "Benchmark.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::Benchmarks::Registration;
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::MessageRecorder;
+using CppSimConnect::ReplayBackend;
+using CppSimConnect::SimConnect;
+
+
+// Messages without a handler are counted by type too, and the recordings have no types beyond the table.
+static std::uint64_t messagesReceived(const SimConnect& sim) {
+    const auto stats{ sim.messageStats() };
+    return std::accumulate(stats.received.begin(), stats.received.end(), std::uint64_t{ 0 });
+}
+
+// Play a recording through the dispatcher as fast as it goes, and report the throughput.
+static void replay(State& state, const std::string& name, const std::filesystem::path& file, double speed) {
+    auto backend = std::make_shared<ReplayBackend>(file, speed);
+    auto& sim = SimConnect::Builder()
+        .withName(name)
+        .withBackend(backend)
+        .withoutSystemStateCache()
+        .startStopped()
+        .build();
+
+    state.measure(0, [&]() {
+        if (sim.connect()) {
+            sim.start();
+            while (!backend->finished()) {
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+    });
+    sim.stop();
+    const auto dispatched{ messagesReceived(sim) };    // Before disconnecting drops the statistics
+    sim.disconnect();
+
+    state.counter("messages", static_cast<double>(backend->messagesReplayed()));
+    state.counter("dispatched", static_cast<double>(dispatched));
+    state.counter("messages/s", static_cast<double>(backend->messagesReplayed()) * 1e9 / static_cast<double>(state.elapsed().count()));
+}
+
+// A synthetic capture: the OPEN message, then system states and unhandled frame events.
+static std::filesystem::path syntheticCapture(std::uint64_t messages) {
+    auto path = std::filesystem::temp_directory_path() / "BenchReplay.rec";
+    MessageRecorder recorder(path);
+
+    SIMCONNECT_RECV_OPEN open{};
+    open.dwSize = sizeof(open);
+    open.dwID = SIMCONNECT_RECV_ID_OPEN;
+    recorder.record(&open, open.dwSize);
+
+    SIMCONNECT_RECV_SYSTEM_STATE systemState{};
+    systemState.dwSize = sizeof(systemState);
+    systemState.dwID = SIMCONNECT_RECV_ID_SYSTEM_STATE;
+    systemState.dwRequestID = 0xffffffff;
+    SIMCONNECT_RECV frame{ sizeof(SIMCONNECT_RECV), FakeSimulator::protocolVersion, SIMCONNECT_RECV_ID_EVENT_FRAME };
+
+    for (std::uint64_t i = 1; i < messages; i++) {
+        if ((i % 2) == 0) {
+            recorder.record(&systemState, systemState.dwSize);
+        }
+        else {
+            recorder.record(&frame, frame.dwSize);
+        }
+    }
+    return path;
+}
+
+
+static Registration record("replay/record", [](State& state) {
+    constexpr std::uint64_t messages{ 1'000'000 };
+
+    auto path = std::filesystem::temp_directory_path() / "BenchReplay.record.rec";
+    SIMCONNECT_RECV_SYSTEM_STATE msg{};
+    msg.dwSize = sizeof(msg);
+    msg.dwID = SIMCONNECT_RECV_ID_SYSTEM_STATE;
+    {
+        MessageRecorder recorder(path);
+        state.measure(messages, [&]() {
+            for (std::uint64_t i = 0; i < messages; i++) {
+                recorder.record(&msg, msg.dwSize);
+            }
+            recorder.flush();
+        });
+    }
+    state.counter("MB", static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0));
+    std::filesystem::remove(path);
+});
+
+static Registration replaySynthetic("replay/asFastAsPossible", [](State& state) {
+    const auto path{ syntheticCapture(1'000'000) };
+    replay(state, "BenchReplay.asFastAsPossible", path, ReplayBackend::asFastAsPossible);
+    std::filesystem::remove(path);
+});
+
+// Set CPPSIMCONNECT_REPLAY to a recording, made with SimConnect::Builder::withMessageRecording(), to benchmark it.
+// CPPSIMCONNECT_REPLAY_SPEED sets the speed, as a multiple of the recorded pace; the default is as fast as possible.
+static bool captureRegistered = []() {
+    if (const char* file = std::getenv("CPPSIMCONNECT_REPLAY")) {
+        const char* speed = std::getenv("CPPSIMCONNECT_REPLAY_SPEED");
+        Registration("replay/capture", [path = std::filesystem::path(file), speed = (speed != nullptr) ? std::atof(speed) : ReplayBackend::asFastAsPossible](State& state) {
+            replay(state, "BenchReplay.capture", path, speed);
+        });
+    }
+    return true;
+}();
\ No newline at end of file
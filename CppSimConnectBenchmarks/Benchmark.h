@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace CppSimConnect::Benchmarks {
+
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * <summary>Collects the timings of a single benchmark run.</summary>
+	 */
+	class State {
+		std::string _name;
+		std::uint64_t _operations{ 0 };
+		std::chrono::nanoseconds _elapsed{ 0 };
+		std::vector<std::chrono::nanoseconds> _samples;
+		std::map<std::string, double> _counters;
+
+	public:
+		State(std::string name) : _name(std::move(name)) {}
+
+		inline const std::string& name() const noexcept { return _name; }
+		inline std::uint64_t operations() const noexcept { return _operations; }
+		inline std::chrono::nanoseconds elapsed() const noexcept { return _elapsed; }
+
+		/**
+		 * <summary>Time the body, which is expected to perform the given number of operations.</summary>
+		 */
+		template <typename F>
+		void measure(std::uint64_t operations, F&& body) {
+			auto start{ Clock::now() };
+			body();
+			_elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+			_operations += operations;
+		}
+
+		// Latency samples, for percentiles
+		inline void reserveSamples(size_t count) { _samples.reserve(count); }
+		inline void addSample(std::chrono::nanoseconds sample) { _samples.push_back(sample); }
+		std::chrono::nanoseconds percentile(double p) {
+			if (_samples.empty()) {
+				return std::chrono::nanoseconds(0);
+			}
+			auto nth = _samples.begin() + static_cast<size_t>(p * static_cast<double>(_samples.size() - 1) / 100.0);
+			std::nth_element(_samples.begin(), nth, _samples.end());
+			return *nth;
+		}
+
+		inline void counter(const std::string& name, double value) { _counters[name] = value; }
+
+		void report(std::ostream& out) {
+			const char* sep{ " " };
+			out << _name << ":";
+			if (_operations != 0) {
+				const double ns{ static_cast<double>(_elapsed.count()) };
+				out << sep << _operations << " ops, "
+					<< ns / static_cast<double>(_operations) << " ns/op, "
+					<< static_cast<double>(_operations) * 1e9 / ns << " ops/s";
+				sep = ", ";
+			}
+			if (!_samples.empty()) {
+				out << sep << "p50 " << percentile(50.0).count() << " ns"
+					<< ", p99 " << percentile(99.0).count() << " ns";
+				sep = ", ";
+			}
+			for (const auto& [name, value] : _counters) {
+				out << sep << name << " " << value;
+				sep = ", ";
+			}
+			out << "\n";
+		}
+
+		/**
+		 * <summary>Write the results as a single line of JSON, so runs can be appended to one file and compared across commits.</summary>
+		 */
+		void reportJson(std::ostream& out, const std::string& label) {
+			out << "{\"name\":";
+			jsonString(out, _name);
+			if (!label.empty()) {
+				out << ",\"label\":";
+				jsonString(out, label);
+			}
+			out << ",\"operations\":" << _operations << ",\"elapsed_ns\":" << _elapsed.count();
+			if ((_operations != 0) && (_elapsed.count() != 0)) {
+				const double ns{ static_cast<double>(_elapsed.count()) };
+				out << ",\"ns_per_op\":" << ns / static_cast<double>(_operations)
+					<< ",\"ops_per_s\":" << static_cast<double>(_operations) * 1e9 / ns;
+			}
+			if (!_samples.empty()) {
+				out << ",\"p50_ns\":" << percentile(50.0).count() << ",\"p99_ns\":" << percentile(99.0).count();
+			}
+			out << ",\"counters\":{";
+			const char* sep{ "" };
+			for (const auto& [name, value] : _counters) {
+				out << sep;
+				jsonString(out, name);
+				out << ":";
+				jsonNumber(out, value);
+				sep = ",";
+			}
+			out << "}}\n";
+		}
+
+	private:
+		static void jsonString(std::ostream& out, const std::string& str) {
+			out << '"';
+			for (char c : str) {
+				switch (c) {
+				case '"': out << "\\\""; break;
+				case '\\': out << "\\\\"; break;
+				case '\n': out << "\\n"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						constexpr char hex[]{ "0123456789abcdef" };
+						out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+					}
+					else {
+						out << c;
+					}
+					break;
+				}
+			}
+			out << '"';
+		}
+
+		// JSON has no NaN or infinity.
+		static void jsonNumber(std::ostream& out, double value) {
+			if (std::isfinite(value)) {
+				out << value;
+			}
+			else {
+				out << "null";
+			}
+		}
+	};
+
+	using BenchmarkFunction = std::function<void(State& state)>;
+
+	inline std::vector<std::pair<std::string, BenchmarkFunction>>& registry() {
+		static std::vector<std::pair<std::string, BenchmarkFunction>> benchmarks;
+		return benchmarks;
+	}
+
+	/**
+	 * <summary>Adds a benchmark to the registry when constructed, typically as a static in the benchmark's source file.</summary>
+	 */
+	struct Registration {
+		Registration(std::string name, BenchmarkFunction benchmark) {
+			registry().emplace_back(std::move(name), std::move(benchmark));
+		}
+	};
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Benchmark.h"
+
+using CppSimConnect::Benchmarks::State;
+using CppSimConnect::Benchmarks::registry;
+
+// Usage: CppSimConnectBenchmarks [filter] [--json <file>] [--label <text>]
+// With --json every result is also appended to the file as a line of JSON, tagged with the label (e.g. a commit hash).
+int main(int argc, char* argv[])
+{
+    std::string filter;
+    std::string jsonPath;
+    std::string label;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg{ argv[i] };
+        if ((arg == "--json") && (i + 1 < argc)) {
+            jsonPath = argv[++i];
+        }
+        else if ((arg == "--label") && (i + 1 < argc)) {
+            label = argv[++i];
+        }
+        else {
+            filter = arg;
+        }
+    }
+
+    std::ofstream json;
+    if (!jsonPath.empty()) {
+        json.open(jsonPath, std::ios::app);
+        if (!json) {
+            std::cerr << "Cannot open '" << jsonPath << "' for writing.\n";
+            return 1;
+        }
+    }
+
+    for (auto& [name, benchmark] : registry()) {
+        if (name.find(filter) == std::string::npos) {
+            continue;
+        }
+        State state(name);
+        benchmark(state);
+        state.report(std::cout);
+        if (json.is_open()) {
+            state.reportJson(json, label);
+            json.flush();
+        }
+    }
+}
\ No newline at end of file
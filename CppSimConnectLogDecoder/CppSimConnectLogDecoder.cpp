@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <exception>
+#include <iostream>
+
+#include "../CppSimConnect/BinaryLog.h"
+
+
+using CppSimConnect::BinaryLogReader;
+using CppSimConnect::LogLevel;
+
+static void usage() {
+    std::cerr << "Usage: CppSimConnectLogDecoder <binary log file> [TRACE|DEBUG|INFO|WARN|ERROR|FATAL]\n"
+        << "Prints the messages in a log written with SimConnect::Builder::withBinaryLog(), optionally only those\n"
+        << "at or above the given level.\n";
+}
+
+int main(int argc, char* argv[])
+{
+    LogLevel threshold{ LogLevel::Trace };
+    if ((argc < 2) || (argc > 3) || ((argc == 3) && !CppSimConnect::parseLogLevel(argv[2], threshold))) {
+        usage();
+        return 2;
+    }
+
+    try {
+        BinaryLogReader reader(argv[1]);
+        CppSimConnect::decodeBinaryLog(reader, std::cout, threshold);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// The number of heap allocations made so far by the calling thread, so other threads can't skew a count.
+// TestInplaceFunction.cpp replaces operator new to count them.
+size_t heapAllocations() noexcept;
+
+template <typename F>
+static size_t allocationsIn(F&& body) {
+	size_t before{ heapAllocations() };
+	body();
+	return heapAllocations() - before;
+}
\ No newline at end of file
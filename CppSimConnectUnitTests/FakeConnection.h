@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "../CppSimConnect/sim/FakeSimulator.h"
+
+#include "WaitFor.h"
+
+// A running client that connects to the fake simulator, returned once it has. The builder can be configured
+// further before the client is built.
+template <typename Configure>
+static CppSimConnect::SimConnect& connectTo(const std::string& name, std::shared_ptr<CppSimConnect::FakeSimulator> fake, Configure configure) {
+	CppSimConnect::SimConnect::Builder builder;
+	builder.withName(name)
+		.withBackend(std::move(fake))
+		.withAutoConnect()
+		.startRunning();
+	configure(builder);
+	auto& sim = builder.build();
+
+	waitFor([&sim]() { return sim.connected(); });
+	return sim;
+}
+
+inline CppSimConnect::SimConnect& connectTo(const std::string& name, std::shared_ptr<CppSimConnect::FakeSimulator> fake) {
+	return connectTo(name, std::move(fake), [](CppSimConnect::SimConnect::Builder&) {});
+}
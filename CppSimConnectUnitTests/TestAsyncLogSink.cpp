@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/AsyncLogSink.h"
+
+
+using CppSimConnect::AsyncLogSink;
+using CppSimConnect::LogLevel;
+using CppSimConnect::LogOverflow;
+
+/**
+ * <summary>A sink that records what it gets, and holds on to the first message until released.</summary>
+ */
+class GatedSink {
+	std::mutex _lock;
+	std::vector<std::string> _lines;
+	std::atomic_bool _entered{ false };
+	std::atomic_bool _open;
+
+public:
+	GatedSink(bool open = true) : _open{ open } {}
+
+	void operator()(LogLevel, const std::string& msg) {
+		_entered = true;
+		_entered.notify_all();
+		_open.wait(false);
+		std::lock_guard lock(_lock);
+		_lines.push_back(msg);
+	}
+
+	void waitForFirst() { _entered.wait(false); }
+	void open() { _open = true; _open.notify_all(); }
+
+	std::vector<std::string> lines() {
+		std::lock_guard lock(_lock);
+		return _lines;
+	}
+};
+
+// Log "0", wait until the sink thread is stuck on it, then log "1" .. "<count-1>".
+static void logStuck(AsyncLogSink& sink, GatedSink& gate, int count) {
+	sink.log(LogLevel::Info, "0");
+	gate.waitForFirst();
+	for (int i = 1; i < count; i++) {
+		sink.log(LogLevel::Info, std::to_string(i));
+	}
+}
+
+TEST(TestAsyncLogSink, testOrderAndFlush) {
+	GatedSink gate;
+	AsyncLogSink sink([&gate](LogLevel level, const std::string& msg) { gate(level, msg); }, 16, LogOverflow::Block);
+
+	for (int i = 0; i < 100; i++) {
+		sink.log(LogLevel::Info, std::to_string(i));
+	}
+	sink.flush();
+
+	auto lines{ gate.lines() };
+	ASSERT_EQ(lines.size(), 100);
+	for (int i = 0; i < 100; i++) {
+		ASSERT_EQ(lines[i], std::to_string(i)) << "Messages arrive in the order they were logged.\n";
+	}
+	ASSERT_EQ(sink.stats().written, 100);
+	ASSERT_EQ(sink.stats().dropped, 0);
+	ASSERT_EQ(sink.stats().queued, 0);
+}
+
+TEST(TestAsyncLogSink, testDropNewest) {
+	GatedSink gate(false);
+	AsyncLogSink sink([&gate](LogLevel level, const std::string& msg) { gate(level, msg); }, 4, LogOverflow::DropNewest);
+
+	logStuck(sink, gate, 8);
+	ASSERT_EQ(sink.stats().queued, 4);
+	ASSERT_EQ(sink.stats().dropped, 3);
+
+	gate.open();
+	sink.flush();
+	ASSERT_EQ(gate.lines(), (std::vector<std::string>{ "0", "1", "2", "3", "4" })) << "Messages logged while full are lost.\n";
+}
+
+TEST(TestAsyncLogSink, testDropOldest) {
+	GatedSink gate(false);
+	AsyncLogSink sink([&gate](LogLevel level, const std::string& msg) { gate(level, msg); }, 4, LogOverflow::DropOldest);
+
+	logStuck(sink, gate, 8);
+	ASSERT_EQ(sink.stats().queued, 4);
+	ASSERT_EQ(sink.stats().dropped, 3);
+
+	gate.open();
+	sink.flush();
+	ASSERT_EQ(gate.lines(), (std::vector<std::string>{ "0", "4", "5", "6", "7" })) << "The oldest waiting messages make room.\n";
+}
+
+TEST(TestAsyncLogSink, testBlock) {
+	GatedSink gate(false);
+	AsyncLogSink sink([&gate](LogLevel level, const std::string& msg) { gate(level, msg); }, 4, LogOverflow::Block);
+
+	std::atomic_bool done{ false };
+	std::jthread producer([&]() {
+		logStuck(sink, gate, 8);
+		done = true;
+	});
+	while (sink.stats().queued < 4) {
+		std::this_thread::yield();
+	}
+	ASSERT_FALSE(done) << "The producer waits for room.\n";
+
+	gate.open();
+	producer.join();
+	sink.flush();
+	ASSERT_EQ(gate.lines().size(), 8);
+	ASSERT_EQ(sink.stats().dropped, 0);
+}
+
+TEST(TestAsyncLogSink, testTruncation) {
+	GatedSink gate;
+	AsyncLogSink sink([&gate](LogLevel level, const std::string& msg) { gate(level, msg); });
+
+	sink.log(LogLevel::Info, std::string(1000, 'x'));
+	sink.flush();
+
+	auto lines{ gate.lines() };
+	ASSERT_EQ(lines.size(), 1);
+	ASSERT_EQ(lines[0], std::string(AsyncLogSink::maxMessageLength, 'x'));
+}
\ No newline at end of file
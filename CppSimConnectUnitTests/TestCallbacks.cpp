@@ -16,6 +16,10 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <memory>
+#include <thread>
+
 #include "../CppSimConnect/reactive/Callbacks.h"
 
 using CppSimConnect::CallbackResult;
@@ -129,6 +133,57 @@ TEST(TestCallbacks, testCleanableCallbacks) {
 }
 
 
+TEST(TestCallbacks, testCleanableCallbacksChangedWhileInvoked) {
+
+	CppSimConnect::CleanableCallbackList<int> callbacks;
+
+	int calls{ 0 };
+	unsigned second{ 0 };
+	callbacks.add([&callbacks, &second, &calls](auto) {
+		calls++;
+		callbacks -= second;
+		callbacks.add([&calls](auto) { calls += 10; return CallbackResult::Done; });
+		return CallbackResult::Done;
+		});
+	second = callbacks.add([&calls](auto) { calls += 100; return CallbackResult::Ok; });
+
+	auto result = callbacks(1);
+	ASSERT_EQ(calls, 1) << "Removed callbacks are skipped, added ones wait for the next invocation.\n";
+	ASSERT_EQ(result, CallbackResult::Done);
+	ASSERT_EQ(callbacks.size(), 1);
+
+	result = callbacks(1);
+	ASSERT_EQ(calls, 11);
+	ASSERT_EQ(callbacks.size(), 0);
+}
+
+
+TEST(TestCallbacks, testCleanableCallbacksChangedWhileInvokedElsewhere) {
+	constexpr int changes{ 10000 };
+	constexpr int minimumCalls{ 1000 };
+	CppSimConnect::CleanableCallbackList<int> callbacks;
+	std::atomic_int calls{ 0 };
+	callbacks.add([&calls](auto) { calls++; return CallbackResult::Ok; });
+
+	std::atomic_bool invoking{ true };
+	std::jthread invoker([&callbacks, &invoking]() {
+		while (invoking) {
+			callbacks(1);
+		}
+	});
+	// Keep changing the list until the invoker has been through it often enough, however late it started.
+	auto captured = std::make_shared<int>(0);
+	for (int i = 0; (i < changes) || (calls < minimumCalls); i++) {
+		callbacks -= callbacks.add([captured](auto i) { *captured += i; return CallbackResult::Ok; });
+	}
+	invoking = false;
+	invoker.join();
+
+	ASSERT_EQ(callbacks.size(), 1) << "Versions replaced during an invocation are not lost.\n";
+	ASSERT_GE(calls, minimumCalls);
+}
+
+
 TEST(TestCallbacks, testCleanableShortcutCallbacks) {
 
 	CppSimConnect::CleanableShortcutCallbackList<int> callbacks;
@@ -16,24 +16,271 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "../CppSimConnect/events/ClientEvent.h"
+#include "../CppSimConnect/exceptions/SimException.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
 
-/*
-TEST(TestClientEvents, TestClientEventConstructor) {
-	const CppSimConnect::ClientEvent::EventID nextId{ CppSimConnect::ClientEvent::nextID() };
-	constexpr auto name1{ "test1" };
-	const CppSimConnect::ClientEvent evt1(name1);
+#include "FakeConnection.h"
+
+
+using namespace CppSimConnect::literals;
+
+using CppSimConnect::EventID;
+using CppSimConnect::EventManager;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimConnect;
+
+static SimConnect& stoppedClient(const std::string& name) {
+	return SimConnect::Builder()
+		.withName(name)
+		.withBackend(std::make_shared<FakeSimulator>())
+		.startStopped()
+		.build();
+}
+
+TEST(TestEventManager, testInterning) {
+	auto& events = stoppedClient("TestEventManager.testInterning").events();
+
+	const EventID apMaster{ events.eventID("AP_MASTER") };
+	const EventID parkingBrakes{ events.eventID(std::string("PARKING_BRAKES")) };
+	ASSERT_EQ(apMaster, 0) << "IDs are handed out from 0.\n";
+	ASSERT_EQ(parkingBrakes, 1);
+	ASSERT_EQ(events.eventID("AP_MASTER"), apMaster) << "A name keeps its ID.\n";
+	ASSERT_EQ(events.size(), 2);
+
+	ASSERT_EQ(events.name(apMaster), "AP_MASTER");
+	ASSERT_EQ(events.name(parkingBrakes), "PARKING_BRAKES");
+	ASSERT_TRUE(events.contains(parkingBrakes));
+	ASSERT_FALSE(events.contains(parkingBrakes + 1));
+}
+
+TEST(TestEventManager, testLiterals) {
+	static_assert("AP_MASTER"_event.hash() == CppSimConnect::eventNameHash("AP_MASTER"), "Literals are hashed at compile time.");
+
+	auto& events = stoppedClient("TestEventManager.testLiterals").events();
+
+	const EventID runtime{ events.eventID(std::string("AP_MASTER")) };
+	ASSERT_EQ(events.eventID("AP_MASTER"_event), runtime) << "Literals and runtime names share the ID space.\n";
+	ASSERT_EQ(events.eventID("AP_ALT_HOLD"_event), runtime + 1);
+	ASSERT_EQ(events.name(runtime + 1), "AP_ALT_HOLD");
+}
+
+TEST(TestEventManager, testPerClient) {
+	auto& events1 = stoppedClient("TestEventManager.testPerClient1").events();
+	auto& events2 = stoppedClient("TestEventManager.testPerClient2").events();
+
+	events1.eventID("AP_MASTER");
+	ASSERT_EQ(events1.eventID("PARKING_BRAKES"), 1);
+	ASSERT_EQ(events2.eventID("PARKING_BRAKES"), 0) << "Each client has its own ID space.\n";
+	ASSERT_EQ(events2.size(), 1);
+}
+
+TEST(TestEventManager, testGrowth) {
+	constexpr unsigned count{ 5000 };
+
+	auto& events = stoppedClient("TestEventManager.testGrowth").events();
+
+	const std::string longName(3000, 'X');
+	const EventID longId{ events.eventID(longName) };
+	for (unsigned i = 0; i < count; i++) {
+		ASSERT_EQ(events.eventID("EVENT_" + std::to_string(i)), i + 1);
+	}
+	for (unsigned i = 0; i < count; i++) {
+		ASSERT_EQ(events.eventID("EVENT_" + std::to_string(i)), i + 1) << "IDs survive the index growing.\n";
+		ASSERT_EQ(events.name(i + 1), "EVENT_" + std::to_string(i)) << "Names don't move when storage grows.\n";
+	}
+	ASSERT_EQ(events.name(longId), longName);
+	ASSERT_EQ(events.size(), count + 1);
+}
+
+TEST(TestEventManager, testConcurrentLookups) {
+	constexpr unsigned count{ 2000 };
+
+	auto& events = stoppedClient("TestEventManager.testConcurrentLookups").events();
+	const EventID known{ events.eventID("AP_MASTER") };
+
+	std::atomic_bool done{ false };
+	std::atomic<unsigned> mismatches{ 0 };
+	std::vector<std::jthread> readers;
+	for (unsigned i = 0; i < 3; i++) {
+		readers.emplace_back([&]() {
+			while (!done) {
+				if ((events.eventID("AP_MASTER") != known) || (events.name(known) != "AP_MASTER")) {
+					mismatches++;
+				}
+			}
+		});
+	}
+	std::vector<std::jthread> writers;
+	for (unsigned w = 0; w < 2; w++) {
+		writers.emplace_back([&, w]() {
+			for (unsigned i = 0; i < count; i++) {
+				const std::string name{ "EVENT_" + std::to_string(i) };
+				if (events.name(events.eventID(name)) != name) {
+					mismatches++;
+				}
+			}
+		});
+	}
+	writers.clear();
+	done = true;
+	readers.clear();
+
+	ASSERT_EQ(mismatches, 0);
+	ASSERT_EQ(events.size(), count + 1) << "Both writers interned the same names.\n";
+}
 
-	EXPECT_EQ(evt1.id(), nextId);
-	EXPECT_EQ(evt1.name(), name1);
+TEST(TestClientEvents, testClientEvent) {
+	auto& events = stoppedClient("TestClientEvents.testClientEvent").events();
+
+	const CppSimConnect::ClientEvent evt1(events, "AP_MASTER");
+	ASSERT_EQ(evt1.name(), "AP_MASTER");
+	ASSERT_EQ(evt1.id(), events.eventID("AP_MASTER"));
+
+	const CppSimConnect::ClientEvent evt2(events, "PARKING_BRAKES"_event);
+	ASSERT_NE(evt1.id(), evt2.id());
+
+	const CppSimConnect::ClientEvent evt3(events, std::string("AP_MASTER"));
+	ASSERT_EQ(evt1.id(), evt3.id()) << "The same name is the same event.\n";
+}
+
+
+using CppSimConnect::ClientEventSet;
+namespace GroupPriority = CppSimConnect::GroupPriority;
+
+static SimConnect& connectWith(const std::string& name, std::shared_ptr<FakeSimulator> fake, ClientEventSet events) {
+	return connectTo(name, std::move(fake), [&events](SimConnect::Builder& builder) {
+		builder.withoutSystemStateCache().withClientEvents(std::move(events));
+	});
+}
+
+TEST(TestClientEvents, testBulkRegistration) {
+	constexpr unsigned count{ 500 };
+
+	std::atomic<unsigned> received{ 0 };
+	std::atomic<std::uint32_t> lastData{ 0 };
+	ClientEventSet events;
+	for (unsigned i = 0; i < count; i++) {
+		const std::string name{ "EVENT_" + std::to_string(i) };
+		if ((i % 2) == 0) {
+			events.map(name);
+		}
+		else {
+			events.notify(name, [&received, &lastData](std::uint32_t data) { received++; lastData = data; }, ((i % 4) == 1) ? GroupPriority::Highest : GroupPriority::Standard);
+		}
+	}
+
+	auto fake = std::make_shared<FakeSimulator>();
+	auto& sim = connectWith("TestClientEvents.testBulkRegistration", fake, events);
+	ASSERT_TRUE(sim.connected());
+
+	ASSERT_TRUE(waitFor([&fake]() { return fake->clientEvents() == count; })) << "All events are mapped on connect.\n";
+	ASSERT_TRUE(waitFor([&fake]() { return fake->groupPriority(1) != SIMCONNECT_GROUP_PRIORITY_DEFAULT; }));
+	ASSERT_EQ(fake->notificationGroups(), 2) << "One notification group per priority.\n";
+	ASSERT_EQ(fake->groupPriority(0), GroupPriority::Highest);
+	ASSERT_EQ(fake->groupPriority(1), GroupPriority::Standard);
+
+	fake->fireEvent("EVENT_1", 42);
+	fake->fireEvent("EVENT_2", 43);		// Only mapped, so not sent to us
+	fake->fireEvent("EVENT_3", 44);
+	ASSERT_TRUE(waitFor([&received]() { return received == 2; }));
+	ASSERT_EQ(lastData, 44);
+	ASSERT_EQ(sim.exceptionStats().matched, 0);
+
+	sim.stop();
+}
+
+TEST(TestClientEvents, testRegistrationErrors) {
+	std::mutex lock;
+	std::vector<std::pair<std::string, unsigned>> errors;
+	ClientEventSet events;
+	events.map("AP_MASTER")
+		.notify("NO_SUCH_EVENT", [](std::uint32_t) {})
+		.map("PARKING_BRAKES")
+		.onError([&lock, &errors](std::string_view name, std::exception_ptr err) {
+			try {
+				std::rethrow_exception(err);
+			}
+			catch (const CppSimConnect::SimException& e) {
+				std::lock_guard guard(lock);
+				errors.emplace_back(name, e.exceptionId());
+			}
+		});
+
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withUnknownEvent("NO_SUCH_EVENT");
+	auto& sim = connectWith("TestClientEvents.testRegistrationErrors", fake, events);
+	ASSERT_TRUE(sim.connected());
+
+	ASSERT_TRUE(waitFor([&lock, &errors]() { std::lock_guard guard(lock); return errors.size() == 2; }));
+	ASSERT_EQ(errors[0], std::make_pair(std::string("NO_SUCH_EVENT"), unsigned(SIMCONNECT_EXCEPTION_NAME_UNRECOGNIZED)));
+	ASSERT_EQ(errors[1], std::make_pair(std::string("NO_SUCH_EVENT"), unsigned(SIMCONNECT_EXCEPTION_UNRECOGNIZED_ID))) << "It could not be added to its group either.\n";
+	ASSERT_TRUE(waitFor([&sim]() { return sim.exceptionStats().matched == 3; })) << "Exceptions are correlated by SendID, including the one for the empty group's priority.\n";
+	ASSERT_EQ(fake->clientEvents(), 2) << "The other events are not held up.\n";
+
+	sim.stop();
+}
+
+TEST(TestClientEvents, testAddAfterConnect) {
+	std::atomic<unsigned> first{ 0 };
+	std::atomic<unsigned> second{ 0 };
+	ClientEventSet events;
+	events.notify("AP_MASTER", [&first](std::uint32_t) { first++; });
+
+	auto fake = std::make_shared<FakeSimulator>();
+	auto& sim = connectWith("TestClientEvents.testAddAfterConnect", fake, events);
+	ASSERT_TRUE(sim.connected());
+	ASSERT_TRUE(waitFor([&fake]() { return fake->notificationGroups() == 1; }));
+
+	ClientEventSet more;
+	more.notify("AP_MASTER", [&second](std::uint32_t) { second++; }, GroupPriority::Lowest)
+		.map("PARKING_BRAKES");
+	sim.addClientEvents(std::move(more));
+	ASSERT_TRUE(waitFor([&fake]() { return fake->notificationGroups() == 2; }));
+	ASSERT_EQ(fake->clientEvents(), 2);
+	ASSERT_EQ(sim.exceptionStats().matched, 0) << "An event that is already mapped is not mapped again.\n";
+
+	fake->fireEvent("AP_MASTER");
+	ASSERT_TRUE(waitFor([&first, &second]() { return (first == 1) && (second == 1); })) << "Both sets hear of it, through their own group.\n";
+
+	sim.stop();
+}
 
-	constexpr auto name2{ "test2" };
-	const CppSimConnect::ClientEvent evt2(name2);
+TEST(TestClientEvents, testAddWhileConnecting) {
+	constexpr unsigned sets{ 20 };
 
-	EXPECT_NE(evt1.id(), evt2.id());
+	std::atomic<unsigned> received{ 0 };
+	auto fake = std::make_shared<FakeSimulator>();
+	auto& sim = SimConnect::Builder()
+		.withName("TestClientEvents.testAddWhileConnecting")
+		.withBackend(fake)
+		.withoutSystemStateCache()
+		.withAutoConnect()
+		.startRunning()
+		.build();
+	// The connection opens on the dispatcher thread while these are added.
+	for (unsigned i = 0; i < sets; i++) {
+		ClientEventSet more;
+		more.notify("AP_MASTER", [&received](std::uint32_t) { received++; });
+		sim.addClientEvents(std::move(more));
+	}
+	ASSERT_TRUE(waitFor([&sim]() { return sim.connected(); }));
+	ASSERT_TRUE(waitFor([&fake]() { return fake->notificationGroups() == sets; }));
 
-	const CppSimConnect::ClientEvent evt3(name1);
+	fake->fireEvent("AP_MASTER");
+	ASSERT_TRUE(waitFor([&received]() { return received >= sets; }));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(received, sets) << "Each set is registered once, whether it was added before or after the connection opened.\n";
+	ASSERT_EQ(fake->clientEvents(), 1);
+	ASSERT_EQ(sim.exceptionStats().matched, 0);
 
-	EXPECT_EQ(evt1.id(), evt3.id());
+	sim.stop();
 }
-*/
\ No newline at end of file
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "../CppSimConnect/reactive/Executor.h"
+#include "../CppSimConnect/reactive/MessageResult.h"
+#include "../CppSimConnect/reactive/WhenAll.h"
+
+
+using CppSimConnect::Reactive::MessageResult;
+using CppSimConnect::Reactive::Task;
+using CppSimConnect::Reactive::whenAll;
+
+// Collects tasks until the test runs them, like an event loop would.
+class QueueExecutor {
+	std::deque<Task> _tasks;
+
+public:
+	inline void execute(Task task) { _tasks.push_back(std::move(task)); }
+
+	inline size_t size() const noexcept { return _tasks.size(); }
+	void run() {
+		while (!_tasks.empty()) {
+			auto task = std::move(_tasks.front());
+			_tasks.pop_front();
+			task();
+		}
+	}
+};
+static_assert(CppSimConnect::Reactive::Executor<QueueExecutor>);
+
+static MessageResult<size_t> measure(MessageResult<std::string> input) {
+	auto value = co_await input;
+	co_return value.size();
+}
+
+static MessageResult<size_t> measureOn(MessageResult<std::string> input, QueueExecutor& executor) {
+	auto value = co_await input.on(executor);
+	co_return value.size();
+}
+
+static MessageResult<size_t> addAll(std::vector<MessageResult<size_t>> inputs) {
+	size_t sum{ 0 };
+	for (auto value : co_await whenAll(inputs)) {
+		sum += value;
+	}
+	co_return sum;
+}
+
+TEST(TestCoroutines, testAlreadyCompleted) {
+	MessageResult<std::string> input;
+	input.onNext("Hello");
+
+	auto result = measure(input);
+	ASSERT_TRUE(result.completed()) << "A completed result does not suspend the coroutine.\n";
+	ASSERT_EQ(result.get(), 5);
+	ASSERT_EQ(input.get(), "Hello") << "A result can be read more than once.\n";
+}
+
+TEST(TestCoroutines, testResumeInline) {
+	MessageResult<std::string> input;
+
+	auto result = measure(input);
+	ASSERT_FALSE(result.completed()) << "The coroutine waits for its input.\n";
+
+	input.onNext("Hello, World!");
+	ASSERT_TRUE(result.completed()) << "The coroutine resumes on the completing thread.\n";
+	ASSERT_EQ(result.get(), 13);
+}
+
+TEST(TestCoroutines, testResumeOnExecutor) {
+	QueueExecutor executor;
+	MessageResult<std::string> input;
+
+	auto result = measureOn(input, executor);
+	input.onNext("Hello");
+	ASSERT_FALSE(result.completed()) << "The coroutine resumes only when the executor runs it.\n";
+	ASSERT_EQ(executor.size(), 1);
+
+	executor.run();
+	ASSERT_TRUE(result.completed());
+	ASSERT_EQ(result.get(), 5);
+}
+
+TEST(TestCoroutines, testError) {
+	MessageResult<std::string> input;
+
+	auto result = measure(input);
+	input.onError(std::make_exception_ptr(std::runtime_error("No such state")));
+
+	ASSERT_TRUE(result.completed());
+	ASSERT_NE(result.error(), nullptr) << "The exception passes through the coroutine.\n";
+	ASSERT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(TestCoroutines, testManyOnOneThread) {
+	constexpr size_t count{ 500 };
+	QueueExecutor executor;
+
+	std::vector<MessageResult<std::string>> inputs(count);
+	std::vector<MessageResult<size_t>> results;
+	for (auto& input : inputs) {
+		results.push_back(measureOn(input, executor));
+	}
+	// The replies arrive on another thread, as they would from the dispatcher.
+	std::jthread([&inputs]() {
+		for (size_t i = 0; i < inputs.size(); i++) {
+			inputs[i].onNext(std::string(i % 10, 'x'));
+		}
+	}).join();
+
+	ASSERT_EQ(executor.size(), count);
+	executor.run();
+
+	auto total = addAll(results);
+	ASSERT_TRUE(total.completed());
+	ASSERT_EQ(total.get(), (count / 10) * 45);
+}
+
+// The replies race the coroutines suspending and whenAll() subscribing; none may be lost.
+TEST(TestCoroutines, testCompleteWhileAwaiting) {
+	constexpr size_t rounds{ 200 };
+	constexpr size_t count{ 20 };
+
+	for (size_t round = 0; round < rounds; round++) {
+		std::vector<MessageResult<std::string>> inputs(count);
+		std::atomic_bool go{ false };
+		std::jthread replier([&inputs, &go]() {
+			while (!go) { std::this_thread::yield(); }
+			for (size_t i = 0; i < inputs.size(); i++) {
+				inputs[i].onNext(std::string(i % 10, 'x'));
+			}
+		});
+
+		std::vector<MessageResult<size_t>> results;
+		go = true;
+		for (auto& input : inputs) {
+			results.push_back(measure(input));
+		}
+		auto total = addAll(results);
+		replier.join();
+
+		ASSERT_TRUE(total.completed()) << "Round " << round << " lost a resumption.\n";
+		ASSERT_EQ(total.get(), (count / 10) * 45);
+	}
+}
+
+TEST(TestCoroutines, testWhenAll) {
+	MessageResult<std::string> name;
+	MessageResult<bool> flying;
+	name.onNext("Test.FLT");
+
+	auto both = whenAll(name, flying);
+	ASSERT_FALSE(both.completed()) << "Waits for every input.\n";
+
+	flying.onNext(true);
+	ASSERT_TRUE(both.completed());
+	ASSERT_EQ(both.get(), std::make_tuple(std::string("Test.FLT"), true));
+}
+
+TEST(TestCoroutines, testWhenAllError) {
+	MessageResult<std::string> name;
+	MessageResult<bool> flying;
+
+	auto both = whenAll(name, flying);
+	flying.onError(std::make_exception_ptr(std::runtime_error("No such state")));
+	ASSERT_TRUE(both.completed()) << "The first error completes the combined result.\n";
+	ASSERT_THROW(both.get(), std::runtime_error);
+
+	name.onNext("Test.FLT");
+	ASSERT_THROW(both.get(), std::runtime_error);
+
+	auto none = whenAll(std::vector<MessageResult<int>>{});
+	ASSERT_TRUE(none.completed());
+	ASSERT_TRUE(none.get().empty());
+}
\ No newline at end of file
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/exceptions/NotConnected.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+
+#include "FakeConnection.h"
+
+
+using CppSimConnect::DataDefinition;
+using CppSimConnect::DataPeriod;
+using CppSimConnect::DataUpdate;
+using CppSimConnect::DataType;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimConnect;
+using CppSimConnect::dataLayout;
+using CppSimConnect::field;
+
+struct TestPosition {
+	double latitude;
+	double longitude;
+	double altitude;
+};
+
+template <>
+struct CppSimConnect::DataDefinition<TestPosition> {
+	static constexpr auto fields{ std::make_tuple(
+		field(&TestPosition::latitude, "PLANE LATITUDE", "degrees"),
+		field(&TestPosition::longitude, "PLANE LONGITUDE", "degrees"),
+		field(&TestPosition::altitude, "PLANE ALTITUDE", "feet", 0.5f)) };
+};
+
+#pragma pack(push, 1)
+struct TestAircraft {
+	char title[256];
+	std::int32_t engines;
+	float fuel;
+	std::int64_t flags;
+};
+#pragma pack(pop)
+
+template <>
+struct CppSimConnect::DataDefinition<TestAircraft> {
+	static constexpr auto fields{ std::make_tuple(
+		field(&TestAircraft::title, "TITLE"),
+		field(&TestAircraft::engines, "NUMBER OF ENGINES", "number"),
+		field(&TestAircraft::fuel, "FUEL TOTAL QUANTITY", "gallons"),
+		field(&TestAircraft::flags, "TEST FLAGS", "number")) };
+};
+
+struct TestOutOfOrder {
+	double first;
+	double second;
+};
+
+template <>
+struct CppSimConnect::DataDefinition<TestOutOfOrder> {
+	static constexpr auto fields{ std::make_tuple(
+		field(&TestOutOfOrder::second, "SECOND", "number"),
+		field(&TestOutOfOrder::first, "FIRST", "number")) };
+};
+
+TEST(TestDataDefinition, testLayout) {
+	const auto& position = dataLayout<TestPosition>();
+	ASSERT_EQ(position.size(), sizeof(TestPosition));
+	ASSERT_EQ(position.data().size(), 3);
+	ASSERT_EQ(position.data()[2].name, "PLANE ALTITUDE");
+	ASSERT_EQ(position.data()[2].unit, "feet");
+	ASSERT_EQ(position.data()[2].offset, offsetof(TestPosition, altitude));
+	ASSERT_EQ(position.data()[2].epsilon, 0.5f);
+	ASSERT_EQ(&position, &dataLayout<TestPosition>()) << "There is one layout per struct.\n";
+
+	const auto& aircraft = dataLayout<TestAircraft>();
+	ASSERT_EQ(aircraft.size(), 256 + 4 + 4 + 8);
+	ASSERT_EQ(aircraft.data()[0].type, DataType::String256);
+	ASSERT_TRUE(aircraft.data()[0].unit.empty());
+	ASSERT_EQ(aircraft.data()[1].type, DataType::Int32);
+	ASSERT_EQ(aircraft.data()[2].type, DataType::Float32);
+	ASSERT_EQ(aircraft.data()[2].offset, 260);
+	ASSERT_EQ(aircraft.data()[3].type, DataType::Int64);
+}
+
+TEST(TestDataDefinition, testOutOfOrder) {
+	ASSERT_THROW(dataLayout<TestOutOfOrder>(), std::logic_error);
+}
+
+TEST(TestDataDefinition, testRequestData) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("PLANE LATITUDE", 52.3)
+		.withSimVar("PLANE LONGITUDE", 4.76)
+		.withSimVar("PLANE ALTITUDE", 3500.0)
+		.withSimVar("TITLE", "Test Aircraft")
+		.withSimVar("NUMBER OF ENGINES", 2.0)
+		.withSimVar("FUEL TOTAL QUANTITY", 120.5)
+		.withSimVar("TEST FLAGS", 1099511627776.0);
+
+	auto& sim = connectTo("TestDataDefinition.testRequestData", fake);
+	ASSERT_TRUE(sim.connected());
+
+	auto position = sim.requestData<TestPosition>().get();
+	ASSERT_DOUBLE_EQ(position.latitude, 52.3);
+	ASSERT_DOUBLE_EQ(position.longitude, 4.76);
+	ASSERT_DOUBLE_EQ(position.altitude, 3500.0);
+
+	auto aircraft = sim.requestData<TestAircraft>().get();
+	ASSERT_STREQ(aircraft.title, "Test Aircraft");
+	ASSERT_EQ(aircraft.engines, 2);
+	ASSERT_FLOAT_EQ(aircraft.fuel, 120.5f);
+	ASSERT_EQ(aircraft.flags, 1099511627776);
+
+	fake->withSimVar("PLANE ALTITUDE", 4000.0);
+	position = sim.requestData<TestPosition>().get();
+	ASSERT_DOUBLE_EQ(position.altitude, 4000.0);
+
+	ASSERT_EQ(fake->dataDefinitions(), 2) << "A definition is sent once per connection.\n";
+	ASSERT_EQ(fake->dataRequestsReceived(), 3);
+
+	sim.stop();
+}
+
+TEST(TestDataDefinition, testRequestDataView) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("PLANE ALTITUDE", 1200.0);
+
+	auto& sim = connectTo("TestDataDefinition.testRequestDataView", fake);
+	ASSERT_TRUE(sim.connected());
+
+	std::promise<double> altitude;
+	sim.requestData<TestPosition>(
+		[&altitude](const TestPosition& position) { altitude.set_value(position.altitude); },
+		[&altitude](std::exception_ptr err) { altitude.set_exception(err); });
+
+	auto future = altitude.get_future();
+	ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_DOUBLE_EQ(future.get(), 1200.0);
+
+	sim.stop();
+}
+
+TEST(TestDataDefinition, testNotConnected) {
+	auto& sim = SimConnect::Builder()
+		.withName("TestDataDefinition.testNotConnected")
+		.withBackend(std::make_shared<FakeSimulator>())
+		.startStopped()
+		.build();
+
+	ASSERT_THROW(sim.requestData<TestPosition>().get(), CppSimConnect::NotConnected);
+}
+
+TEST(TestDataDefinition, testSubscribe) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("PLANE ALTITUDE", 1000.0);
+
+	auto& sim = connectTo("TestDataDefinition.testSubscribe", fake);
+	ASSERT_TRUE(sim.connected());
+
+	std::mutex lock;
+	std::vector<double> altitudes;
+	auto stream = sim.subscribe<TestPosition>(CppSimConnect::UserObjectId, DataPeriod::SimFrame);
+	stream.subscribe([&](const TestPosition& position) {
+		std::lock_guard guard(lock);
+		altitudes.push_back(position.altitude);
+	});
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 1; }));
+
+	fake->tick(SIMCONNECT_PERIOD_SIM_FRAME);
+	fake->tick(SIMCONNECT_PERIOD_SECOND);
+	fake->withSimVar("PLANE ALTITUDE", 1100.0);
+	fake->tick(SIMCONNECT_PERIOD_VISUAL_FRAME);
+	ASSERT_TRUE(waitFor([&]() { std::lock_guard guard(lock); return altitudes.size() == 2; }));
+	{
+		std::lock_guard guard(lock);
+		ASSERT_EQ(altitudes, (std::vector<double>{ 1000.0, 1100.0 })) << "Every frame sends the data, other periods do not.\n";
+	}
+
+	stream.onCompleted();
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 0; })) << "Completing the stream ends the subscription.\n";
+
+	sim.stop();
+}
+
+TEST(TestDataDefinition, testStreamOutlivesClient) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("PLANE ALTITUDE", 1000.0);
+
+	auto& sim = connectTo("TestDataDefinition.testStreamOutlivesClient", fake);
+	ASSERT_TRUE(sim.connected());
+	auto stream = sim.subscribe<TestPosition>(CppSimConnect::UserObjectId, DataPeriod::SimFrame);
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 1; }));
+
+	// A client with the same name replaces the first one, which takes its connection with it.
+	auto other = std::make_shared<FakeSimulator>();
+	auto& replacement = connectTo("TestDataDefinition.testStreamOutlivesClient", other);
+	ASSERT_TRUE(replacement.connected());
+	auto current = replacement.subscribe<TestPosition>(CppSimConnect::UserObjectId, DataPeriod::SimFrame);
+	ASSERT_TRUE(waitFor([&other]() { return other->dataSubscriptions() == 1; }));
+
+	stream.onCompleted();
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(other->dataSubscriptions(), 1) << "Completing a stream of a client that is gone touches nothing.\n";
+
+	current.onCompleted();
+	ASSERT_TRUE(waitFor([&other]() { return other->dataSubscriptions() == 0; }));
+	replacement.stop();
+}
+
+TEST(TestDataDefinition, testStreamOutlivesConnection) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("PLANE ALTITUDE", 1000.0);
+
+	auto& sim = connectTo("TestDataDefinition.testStreamOutlivesConnection", fake);
+	ASSERT_TRUE(sim.connected());
+	auto stream = sim.subscribe<TestPosition>(CppSimConnect::UserObjectId, DataPeriod::SimFrame);
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 1; }));
+
+	// The auto-connector makes a new connection, which gets the same RequestIDs as the first one.
+	sim.disconnect();
+	ASSERT_TRUE(waitFor([&sim]() { return sim.connected(); }));
+	auto current = sim.subscribe<TestPosition>(CppSimConnect::UserObjectId, DataPeriod::SimFrame);
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 1; }));
+
+	stream.onCompleted();
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(fake->dataSubscriptions(), 1) << "Completing a stream of an earlier connection leaves the current one alone.\n";
+
+	current.onCompleted();
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 0; }));
+	sim.stop();
+}
+
+TEST(TestDataDefinition, testStreamEndsOnDisconnect) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("PLANE ALTITUDE", 1000.0);
+
+	auto& sim = connectTo("TestDataDefinition.testStreamEndsOnDisconnect", fake);
+	ASSERT_TRUE(sim.connected());
+
+	std::atomic_bool notConnected{ false };
+	std::atomic_bool completed{ false };
+	auto stream = sim.subscribe<TestPosition>(CppSimConnect::UserObjectId, DataPeriod::SimFrame);
+	stream.withOnError([&notConnected](std::exception_ptr err) {
+		try {
+			std::rethrow_exception(err);
+		}
+		catch (const CppSimConnect::NotConnected&) {
+			notConnected = true;
+		}
+		catch (...) {}
+	});
+	stream.withOnComplete([&completed]() { completed = true; });
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 1; }));
+
+	sim.disconnect();
+	ASSERT_TRUE(notConnected) << "The subscription ends with the connection.\n";
+	ASSERT_TRUE(completed);
+
+	ASSERT_TRUE(waitFor([&sim]() { return sim.connected(); }));
+	ASSERT_EQ(fake->dataSubscriptions(), 0) << "The new connection has no subscription for the stream.\n";
+	sim.stop();
+}
+
+TEST(TestDataDefinition, testSubscribeChanged) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("PLANE ALTITUDE", 1000.0);
+
+	auto& sim = connectTo("TestDataDefinition.testSubscribeChanged", fake);
+	ASSERT_TRUE(sim.connected());
+
+	std::atomic<int> received{ 0 };
+	auto stream = sim.subscribe<TestPosition>(CppSimConnect::UserObjectId, DataPeriod::Second, true);
+	stream.subscribe([&received](const TestPosition&) { received++; });
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 1; }));
+
+	fake->tick(SIMCONNECT_PERIOD_SECOND);
+	fake->tick(SIMCONNECT_PERIOD_SECOND);
+	fake->tick(SIMCONNECT_PERIOD_SECOND);
+	fake->withSimVar("PLANE LATITUDE", 1.0);
+	fake->tick(SIMCONNECT_PERIOD_SECOND);
+	ASSERT_TRUE(waitFor([&received]() { return received == 2; }));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(received, 2) << "Unchanged data is not sent.\n";
+
+	stream.onCompleted();
+	sim.stop();
+}
+
+TEST(TestDataDefinition, testSubscribeTagged) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withSimVar("TITLE", "Tagged")
+		.withSimVar("NUMBER OF ENGINES", 4.0)
+		.withSimVar("FUEL TOTAL QUANTITY", 200.0);
+
+	auto& sim = connectTo("TestDataDefinition.testSubscribeTagged", fake);
+	ASSERT_TRUE(sim.connected());
+
+	std::mutex lock;
+	std::vector<DataUpdate<TestAircraft>> updates;
+	auto stream = sim.subscribeTagged<TestAircraft>(CppSimConnect::UserObjectId, DataPeriod::SimFrame);
+	stream.subscribe([&](const DataUpdate<TestAircraft>& update) {
+		std::lock_guard guard(lock);
+		updates.push_back(update);
+	});
+	ASSERT_TRUE(waitFor([&fake]() { return fake->dataSubscriptions() == 1; }));
+
+	fake->tick(SIMCONNECT_PERIOD_SIM_FRAME);
+	fake->tick(SIMCONNECT_PERIOD_SIM_FRAME);
+	fake->withSimVar("FUEL TOTAL QUANTITY", 199.5);
+	fake->tick(SIMCONNECT_PERIOD_SIM_FRAME);
+	ASSERT_TRUE(waitFor([&]() { std::lock_guard guard(lock); return updates.size() == 2; }));
+
+	std::lock_guard guard(lock);
+	ASSERT_EQ(updates[0].changedCount(), 4) << "The first update has all fields.\n";
+	ASSERT_STREQ(updates[0].value.title, "Tagged");
+
+	ASSERT_EQ(updates[1].changedCount(), 1);
+	ASSERT_TRUE(updates[1].changed(2));
+	ASSERT_FLOAT_EQ(updates[1].value.fuel, 199.5f);
+	ASSERT_EQ(updates[1].value.engines, 4) << "Fields that did not change keep their last value.\n";
+	ASSERT_STREQ(updates[1].value.title, "Tagged");
+
+	stream.onCompleted();
+	sim.stop();
+}
\ No newline at end of file
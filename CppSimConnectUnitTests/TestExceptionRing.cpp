@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <chrono>
+#include <string>
+
+#include "../CppSimConnect/sim/ExceptionRing.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::ExceptionCallback;
+using CppSimConnect::ExceptionInfo;
+using CppSimConnect::ExceptionRing;
+
+static ExceptionCallback recordInto(unsigned& exceptionId) {
+	return [&exceptionId](unsigned id, std::string const&, unsigned) { exceptionId = id; };
+}
+
+TEST(TestExceptionRing, testMatch) {
+	ExceptionRing ring(16, 1s);
+	unsigned first{ 0 };
+	unsigned second{ 0 };
+	ExceptionInfo early{ 0, 0 };
+
+	ASSERT_FALSE(ring.add(1, recordInto(first), early));
+	ASSERT_FALSE(ring.add(2, recordInto(second), early));
+
+	auto handler = ring.match(2, { 3, 1 });
+	ASSERT_TRUE(handler) << "The handler for the SendID is found.\n";
+	handler(3, "", 1);
+	ASSERT_EQ(first, 0);
+	ASSERT_EQ(second, 3);
+	ASSERT_FALSE(ring.match(2, { 3, 1 })) << "A handler is only used once.\n";
+
+	auto stats = ring.stats();
+	ASSERT_EQ(stats.matched, 1);
+	ASSERT_EQ(stats.unmatched, 1);
+	ASSERT_EQ(stats.dropped, 0);
+}
+
+TEST(TestExceptionRing, testDepth) {
+	ExceptionRing ring(10, 1s);
+	ASSERT_EQ(ring.depth(), 16) << "The depth is rounded up to a power of two.\n";
+
+	unsigned exceptionId{ 0 };
+	ExceptionInfo early{ 0, 0 };
+	ring.add(1, recordInto(exceptionId), early);
+	ring.add(17, recordInto(exceptionId), early);
+
+	ASSERT_FALSE(ring.match(1, { 3, 1 })) << "Handlers are overwritten by SendIDs a full ring later.\n";
+	ASSERT_TRUE(ring.match(17, { 3, 1 }));
+}
+
+TEST(TestExceptionRing, testEarlyError) {
+	ExceptionRing ring(16, 1s);
+	auto now = ExceptionRing::Clock::now();
+
+	ASSERT_FALSE(ring.match(5, { 7, 2 }, now));
+
+	unsigned exceptionId{ 0 };
+	ExceptionInfo early{ 0, 0 };
+	auto handler = ring.add(5, recordInto(exceptionId), early, now + 10ms);
+	ASSERT_TRUE(handler) << "An early error hands back the handler when it is added.\n";
+	ASSERT_EQ(early.exceptionId, 7);
+	ASSERT_EQ(early.parmIndex, 2);
+	handler(early.exceptionId, "", early.parmIndex);
+	ASSERT_EQ(exceptionId, 7);
+
+	auto stats = ring.stats();
+	ASSERT_EQ(stats.matched, 1);
+	ASSERT_EQ(stats.unmatched, 1);
+	ASSERT_EQ(stats.dropped, 0);
+}
+
+TEST(TestExceptionRing, testEarlyErrorEviction) {
+	ExceptionRing ring(16, 1s);
+	auto now = ExceptionRing::Clock::now();
+	ExceptionInfo early{ 0, 0 };
+	unsigned exceptionId{ 0 };
+
+	ring.match(5, { 7, 2 }, now);
+	ASSERT_FALSE(ring.add(5, recordInto(exceptionId), early, now + 2s)) << "Early errors that are too old are not delivered.\n";
+
+	ring.match(6, { 7, 2 }, now);
+	ring.match(22, { 7, 2 }, now);
+	ASSERT_FALSE(ring.add(6, recordInto(exceptionId), early, now)) << "Early errors are overwritten by SendIDs a full ring later.\n";
+
+	auto stats = ring.stats();
+	ASSERT_EQ(stats.matched, 0);
+	ASSERT_EQ(stats.unmatched, 3);
+	ASSERT_EQ(stats.dropped, 2);
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/reactive/Executor.h"
+#include "../CppSimConnect/reactive/StreamResult.h"
+#include "../CppSimConnect/reactive/ThreadExecutor.h"
+#include "../CppSimConnect/reactive/ThreadPoolExecutor.h"
+
+#include "WaitFor.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::Reactive::BufferPolicy;
+using CppSimConnect::Reactive::InlineExecutor;
+using CppSimConnect::Reactive::OverflowPolicy;
+using CppSimConnect::Reactive::StreamResult;
+using CppSimConnect::Reactive::ThreadExecutor;
+using CppSimConnect::Reactive::ThreadPoolExecutor;
+
+static_assert(CppSimConnect::Reactive::Executor<InlineExecutor>);
+static_assert(CppSimConnect::Reactive::Executor<ThreadExecutor>);
+static_assert(CppSimConnect::Reactive::Executor<ThreadPoolExecutor>);
+
+TEST(TestExecutors, testThreadExecutor) {
+	ThreadExecutor executor;
+	std::vector<int> order;
+	std::atomic<int> done{ 0 };
+	std::atomic_bool onOtherThread{ true };
+
+	for (int i = 0; i < 100; i++) {
+		executor.execute([&, i]() {
+			order.push_back(i);
+			onOtherThread = onOtherThread && executor.onExecutorThread();
+			done++;
+		});
+	}
+	ASSERT_TRUE(waitFor([&done]() { return done == 100; }, 10s));
+	ASSERT_TRUE(onOtherThread);
+	for (int i = 0; i < 100; i++) {
+		ASSERT_EQ(order[i], i) << "Tasks run in order.\n";
+	}
+}
+
+TEST(TestExecutors, testThreadPoolExecutor) {
+	ThreadPoolExecutor pool(4);
+	std::atomic<int> done{ 0 };
+
+	// Tasks that queue more tasks put them on their own worker, where others can steal them.
+	for (int i = 0; i < 10; i++) {
+		pool.execute([&pool, &done]() {
+			for (int j = 0; j < 100; j++) {
+				pool.execute([&done]() { done++; });
+			}
+			done++;
+		});
+	}
+	ASSERT_TRUE(waitFor([&done]() { return done == 1010; }, 10s));
+	std::cout << "Pool of " << pool.threads() << " threads stole " << pool.stolen() << " tasks.\n";
+}
+
+TEST(TestExecutors, testPoolRunsQueuedTasksWhenDestroyed) {
+	constexpr int count{ 1000 };
+	std::atomic<int> done{ 0 };
+	std::vector<int> received;
+	bool completed{ false };
+	{
+		StreamResult<int> stream;
+		ThreadPoolExecutor pool(2);
+		stream.observeOn(pool, BufferPolicy{ OverflowPolicy::Block, 64 }).subscribe([&received](int i) { received.push_back(i); }, [&completed]() { completed = true; });
+		for (int i = 0; i < count; i++) {
+			pool.execute([&pool, &done, i]() {
+				if ((i % 10) == 0) {
+					pool.execute([&done]() { done++; });
+				}
+				done++;
+			});
+			stream.onNext(i);
+		}
+		stream.onCompleted();
+	}
+	ASSERT_EQ(done, count + count / 10) << "Tasks queued before, and while, the pool stopped all ran.\n";
+	ASSERT_EQ(received.size(), count);
+	ASSERT_TRUE(completed) << "The observeOn() drain was not dropped.\n";
+}
+
+TEST(TestExecutors, testObserveOnKeepsOrder) {
+	constexpr int count{ 10000 };
+	constexpr int subscribers{ 4 };
+	ThreadPoolExecutor pool(4);
+	StreamResult<int> stream;
+
+	std::vector<std::vector<int>> received(subscribers);
+	std::atomic<int> completed{ 0 };
+	for (int s = 0; s < subscribers; s++) {
+		stream.observeOn(pool, BufferPolicy{ OverflowPolicy::Block, 64 })
+			.subscribe([&received, s](int i) { received[s].push_back(i); }, [&completed]() { completed++; });
+	}
+	for (int i = 0; i < count; i++) {
+		stream.onNext(i);
+	}
+	stream.onCompleted();
+
+	ASSERT_TRUE(waitFor([&completed]() { return completed == subscribers; }, 10s));
+	for (int s = 0; s < subscribers; s++) {
+		ASSERT_EQ(received[s].size(), count);
+		for (int i = 0; i < count; i++) {
+			ASSERT_EQ(received[s][i], i) << "Each subscriber sees the values in order.\n";
+		}
+	}
+}
+
+TEST(TestExecutors, testSlowSubscriberDoesNotStall) {
+	ThreadExecutor slowThread;
+	StreamResult<int> stream;
+	std::atomic<int> slow{ 0 };
+	int fast{ 0 };
+
+	stream.observeOn(slowThread, BufferPolicy{ OverflowPolicy::DropOldest, 1024 })
+		.subscribe([&slow](int) { std::this_thread::sleep_for(1ms); slow++; });
+	stream.subscribe([&fast](int) { fast++; });
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 100; i++) {
+		stream.onNext(i);
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	ASSERT_EQ(fast, 100) << "The inline subscriber got everything right away.\n";
+	ASSERT_LT(elapsed, 50ms) << "The producer did not wait for the slow subscriber.\n";
+	ASSERT_TRUE(waitFor([&slow]() { return slow == 100; }, 10s));
+}
+
+TEST(TestExecutors, testObserveOnInline) {
+	StreamResult<int> stream;
+	std::vector<int> received;
+	stream.observeOn(InlineExecutor::instance()).subscribe([&received](int i) { received.push_back(i); });
+	for (int i = 0; i < 3; i++) {
+		stream.onNext(i);
+	}
+	ASSERT_EQ(received, (std::vector<int>{ 0, 1, 2 })) << "Inline delivery happens right away.\n";
+}
\ No newline at end of file
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/exceptions/SimException.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+
+#include "FakeConnection.h"
+
+
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimConnect;
+
+TEST(TestFakeSimulator, testOpen) {
+	auto fake = std::make_shared<FakeSimulator>("Fake Sim");
+	auto& sim = SimConnect::Builder()
+		.withName("TestFakeSimulator.testOpen")
+		.withBackend(fake)
+		.startStopped()
+		.build();
+
+	std::string appName;
+	sim.onOpen([&appName](auto const& appInfo) { appName = appInfo.appName; });
+
+	ASSERT_TRUE(sim.connect()) << "Connecting to the fake simulator always succeeds.\n";
+	ASSERT_TRUE(sim.connected());
+	ASSERT_EQ(fake->clientName(), "TestFakeSimulator.testOpen");
+	ASSERT_EQ(appName, "Fake Sim") << "The OPEN message is dispatched when connecting.\n";
+
+	sim.disconnect();
+	ASSERT_FALSE(sim.connected());
+}
+
+TEST(TestFakeSimulator, testReopen) {
+	FakeSimulator fake;
+	ASSERT_EQ(fake.open("TestFakeSimulator.testReopen"), S_OK);
+
+	SIMCONNECT_RECV frame{ sizeof(SIMCONNECT_RECV), FakeSimulator::protocolVersion, SIMCONNECT_RECV_ID_EVENT_FRAME };
+	fake.post(frame);
+
+	SIMCONNECT_RECV* msgPtr;
+	DWORD msgLen;
+	ASSERT_EQ(fake.getNextDispatch(&msgPtr, &msgLen), S_OK);
+	ASSERT_EQ(msgPtr->dwID, SIMCONNECT_RECV_ID_OPEN);
+
+	// The frame event is still waiting to be dispatched when the connection closes.
+	ASSERT_EQ(fake.close(), S_OK);
+	ASSERT_EQ(fake.open("TestFakeSimulator.testReopen"), S_OK);
+
+	ASSERT_EQ(fake.getNextDispatch(&msgPtr, &msgLen), S_OK);
+	ASSERT_EQ(msgPtr->dwID, SIMCONNECT_RECV_ID_OPEN) << "A new connection starts with its own OPEN message.\n";
+	ASSERT_NE(fake.getNextDispatch(&msgPtr, &msgLen), S_OK) << "Nothing from the previous connection is dispatched.\n";
+
+	fake.close();
+}
+
+TEST(TestFakeSimulator, testSystemState) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg")
+		.withBoolState("Sim", true)
+		.withBoolState("DialogMode", false);
+
+	auto& sim = connectTo("TestFakeSimulator.testSystemState", fake);
+	ASSERT_TRUE(sim.connected());
+
+	ASSERT_EQ(sim.currentAircraftAirFile(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	ASSERT_TRUE(sim.isUserFlying());
+	ASSERT_FALSE(sim.isSimInDialogMode());
+	ASSERT_EQ(fake->requestsReceived(), 3);
+
+	sim.stop();
+}
+
+TEST(TestFakeSimulator, testUnknownSystemState) {
+	auto fake = std::make_shared<FakeSimulator>();
+
+	auto& sim = connectTo("TestFakeSimulator.testUnknownSystemState", fake);
+	ASSERT_TRUE(sim.connected());
+
+	try {
+		sim.currentFlightPlan();
+		FAIL() << "Requesting an unknown state should fail.\n";
+	}
+	catch (const CppSimConnect::SimException& e) {
+		ASSERT_EQ(e.exceptionId(), SIMCONNECT_EXCEPTION_NAME_UNRECOGNIZED);
+	}
+	ASSERT_EQ(sim.exceptionStats().matched, 1) << "The exception is correlated with the request.\n";
+	ASSERT_EQ(sim.exceptionStats().unmatched, 0);
+
+	sim.stop();
+}
+
+
+TEST(TestFakeSimulator, testSystemStates) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg")
+		.withStringState("FlightLoaded", "Test.FLT")
+		.withBoolState("Sim", true);
+
+	auto& sim = connectTo("TestFakeSimulator.testSystemStates", fake);
+	ASSERT_TRUE(sim.connected());
+
+	using CppSimConnect::SystemState;
+	auto states = sim.requestSystemStates({ SystemState::AircraftLoaded, SystemState::FlightLoaded, SystemState::FlightPlan, SystemState::Sim }).get();
+
+	ASSERT_EQ(fake->requestsReceived(), 4);
+	ASSERT_EQ(states.aircraftLoaded, "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	ASSERT_EQ(states.flightLoaded, "Test.FLT");
+	ASSERT_EQ(states.sim, true);
+	ASSERT_FALSE(states.dialogMode.has_value()) << "States that were not requested stay empty.\n";
+	ASSERT_FALSE(states.flightPlan.has_value()) << "States that failed stay empty.\n";
+	ASSERT_NE(states.error(SystemState::FlightPlan), nullptr) << "The exception is kept with the result.\n";
+	ASSERT_EQ(states.error(SystemState::AircraftLoaded), nullptr);
+
+	auto unknown = sim.requestSystemStates({ SystemState::Sim, static_cast<SystemState>(99) });
+	ASSERT_THROW(unknown.get(), std::invalid_argument) << "A state that doesn't exist fails the whole result.\n";
+
+	sim.stop();
+}
+
+TEST(TestFakeSimulator, testCoalescedSystemStates) {
+	constexpr unsigned threads{ 16 };
+	constexpr unsigned callsPerThread{ 200 };
+
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+
+	auto& sim = connectTo("TestFakeSimulator.testCoalescedSystemStates", fake, [](SimConnect::Builder& builder) { builder.withoutSystemStateCache(); });
+	ASSERT_TRUE(sim.connected());
+
+	std::atomic<unsigned> correct{ 0 };
+	{
+		std::vector<std::jthread> callers;
+		for (unsigned t = 0; t < threads; t++) {
+			callers.emplace_back([&sim, &correct]() {
+				for (unsigned i = 0; i < callsPerThread; i++) {
+					if (sim.currentAircraftAirFile() == "SimObjects\\Airplanes\\Test\\aircraft.cfg") {
+						correct++;
+					}
+				}
+			});
+		}
+	}
+	auto stats = sim.requestStats();
+	std::cout << "Coalescing: " << threads * callsPerThread << " calls, " << stats.systemStatesSent << " sent, " << stats.systemStatesCoalesced << " coalesced.\n";
+
+	ASSERT_EQ(correct, threads * callsPerThread) << "Every caller gets the value.\n";
+	ASSERT_EQ(stats.systemStatesSent + stats.systemStatesCoalesced, threads * callsPerThread);
+	ASSERT_EQ(fake->requestsReceived(), stats.systemStatesSent) << "Only the leaders were sent.\n";
+	ASSERT_LT(stats.systemStatesSent, threads * callsPerThread) << "Concurrent callers share requests.\n";
+
+	sim.stop();
+}
+
+TEST(TestFakeSimulator, testCachedSystemStates) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg")
+		.withStringState("FlightPlan", "Test.PLN");
+
+	auto& sim = connectTo("TestFakeSimulator.testCachedSystemStates", fake);
+	ASSERT_TRUE(sim.connected());
+
+	waitFor([&fake]() { return fake->systemEventSubscriptions() >= 5; });
+	ASSERT_EQ(fake->systemEventSubscriptions(), 5);
+
+	ASSERT_EQ(sim.currentAircraftAirFile(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	ASSERT_EQ(sim.currentAircraftAirFile(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	ASSERT_EQ(fake->requestsReceived(), 1) << "The second read comes from the cache.\n";
+	ASSERT_EQ(sim.requestStats().systemStatesCached, 1);
+
+	// The event carries the new value, so no request is needed.
+	fake->fireSystemEvent("AircraftLoaded", std::string_view("SimObjects\\Airplanes\\Other\\aircraft.cfg"));
+	waitFor([&sim]() { return sim.currentAircraftAirFile() == "SimObjects\\Airplanes\\Other\\aircraft.cfg"; });
+	ASSERT_EQ(sim.currentAircraftAirFile(), "SimObjects\\Airplanes\\Other\\aircraft.cfg");
+	ASSERT_EQ(fake->requestsReceived(), 1);
+
+	// Deactivating the flightplan only invalidates it, so the next read asks again.
+	ASSERT_EQ(sim.currentFlightPlan(), "Test.PLN");
+	ASSERT_EQ(fake->requestsReceived(), 2);
+	fake->withStringState("FlightPlan", "");
+	fake->fireSystemEvent("FlightPlanDeactivated");
+	waitFor([&sim]() { return sim.currentFlightPlan() == ""; });
+	ASSERT_EQ(sim.currentFlightPlan(), "");
+	ASSERT_GE(fake->requestsReceived(), 3);
+
+	sim.stop();
+}
+
+TEST(TestFakeSimulator, testSubscribeAfterCachedRequest) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+
+	auto& sim = connectTo("TestFakeSimulator.testSubscribeAfterCachedRequest", fake);
+	ASSERT_TRUE(sim.connected());
+
+	ASSERT_EQ(sim.currentAircraftAirFile(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	ASSERT_EQ(sim.requestStats().systemStatesCached, 0);
+
+	std::string value;
+	unsigned calls{ 0 };
+	sim.requestAircraftLoaded().subscribe([&value, &calls](const std::string& aircraft) { value = aircraft; calls++; });
+	ASSERT_EQ(sim.requestStats().systemStatesCached, 1) << "The second request comes from the cache.\n";
+	ASSERT_EQ(calls, 1) << "A subscriber added after the cached value was delivered still gets it, once.\n";
+	ASSERT_EQ(value, "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+
+	sim.stop();
+}
+
+// With event-driven dispatch the reply often arrives before the caller gets to subscribe.
+TEST(TestFakeSimulator, testSubscribeAfterRequest) {
+	constexpr unsigned requests{ 100 };
+
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withBoolState("Sim", true);
+
+	auto& sim = SimConnect::Builder()
+		.withName("TestFakeSimulator.testSubscribeAfterRequest")
+		.withBackend(fake)
+		.withEventDrivenDispatch()
+		.withoutSystemStateCache()
+		.withAutoConnect()
+		.startRunning()
+		.build();
+	waitFor([&sim]() { return sim.connected(); });
+	ASSERT_TRUE(sim.connected());
+	ASSERT_TRUE(sim.eventDrivenDispatch());
+
+	std::atomic<unsigned> calls{ 0 };
+	for (unsigned i = 0; i < requests; i++) {
+		auto result = sim.requestUserFlying();
+		result.subscribe([&calls](bool flying) { if (flying) { calls++; } });
+		ASSERT_TRUE(result.get());
+	}
+	waitFor([&calls]() { return calls >= requests; });
+	ASSERT_EQ(calls, requests) << "Every subscriber gets the value, whether or not the reply was already there.\n";
+	ASSERT_EQ(fake->requestsReceived(), requests);
+
+	sim.stop();
+}
+
+TEST(TestFakeSimulator, testQueuedAtDisconnect) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withBoolState("Sim", true);
+
+	// Without a running dispatcher nothing is sent, so the request is still queued when we disconnect.
+	auto& sim = SimConnect::Builder()
+		.withName("TestFakeSimulator.testQueuedAtDisconnect")
+		.withBackend(fake)
+		.withoutSystemStateCache()
+		.startStopped()
+		.build();
+	ASSERT_TRUE(sim.connect());
+
+	auto result = sim.requestUserFlying();
+	sim.disconnect();
+	ASSERT_TRUE(result.completed()) << "A call that can no longer be sent fails.\n";
+	try {
+		result.get();
+		FAIL() << "The request was never sent, so there is no value.\n";
+	}
+	catch (const CppSimConnect::SimException& e) {
+		ASSERT_EQ(e.exceptionId(), SIMCONNECT_EXCEPTION_ERROR);
+	}
+	ASSERT_EQ(fake->requestsReceived(), 0);
+}
+
+TEST(TestFakeSimulator, testMessageStats) {
+	auto fake = std::make_shared<FakeSimulator>();
+	auto& sim = connectTo("TestFakeSimulator.testMessageStats", fake);
+	ASSERT_TRUE(sim.connected());
+
+	SIMCONNECT_RECV frame{ sizeof(SIMCONNECT_RECV), FakeSimulator::protocolVersion, SIMCONNECT_RECV_ID_EVENT_FRAME };
+	fake->post(frame);
+	fake->post(frame);
+
+	SIMCONNECT_RECV_SYSTEM_STATE truncated{};
+	truncated.dwSize = sizeof(SIMCONNECT_RECV) + sizeof(DWORD);
+	truncated.dwID = SIMCONNECT_RECV_ID_SYSTEM_STATE;
+	fake->post(truncated);
+
+	SIMCONNECT_RECV beyond{ sizeof(SIMCONNECT_RECV), FakeSimulator::protocolVersion, 1000 };
+	fake->post(beyond);
+
+	waitFor([&sim]() { return sim.messageStats().unhandled >= 3; });
+	auto stats = sim.messageStats();
+	ASSERT_EQ(stats.received[SIMCONNECT_RECV_ID_OPEN], 1);
+	ASSERT_EQ(stats.received[SIMCONNECT_RECV_ID_EVENT_FRAME], 2);
+	ASSERT_EQ(stats.received[SIMCONNECT_RECV_ID_SYSTEM_STATE], 1);
+	ASSERT_EQ(stats.unhandled, 3) << "Two frame events without a handler, and one type beyond the table.\n";
+	ASSERT_EQ(stats.undersized, 1) << "The truncated system state is not handled.\n";
+
+	sim.stop();
+}
+
+TEST(TestFakeSimulator, testSizeBeyondMessage) {
+	auto fake = std::make_shared<FakeSimulator>();
+	auto& sim = connectTo("TestFakeSimulator.testSizeBeyondMessage", fake);
+	ASSERT_TRUE(sim.connected());
+
+	// The header claims data that was never delivered, so reading up to dwSize would run past the buffer.
+	SIMCONNECT_RECV_SIMOBJECT_DATA data{};
+	data.dwSize = sizeof(data) + 64;
+	data.dwVersion = FakeSimulator::protocolVersion;
+	data.dwID = SIMCONNECT_RECV_ID_SIMOBJECT_DATA;
+	fake->post(data, sizeof(data));
+
+	waitFor([&sim]() { return sim.messageStats().undersized >= 1; });
+	auto stats = sim.messageStats();
+	ASSERT_EQ(stats.received[SIMCONNECT_RECV_ID_SIMOBJECT_DATA], 1);
+	ASSERT_EQ(stats.undersized, 1) << "A message shorter than its dwSize is not handled.\n";
+
+	sim.stop();
+}
\ No newline at end of file
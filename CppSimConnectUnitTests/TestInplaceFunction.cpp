@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <array>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "../CppSimConnect/reactive/Callbacks.h"
+#include "../CppSimConnect/reactive/InplaceFunction.h"
+#include "../CppSimConnect/reactive/MessageResult.h"
+
+#include "AllocationCounter.h"
+
+
+// Count heap allocations per thread, so we can check a block of code doesn't allocate.
+static thread_local size_t allocations{ 0 };
+
+void* operator new(size_t size) {
+	allocations++;
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+size_t heapAllocations() noexcept { return allocations; }
+
+
+using CppSimConnect::InplaceFunction;
+
+TEST(TestInplaceFunction, testInline) {
+	int total{ 0 };
+	auto shared = std::make_shared<int>(2);
+
+	size_t count = allocationsIn([&]() {
+		InplaceFunction<void(int)> fn([&total, shared](int i) { total += i * *shared; });
+		InplaceFunction<void(int)> moved(std::move(fn));
+		ASSERT_FALSE(fn);
+		ASSERT_TRUE(moved);
+		moved(3);
+	});
+	ASSERT_EQ(total, 6);
+	ASSERT_EQ(count, 0) << "A lambda capturing a reference and a shared_ptr is stored inline.\n";
+}
+
+TEST(TestInplaceFunction, testMoveOnly) {
+	auto value = std::make_unique<std::string>("move-only");
+	InplaceFunction<std::string()> fn([value = std::move(value)]() { return *value; });
+
+	ASSERT_EQ(fn(), "move-only");
+}
+
+TEST(TestInplaceFunction, testLarge) {
+	std::array<char, 2 * CppSimConnect::defaultInplaceCapacity> big{};
+	big[0] = 'x';
+
+	InplaceFunction<char()> fn;
+	size_t count = allocationsIn([&]() { fn = [big]() { return big[0]; }; });
+	ASSERT_EQ(count, 1) << "Callables larger than the capacity are allocated.\n";
+	ASSERT_EQ(fn(), 'x');
+
+	InplaceFunction<char(), sizeof(big)> bigger;
+	count = allocationsIn([&]() { bigger = [big]() { return big[0]; }; });
+	ASSERT_EQ(count, 0) << "The capacity can be raised.\n";
+	ASSERT_EQ(bigger(), 'x');
+}
+
+TEST(TestInplaceFunction, testEmpty) {
+	InplaceFunction<void()> fn;
+	ASSERT_FALSE(fn);
+	ASSERT_THROW(fn(), std::bad_function_call);
+}
+
+static int twice(int i) { return 2 * i; }
+
+TEST(TestInplaceFunction, testEmptyCallables) {
+	int (*nothing)(int) = nullptr;
+	InplaceFunction<int(int)> fromNull(nothing);
+	ASSERT_FALSE(fromNull) << "A null function pointer gives an empty function.\n";
+	ASSERT_THROW(fromNull(1), std::bad_function_call);
+
+	InplaceFunction<int(int)> fromEmpty(std::function<int(int)>{});
+	ASSERT_FALSE(fromEmpty) << "An empty std::function gives an empty function.\n";
+	ASSERT_THROW(fromEmpty(1), std::bad_function_call);
+
+	InplaceFunction<int(int)> fromPointer(&twice);
+	ASSERT_TRUE(fromPointer);
+	ASSERT_EQ(fromPointer(3), 6);
+
+	InplaceFunction<int(int)> fromFunction{ std::function<int(int)>(&twice) };
+	ASSERT_TRUE(fromFunction);
+	ASSERT_EQ(fromFunction(4), 8);
+}
+
+TEST(TestInplaceFunction, testCallbackListAllocations) {
+	CppSimConnect::CallbackList<int> callbacks;
+	int total{ 0 };
+
+	size_t count = allocationsIn([&]() {
+		callbacks.add([&total](int i) { total += i; });
+		callbacks(1);
+	});
+	ASSERT_EQ(count, 0) << "Adding a first callback doesn't allocate.\n";
+	ASSERT_EQ(total, 1);
+
+	callbacks.reserve(4);
+	count = allocationsIn([&]() {
+		callbacks.add([&total](int i) { total += 2 * i; });
+		callbacks.add([&total](int i) { total += 3 * i; });
+		callbacks(1);
+	});
+	ASSERT_EQ(count, 0) << "Adding reserved callbacks doesn't allocate.\n";
+	ASSERT_EQ(total, 7);
+}
+
+// Streams publish a new subscriber list when one is added, so they are checked with a single result instead.
+TEST(TestInplaceFunction, testSubscribeAllocations) {
+	CppSimConnect::Reactive::MessageResult<int> source;
+	CppSimConnect::Reactive::MessageResult<int> result;
+	bool done{ false };
+
+	size_t count = allocationsIn([&]() {
+		source.subscribe([result](int i) { result.onNext(i); },
+						 [result](std::exception_ptr err) { result.onError(err); },
+						 [&done]() { done = true; });
+	});
+	ASSERT_EQ(count, 0) << "Subscribing typical lambdas doesn't allocate.\n";
+
+	source.onNext(42);
+	ASSERT_EQ(result.get(), 42);
+	ASSERT_TRUE(done);
+}
\ No newline at end of file
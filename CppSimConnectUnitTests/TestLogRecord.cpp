@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../CppSimConnect/BinaryLog.h"
+#include "../CppSimConnect/LogRecord.h"
+
+
+using CppSimConnect::BinaryLogReader;
+using CppSimConnect::BinaryLogWriter;
+using CppSimConnect::Logger;
+using CppSimConnect::LogLevel;
+using CppSimConnect::LogRecord;
+using CppSimConnect::LogRecordSink;
+using CppSimConnect::LogSink;
+
+template <typename... Targs>
+static std::string captureAndFormat(const char* format, const Targs&... args) {
+	LogRecord record;
+	EXPECT_TRUE(record.capture(LogLevel::Info, format, args...));
+	return record.formatted();
+}
+
+TEST(TestLogRecord, testFormatting) {
+	const std::string name{ "AircraftLoaded" };
+
+	ASSERT_EQ(captureAndFormat("No arguments"), "No arguments");
+	ASSERT_EQ(captureAndFormat("{} {} {} {}", 42, -7, true, 'x'), "42 -7 true x");
+	ASSERT_EQ(captureAndFormat("{} and {}", 0.1f, 2.5), "0.1 and 2.5");
+	ASSERT_EQ(captureAndFormat("State '{}' via {}", name, "literal"), "State 'AircraftLoaded' via literal");
+	ASSERT_EQ(captureAndFormat("{:x} {:>4} {:.2f}", 255u, 7, 3.14159), "ff    7 3.14");
+	ASSERT_EQ(captureAndFormat("{1} before {0}", 1, 2), "2 before 1");
+	ASSERT_EQ(captureAndFormat("{{literal}} {}", 1), "{literal} 1");
+	ASSERT_EQ(captureAndFormat("{} {}", 1), "1 {}") << "Missing arguments leave the field.\n";
+}
+
+TEST(TestLogRecord, testCaptureLimits) {
+	LogRecord record;
+	ASSERT_FALSE(record.capture(LogLevel::Info, "{}", std::string(LogRecord::dataSize, 'x'))) << "Arguments must fit.\n";
+	ASSERT_TRUE(record.capture(LogLevel::Info, "{}", std::string(LogRecord::dataSize - 2, 'x')));
+
+	record.setText(LogLevel::Warn, std::string(1000, 'y'));
+	ASSERT_TRUE(record.preformatted());
+	ASSERT_EQ(record.formatted(), std::string(LogRecord::dataSize, 'y')) << "Text is truncated.\n";
+}
+
+TEST(TestLogRecord, testLoggerDefersFormatting) {
+	std::vector<std::string> lines;
+	std::vector<LogRecord> records;
+	LogSink sink{ [&lines](LogLevel, const std::string& msg) { lines.push_back(msg); } };
+	LogRecordSink recordSink{ [&records](const LogRecord& record) { records.push_back(record); } };
+	Logger logger("TestLogRecord", sink, LogLevel::Debug, &recordSink);
+
+	const std::string name{ "Sim" };
+	logger.debug("RequestID {} for '{}'", 17u, name);
+	logger.trace("Below the threshold {}", 1);
+	logger.info("Plain message");
+	logger.info("{}", std::vector<int>{ 1, 2 }.size());
+	logger.info("Took {}", std::chrono::seconds(3));
+
+	ASSERT_EQ(records.size(), 2);
+	ASSERT_EQ(records[0].level, LogLevel::Debug);
+	ASSERT_FALSE(records[0].preformatted());
+	ASSERT_EQ(records[0].formatted(), "RequestID 17 for 'Sim'");
+	ASSERT_EQ(records[1].formatted(), "2");
+	ASSERT_EQ(lines, (std::vector<std::string>{ "Plain message", "Took 3s" })) << "Plain strings and arguments that can't be captured go straight to the sink.\n";
+}
+
+TEST(TestLogRecord, testBinaryLogRoundTrip) {
+	const auto file{ std::filesystem::temp_directory_path() / "TestLogRecord.bin" };
+	{
+		BinaryLogWriter writer(file);
+		LogRecord record;
+		for (int i = 0; i < 3; i++) {
+			record.capture(LogLevel::Debug, "Message {} of {}", i, "three");
+			writer.write(record);
+		}
+		record.setText(LogLevel::Error, "Preformatted");
+		writer.write(record);
+	}
+
+	BinaryLogReader reader(file);
+	std::vector<std::string> lines;
+	LogRecord record;
+	while (reader.next(record)) {
+		lines.push_back(record.formatted());
+	}
+	ASSERT_EQ(lines, (std::vector<std::string>{ "Message 0 of three", "Message 1 of three", "Message 2 of three", "Preformatted" }));
+	ASSERT_EQ(record.level, LogLevel::Error);
+
+	std::filesystem::remove(file);
+	ASSERT_THROW(BinaryLogReader{ file }, std::runtime_error);
+}
+
+TEST(TestLogRecord, testBinaryLogByteOrder) {
+	const auto file{ std::filesystem::temp_directory_path() / "TestLogRecord.testBinaryLogByteOrder.bin" };
+	{
+		// The header of a log written on a machine with the other byte order.
+		auto swap = [](std::uint16_t value) { return static_cast<std::uint16_t>((value << 8) | (value >> 8)); };
+		const std::uint16_t swapped[]{ swap(BinaryLogWriter::version), swap(BinaryLogWriter::byteOrderMark) };
+		std::ofstream out(file, std::ios::binary | std::ios::trunc);
+		out.write(BinaryLogWriter::magic, sizeof(BinaryLogWriter::magic));
+		out.write(reinterpret_cast<const char*>(swapped), sizeof(swapped));
+	}
+	ASSERT_THROW(BinaryLogReader{ file }, std::runtime_error) << "Numbers in the other byte order can't be decoded.\n";
+
+	std::filesystem::remove(file);
+}
+
+TEST(TestLogRecord, testDecodeBinaryLog) {
+	const auto file{ std::filesystem::temp_directory_path() / "TestLogRecord.testDecodeBinaryLog.bin" };
+	{
+		BinaryLogWriter writer(file);
+		LogRecord record;
+		record.capture(LogLevel::Info, "Connected to {} version {}", "Fake Sim", 11);
+		writer.write(record);
+		record.capture(LogLevel::Debug, "{:>6.2f} ft", 2.5);
+		writer.write(record);
+		record.setText(LogLevel::Error, "Preformatted");
+		writer.write(record);
+	}
+
+	auto decode = [&file](LogLevel threshold) {
+		BinaryLogReader reader(file);
+		std::ostringstream out;
+		CppSimConnect::decodeBinaryLog(reader, out, threshold);
+
+		std::vector<std::string> lines;
+		std::istringstream in(out.str());
+		for (std::string line; std::getline(in, line);) {
+			lines.push_back(line.substr(line.find(' ', line.find(' ') + 1) + 1));		// Skip the date and time
+		}
+		return lines;
+	};
+	ASSERT_EQ(decode(LogLevel::Trace), (std::vector<std::string>{
+		"INFO  Connected to Fake Sim version 11", "DEBUG   2.50 ft", "ERROR Preformatted" }));
+	ASSERT_EQ(decode(LogLevel::Info), (std::vector<std::string>{
+		"INFO  Connected to Fake Sim version 11", "ERROR Preformatted" })) << "Records below the threshold are left out.\n";
+
+	LogLevel level{ LogLevel::Trace };
+	ASSERT_TRUE(CppSimConnect::parseLogLevel("WARN", level));
+	ASSERT_EQ(level, LogLevel::Warn);
+	ASSERT_FALSE(CppSimConnect::parseLogLevel("Warning", level));
+
+	std::filesystem::remove(file);
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string>
+#include <thread>
+
+#include "../CppSimConnect/sim/FakeSimulator.h"
+#include "../CppSimConnect/sim/RecvViews.h"
+
+#include "AllocationCounter.h"
+
+
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::SimConnect;
+using CppSimConnect::messages::AppInfoView;
+using CppSimConnect::messages::SystemStateView;
+using CppSimConnect::messages::textView;
+
+
+TEST(TestMessageViews, testTextView) {
+	char terminated[8]{ "abc" };
+	ASSERT_EQ(textView(terminated), "abc");
+
+	char full[4]{ 'a', 'b', 'c', 'd' };
+	ASSERT_EQ(textView(full), "abcd") << "A full array without terminator is read up to its end.\n";
+}
+
+TEST(TestMessageViews, testAppInfoView) {
+	SIMCONNECT_RECV_OPEN msg{};
+	std::strcpy(msg.szApplicationName, "Fake Sim");
+	msg.dwApplicationVersionMajor = 11;
+	msg.dwApplicationBuildMinor = 282174;
+	msg.dwSimConnectVersionMajor = 11;
+
+	AppInfoView view{};
+	size_t count = allocationsIn([&]() { view = CppSimConnect::appInfoView(msg); });
+	ASSERT_EQ(count, 0) << "Taking a view allocates nothing.\n";
+	ASSERT_EQ(view.appName, "Fake Sim");
+	ASSERT_EQ(view.appName.data(), msg.szApplicationName) << "The view points into the message.\n";
+
+	auto info = view.materialize();
+	ASSERT_EQ(info.appName, "Fake Sim");
+	ASSERT_EQ(info.appVersionMajor, "11");
+	ASSERT_EQ(info.appBuildMinor, "282174");
+	ASSERT_EQ(info.scVersionMajor, "11");
+}
+
+TEST(TestMessageViews, testSystemStateView) {
+	SIMCONNECT_RECV_SYSTEM_STATE msg{};
+	msg.dwInteger = 1;
+	std::strcpy(msg.szString, "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+
+	SystemStateView view{};
+	size_t count = allocationsIn([&]() { view = CppSimConnect::systemStateView(msg); });
+	ASSERT_EQ(count, 0);
+	ASSERT_TRUE(view.boolean());
+	ASSERT_EQ(view.string, "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	ASSERT_EQ(view.materialize(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+}
+
+TEST(TestMessageViews, testSimObjectDataView) {
+	constexpr size_t header{ CppSimConnect::simObjectDataHeaderSize };
+	alignas(SIMCONNECT_RECV_SIMOBJECT_DATA) std::byte buffer[header + 12]{};
+	auto& msg{ *reinterpret_cast<SIMCONNECT_RECV_SIMOBJECT_DATA*>(buffer) };
+	msg.dwSize = sizeof(buffer);
+	msg.dwID = SIMCONNECT_RECV_ID_SIMOBJECT_DATA;
+
+	auto data = CppSimConnect::simObjectDataView(msg);
+	ASSERT_EQ(data.data(), buffer + header) << "The view points into the message.\n";
+	ASSERT_EQ(data.size(), 12) << "The view ends where dwSize says the message ends.\n";
+
+	msg.dwSize = header - 1;
+	ASSERT_TRUE(CppSimConnect::simObjectDataView(msg).empty()) << "A message too short for its header has no data.\n";
+}
+
+TEST(TestMessageViews, testViewCallbacks) {
+	auto fake = std::make_shared<FakeSimulator>("Fake Sim");
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+
+	auto& sim = SimConnect::Builder()
+		.withName("TestMessageViews.testViewCallbacks")
+		.withBackend(fake)
+		.startStopped()
+		.build();
+
+	std::string viewName;
+	std::string appName;
+	sim.onOpenView([&viewName](AppInfoView const& appInfo) { viewName = appInfo.appName; });
+	sim.onOpen([&appName](auto const& appInfo) { appName = appInfo.appName; });
+	ASSERT_TRUE(sim.connect());
+	ASSERT_EQ(viewName, "Fake Sim");
+	ASSERT_EQ(appName, "Fake Sim") << "Materialized handlers still get their copy.\n";
+
+	sim.start();
+	std::promise<std::string> aircraft;
+	sim.requestSystemState(CppSimConnect::SystemState::AircraftLoaded,
+		[&aircraft](SystemStateView const& view) { aircraft.set_value(view.materialize()); },
+		[&aircraft](std::exception_ptr err) { aircraft.set_exception(err); });
+
+	auto future = aircraft.get_future();
+	ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+	ASSERT_EQ(future.get(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+
+	sim.stop();
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/reactive/StreamResult.h"
+#include "../CppSimConnect/reactive/TimerQueue.h"
+
+#include "AllocationCounter.h"
+#include "WaitFor.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::Reactive::StreamResult;
+using CppSimConnect::Reactive::TimerQueue;
+
+// Collects values that may arrive on the timer thread.
+template <typename T>
+class Collector {
+	mutable std::mutex _lock;
+	std::vector<T> _values;
+	bool _completed{ false };
+
+public:
+	inline void add(const T& value) { std::lock_guard<std::mutex> lock(_lock); _values.push_back(value); }
+	inline void complete() { std::lock_guard<std::mutex> lock(_lock); _completed = true; }
+
+	inline std::vector<T> values() const { std::lock_guard<std::mutex> lock(_lock); return _values; }
+	inline bool completed() const { std::lock_guard<std::mutex> lock(_lock); return _completed; }
+
+	bool waitFor(size_t count) const {
+		return ::waitFor([this, count]() { return values().size() >= count; });
+	}
+};
+
+TEST(TestOperators, testThrottle) {
+	StreamResult<int> stream;
+	std::vector<int> received;
+	stream.throttle(1h).subscribe([&received](int i) { received.push_back(i); });
+	for (int i = 0; i < 10; i++) {
+		stream.onNext(i);
+	}
+	ASSERT_EQ(received, (std::vector<int>{ 0 })) << "Only the first value in a period passes.\n";
+
+	StreamResult<int> unthrottled;
+	received.clear();
+	unthrottled.throttle(0ms).subscribe([&received](int i) { received.push_back(i); });
+	for (int i = 0; i < 3; i++) {
+		unthrottled.onNext(i);
+	}
+	ASSERT_EQ(received, (std::vector<int>{ 0, 1, 2 }));
+}
+
+TEST(TestOperators, testDistinctUntilChanged) {
+	StreamResult<std::string> stream;
+	std::vector<std::string> received;
+	stream.distinctUntilChanged().subscribe([&received](const std::string& s) { received.push_back(s); });
+	for (auto s : { "a", "a", "b", "b", "a" }) {
+		stream.onNext(s);
+	}
+	ASSERT_EQ(received, (std::vector<std::string>{ "a", "b", "a" }));
+}
+
+TEST(TestOperators, testDistinctWithEpsilon) {
+	StreamResult<double> altitude;
+	std::vector<double> received;
+	altitude.distinctUntilChanged(0.5).subscribe([&received](double d) { received.push_back(d); });
+	for (double d : { 1000.0, 1000.1, 999.8, 1000.4, 1000.6, 1000.7, 1001.2 }) {
+		altitude.onNext(d);
+	}
+	ASSERT_EQ(received, (std::vector<double>{ 1000.0, 1000.6, 1001.2 })) << "Jitter is ignored, but drift is not.\n";
+}
+
+TEST(TestOperators, testConnectWhileDelivering) {
+	constexpr size_t operators{ 50 };
+	StreamResult<int> stream;
+	std::vector<Collector<int>> received(operators);
+
+	std::atomic_bool producing{ true };
+	std::jthread producer([&stream, &producing]() {
+		for (int i = 0; producing; i++) {
+			stream.onNext(i);
+		}
+	});
+	for (auto& collector : received) {
+		stream.distinctUntilChanged().subscribe([&collector](int i) { collector.add(i); });
+		ASSERT_TRUE(collector.waitFor(1)) << "An operator connected to a live stream receives the values that follow.\n";
+	}
+	producing = false;
+	producer.join();
+
+	ASSERT_EQ(stream.subscribers(), operators);
+}
+
+TEST(TestOperators, testBufferByCount) {
+	StreamResult<int> stream;
+	std::vector<std::vector<int>> received;
+	bool completed{ false };
+	stream.buffer(3).subscribe([&received](const std::vector<int>& batch) { received.push_back(batch); }, [&completed]() { completed = true; });
+	for (int i = 0; i < 7; i++) {
+		stream.onNext(i);
+	}
+	ASSERT_EQ(received, (std::vector<std::vector<int>>{ { 0, 1, 2 }, { 3, 4, 5 } }));
+
+	stream.onCompleted();
+	ASSERT_EQ(received.back(), (std::vector<int>{ 6 })) << "Completion passes on the partial batch.\n";
+	ASSERT_TRUE(completed);
+}
+
+TEST(TestOperators, testBufferByTime) {
+	TimerQueue timers;
+	StreamResult<int> stream;
+	Collector<std::vector<int>> batches;
+	stream.buffer(10ms, timers).subscribe([&batches](const std::vector<int>& batch) { batches.add(batch); });
+
+	for (int i = 0; i < 5; i++) {
+		stream.onNext(i);
+	}
+	ASSERT_TRUE(batches.waitFor(1));
+	std::vector<int> all;
+	for (auto const& batch : batches.values()) {
+		all.insert(all.end(), batch.begin(), batch.end());
+	}
+	ASSERT_EQ(all, (std::vector<int>{ 0, 1, 2, 3, 4 }));
+}
+
+TEST(TestOperators, testSample) {
+	TimerQueue timers;
+	StreamResult<int> stream;
+	Collector<int> samples;
+	stream.sample(10ms, timers).subscribe([&samples](int i) { samples.add(i); });
+
+	for (int i = 0; i < 100; i++) {
+		stream.onNext(i);
+	}
+	ASSERT_TRUE(samples.waitFor(1));
+	ASSERT_EQ(samples.values().front(), 99) << "The sample is the latest value.\n";
+
+	std::this_thread::sleep_for(30ms);
+	ASSERT_EQ(samples.values().size(), 1) << "Without new values nothing is sampled.\n";
+}
+
+TEST(TestOperators, testTimersStopWhenUnwatched) {
+	TimerQueue timers;
+	StreamResult<int> stream;
+	auto sampled = stream.sample(5ms, timers);
+	auto batched = stream.buffer(5ms, timers);
+	ASSERT_TRUE(waitFor([&timers]() { return timers.pending() == 0; })) << "Without subscribers the timers stop.\n";
+
+	Collector<int> samples;
+	sampled.subscribe([&samples](int i) { samples.add(i); });
+	stream.onNext(1);
+	ASSERT_EQ(timers.pending(), 2) << "A new value starts them again.\n";
+	ASSERT_TRUE(samples.waitFor(1));
+	ASSERT_EQ(samples.values().front(), 1);
+
+	sampled.onCompleted();
+	ASSERT_TRUE(waitFor([&timers]() { return timers.pending() == 0; })) << "Nor do they run for a completed downstream.\n";
+	stream.onNext(2);
+	std::this_thread::sleep_for(20ms);
+	ASSERT_EQ(timers.pending(), 0) << "The sampler stays stopped, and the buffer has no subscribers.\n";
+}
+
+TEST(TestOperators, testDebounce) {
+	TimerQueue timers;
+	StreamResult<int> stream;
+	Collector<int> settled;
+	stream.debounce(20ms, timers).subscribe([&settled](int i) { settled.add(i); }, [&settled]() { settled.complete(); });
+
+	for (int i = 0; i < 10; i++) {
+		stream.onNext(i);
+	}
+	ASSERT_TRUE(settled.waitFor(1));
+	ASSERT_EQ(settled.values(), (std::vector<int>{ 9 })) << "Only the value that settled passes.\n";
+
+	stream.onNext(10);
+	stream.onCompleted();
+	ASSERT_EQ(settled.values(), (std::vector<int>{ 9, 10 })) << "Completion flushes the pending value.\n";
+	ASSERT_TRUE(settled.completed());
+}
+
+TEST(TestOperators, testSteadyStateAllocations) {
+	StreamResult<double> stream;
+	double total{ 0.0 };
+	stream.throttle(0ms)
+		.distinctUntilChanged(0.1)
+		.buffer(4)
+		.subscribe([&total](const std::vector<double>& batch) { for (double d : batch) { total += d; } });
+
+	for (int i = 0; i < 16; i++) {
+		stream.onNext(i);
+	}
+	size_t count = allocationsIn([&]() {
+		for (int i = 16; i < 1000; i++) {
+			stream.onNext(i);
+		}
+	});
+	ASSERT_EQ(count, 0) << "Once running, the operators don't allocate.\n";
+	ASSERT_GT(total, 0.0);
+}
\ No newline at end of file
@@ -16,6 +16,10 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "../CppSimConnect/reactive/MessageObserver.h"
 #include "../CppSimConnect/reactive/MessageResult.h"
 #include "../CppSimConnect/reactive/StreamResult.h"
@@ -74,7 +78,7 @@ public:
 	TestError& operator=(TestError&&) = default;
 	TestError& operator=(const TestError&) = default;
 
-	virtual const char* what() const override { return _msg.c_str(); }
+	virtual const char* what() const noexcept override { return _msg.c_str(); }
 };
 
 TEST(TestMessageResult, testOnError) {
@@ -101,3 +105,67 @@ TEST(TestMessageResult, testOnError) {
 	//const char* errMesg = messageObserver.error<TestError>().what();
 	ASSERT_EQ(error, std::string("HELP!")) << "The error should be \"HELP!\".\n";
 }
+
+// Callbacks added while another thread completes the result must each run exactly once, whichever comes first.
+TEST(TestMessageResult, testSubscribeWhileCompleting) {
+	constexpr unsigned rounds{ 1000 };
+	constexpr unsigned subscribers{ 4 };
+
+	unsigned lost{ 0 };
+	for (unsigned round = 0; round < rounds; round++) {
+		MessageResult<int> result;
+		std::atomic<unsigned> ready{ 0 };
+		std::atomic<unsigned> completions{ 0 };
+		{
+			std::vector<std::jthread> threads;
+			for (unsigned i = 0; i < subscribers; i++) {
+				threads.emplace_back([&result, &ready, &completions]() {
+					ready++;
+					while (ready <= subscribers) { std::this_thread::yield(); }
+					result.withOnComplete([&completions]() { completions++; });
+				});
+			}
+			threads.emplace_back([&result, &ready, round]() {
+				while (ready < subscribers) { std::this_thread::yield(); }
+				ready++;
+				result.onNext(static_cast<int>(round));
+			});
+		}
+		if (completions != subscribers) {
+			lost++;
+		}
+	}
+	ASSERT_EQ(lost, 0) << "No completion callback is lost or called twice.\n";
+}
+
+TEST(TestMessageResult, testSubscribeWhileFailing) {
+	constexpr unsigned rounds{ 1000 };
+	constexpr unsigned subscribers{ 4 };
+
+	unsigned lostErrors{ 0 }, lostCompletions{ 0 };
+	for (unsigned round = 0; round < rounds; round++) {
+		MessageResult<int> result;
+		std::atomic<unsigned> ready{ 0 };
+		std::atomic<unsigned> errors{ 0 }, completions{ 0 };
+		{
+			std::vector<std::jthread> threads;
+			for (unsigned i = 0; i < subscribers; i++) {
+				threads.emplace_back([&result, &ready, &errors, &completions]() {
+					ready++;
+					while (ready <= subscribers) { std::this_thread::yield(); }
+					result.withOnError([&errors](std::exception_ptr err) { if (err != nullptr) { errors++; } })
+						.withOnComplete([&completions]() { completions++; });
+				});
+			}
+			threads.emplace_back([&result, &ready]() {
+				while (ready < subscribers) { std::this_thread::yield(); }
+				ready++;
+				result.onError(std::make_exception_ptr(TestError("Failed")));
+			});
+		}
+		lostErrors += (errors != subscribers) ? 1 : 0;
+		lostCompletions += (completions != subscribers) ? 1 : 0;
+	}
+	ASSERT_EQ(lostErrors, 0) << "Every error handler sees the error exactly once.\n";
+	ASSERT_EQ(lostCompletions, 0);
+}
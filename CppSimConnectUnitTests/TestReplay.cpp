@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "../CppSimConnect/sim/FakeSimulator.h"
+#include "../CppSimConnect/sim/MessageRecorder.h"
+#include "../CppSimConnect/sim/ReplayBackend.h"
+
+#include "WaitFor.h"
+
+
+using namespace std::chrono_literals;
+
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::MessageRecorder;
+using CppSimConnect::ReplayBackend;
+using CppSimConnect::SimConnect;
+
+
+static std::filesystem::path tempFile(const std::string& name) {
+	return std::filesystem::temp_directory_path() / name;
+}
+
+// An OPEN message, then frame events 20ms apart.
+static std::filesystem::path recordFrames(const std::string& name, int frames) {
+	auto path = tempFile(name);
+	MessageRecorder recorder(path);
+
+	SIMCONNECT_RECV_OPEN open{};
+	open.dwSize = sizeof(open);
+	open.dwID = SIMCONNECT_RECV_ID_OPEN;
+	std::strcpy(open.szApplicationName, "Recorded Sim");
+	recorder.record(&open, open.dwSize);
+
+	SIMCONNECT_RECV frame{ sizeof(SIMCONNECT_RECV), FakeSimulator::protocolVersion, SIMCONNECT_RECV_ID_EVENT_FRAME };
+	for (int i = 0; i < frames; i++) {
+		std::this_thread::sleep_for(20ms);
+		recorder.record(&frame, frame.dwSize);
+	}
+	return path;
+}
+
+TEST(TestReplay, testRecordConnection) {
+	auto path = tempFile("TestReplay.testRecordConnection.rec");
+	auto fake = std::make_shared<FakeSimulator>("Fake Sim");
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+
+	auto& sim = SimConnect::Builder()
+		.withName("TestReplay.testRecordConnection")
+		.withBackend(fake)
+		.withMessageRecording(path)
+		.withoutSystemStateCache()
+		.withAutoConnect()
+		.startRunning()
+		.build();
+	ASSERT_TRUE(waitFor([&sim]() { return sim.connected(); }));
+	ASSERT_EQ(sim.currentAircraftAirFile(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	sim.stop();
+	// The reply is written out after its handler returns, so it may still be on its way to the file.
+	constexpr auto recordedSize{ MessageRecorder::headerSize
+		+ MessageRecorder::entryHeaderSize + MessageRecorder::paddedSize(sizeof(SIMCONNECT_RECV_OPEN))
+		+ MessageRecorder::entryHeaderSize + MessageRecorder::paddedSize(sizeof(SIMCONNECT_RECV_SYSTEM_STATE)) };
+	ASSERT_TRUE(waitFor([&path]() { return std::filesystem::file_size(path) >= recordedSize; }));
+
+	ReplayBackend replay(path, ReplayBackend::asFastAsPossible);
+	ASSERT_EQ(replay.open("Replay"), S_OK);
+
+	SIMCONNECT_RECV* msg;
+	DWORD len;
+	ASSERT_EQ(replay.getNextDispatch(&msg, &len), S_OK);
+	ASSERT_EQ(msg->dwID, SIMCONNECT_RECV_ID_OPEN);
+	ASSERT_EQ(len, sizeof(SIMCONNECT_RECV_OPEN));
+	ASSERT_EQ(replay.getNextDispatch(&msg, &len), S_OK);
+	ASSERT_EQ(msg->dwID, SIMCONNECT_RECV_ID_SYSTEM_STATE);
+	ASSERT_STREQ(static_cast<SIMCONNECT_RECV_SYSTEM_STATE*>(msg)->szString, "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	ASSERT_NE(replay.getNextDispatch(&msg, &len), S_OK);
+	ASSERT_TRUE(replay.finished());
+	ASSERT_EQ(replay.messagesReplayed(), 2);
+}
+
+TEST(TestReplay, testReplayThroughDispatcher) {
+	auto path = recordFrames("TestReplay.testReplayThroughDispatcher.rec", 5);
+
+	auto replay = std::make_shared<ReplayBackend>(path, ReplayBackend::asFastAsPossible);
+	std::string appName;
+	auto& sim = SimConnect::Builder()
+		.withName("TestReplay.testReplayThroughDispatcher")
+		.withBackend(replay)
+		.withoutSystemStateCache()
+		.startStopped()
+		.build();
+	sim.onOpen([&appName](auto const& appInfo) { appName = appInfo.appName; });
+	ASSERT_TRUE(sim.connect());
+	sim.start();
+
+	ASSERT_TRUE(waitFor([&sim]() { return sim.messageStats().received[SIMCONNECT_RECV_ID_EVENT_FRAME] == 5; }));
+	ASSERT_EQ(appName, "Recorded Sim");
+	ASSERT_TRUE(replay->finished());
+
+	sim.stop();
+}
+
+TEST(TestReplay, testSpeed) {
+	auto path = recordFrames("TestReplay.testSpeed.rec", 5);		// 100ms of frames
+
+	for (double speed : { ReplayBackend::recordedSpeed, 10.0 }) {
+		ReplayBackend replay(path, speed);
+		ASSERT_EQ(replay.open("Replay"), S_OK);
+
+		const auto start{ std::chrono::steady_clock::now() };
+		SIMCONNECT_RECV* msg;
+		DWORD len;
+		while (!replay.finished()) {
+			replay.waitForDispatch(1000ms);
+			while (SUCCEEDED(replay.getNextDispatch(&msg, &len))) {}
+		}
+		const auto elapsed{ std::chrono::steady_clock::now() - start };
+		if (speed == ReplayBackend::recordedSpeed) {
+			ASSERT_GE(elapsed, 100ms) << "At the recorded speed, the frames take as long as they did.\n";
+		}
+		else {
+			ASSERT_LT(elapsed, 100ms) << "Ten times faster.\n";
+		}
+		ASSERT_EQ(replay.messagesReplayed(), 6);
+	}
+}
+
+TEST(TestReplay, testSizeBeyondEntry) {
+	auto path = tempFile("TestReplay.testSizeBeyondEntry.rec");
+	{
+		MessageRecorder recorder(path);
+		SIMCONNECT_RECV frame{ sizeof(SIMCONNECT_RECV), FakeSimulator::protocolVersion, SIMCONNECT_RECV_ID_EVENT_FRAME };
+		recorder.record(&frame, frame.dwSize);
+
+		SIMCONNECT_RECV_SIMOBJECT_DATA data{};
+		data.dwSize = sizeof(data) + 64;		// More than the entry holds
+		data.dwID = SIMCONNECT_RECV_ID_SIMOBJECT_DATA;
+		recorder.record(&data, sizeof(data));
+		recorder.record(&frame, frame.dwSize);
+	}
+
+	ReplayBackend replay(path, ReplayBackend::asFastAsPossible);
+	ASSERT_EQ(replay.open("Replay"), S_OK);
+	SIMCONNECT_RECV* msg;
+	DWORD len;
+	ASSERT_TRUE(SUCCEEDED(replay.getNextDispatch(&msg, &len)));
+	ASSERT_EQ(msg->dwID, SIMCONNECT_RECV_ID_EVENT_FRAME);
+	ASSERT_FALSE(SUCCEEDED(replay.getNextDispatch(&msg, &len))) << "A message larger than its entry is not replayed.\n";
+	ASSERT_TRUE(replay.finished()) << "The replay stops at the damaged entry.\n";
+	ASSERT_EQ(replay.messagesReplayed(), 1);
+}
+
+TEST(TestReplay, testNotARecording) {
+	auto path = tempFile("TestReplay.testNotARecording.rec");
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out << "This is not a recording";
+	}
+	ASSERT_THROW(ReplayBackend replay(path), std::runtime_error);
+	ASSERT_THROW(ReplayBackend missing(tempFile("TestReplay.doesNotExist.rec")), std::runtime_error);
+}
\ No newline at end of file
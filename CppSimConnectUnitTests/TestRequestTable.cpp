@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/sim/RequestTable.h"
+
+
+using CppSimConnect::RequestTable;
+
+TEST(TestRequestTable, testAddFind) {
+	RequestTable<std::string> table;
+
+	auto first = table.add("first");
+	auto second = table.add("second");
+
+	ASSERT_NE(first, second);
+	ASSERT_EQ(table.size(), 2);
+	ASSERT_NE(table.find(first), nullptr);
+	ASSERT_EQ(*table.find(first), "first");
+	ASSERT_EQ(*table.find(second), "second");
+	ASSERT_EQ(table.find(second + 1), nullptr) << "Unused slots are not found.\n";
+	ASSERT_EQ(table.find(RequestTable<std::string>::invalidId), nullptr);
+}
+
+TEST(TestRequestTable, testRetire) {
+	RequestTable<std::string> table;
+
+	auto id = table.add("value");
+	ASSERT_TRUE(table.retire(id));
+	ASSERT_FALSE(table.retire(id)) << "Retiring twice is harmless.\n";
+	ASSERT_EQ(table.find(id), nullptr) << "Retired requests are not found.\n";
+	ASSERT_EQ(table.size(), 0);
+}
+
+TEST(TestRequestTable, testReuse) {
+	RequestTable<std::string> table;
+
+	auto oldId = table.add("old");
+	table.retire(oldId);
+	auto pendingId = table.add("pending");
+	ASSERT_NE(pendingId & RequestTable<std::string>::indexMask, oldId & RequestTable<std::string>::indexMask) << "Slots are not reused before reclaim().\n";
+
+	table.reclaim();
+	auto newId = table.add("new");
+	ASSERT_EQ(newId & RequestTable<std::string>::indexMask, oldId & RequestTable<std::string>::indexMask) << "Reclaimed slots are reused.\n";
+	ASSERT_NE(newId, oldId) << "A reused slot gets a new generation.\n";
+	ASSERT_EQ(table.find(oldId), nullptr) << "Stale RequestIDs are not found.\n";
+	ASSERT_EQ(*table.find(newId), "new");
+}
+
+TEST(TestRequestTable, testConcurrentAdd) {
+	constexpr unsigned threads{ 8 };
+	constexpr unsigned perThread{ 10'000 };
+
+	RequestTable<unsigned> table;
+	std::vector<std::vector<std::uint32_t>> ids(threads);
+	{
+		std::vector<std::jthread> workers;
+		for (unsigned t = 0; t < threads; t++) {
+			workers.emplace_back([&table, &ids, t]() {
+				for (unsigned i = 0; i < perThread; i++) {
+					auto id = table.add(t * perThread + i);
+					if ((i % 2) == 0) {
+						table.retire(id);
+					}
+					else {
+						ids[t].push_back(id);
+					}
+				}
+			});
+		}
+	}
+	table.reclaim();
+
+	std::set<std::uint32_t> unique;
+	for (unsigned t = 0; t < threads; t++) {
+		for (unsigned i = 0; i < ids[t].size(); i++) {
+			unique.insert(ids[t][i]);
+			ASSERT_NE(table.find(ids[t][i]), nullptr);
+			ASSERT_EQ(*table.find(ids[t][i]), t * perThread + 2 * i + 1);
+		}
+	}
+	ASSERT_EQ(unique.size(), threads * perThread / 2);
+	ASSERT_EQ(table.size(), threads * perThread / 2);
+}
\ No newline at end of file
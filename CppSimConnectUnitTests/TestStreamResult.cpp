@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/reactive/BoundedQueue.h"
+#include "../CppSimConnect/reactive/StreamResult.h"
+
+
+using CppSimConnect::Reactive::BoundedQueue;
+using CppSimConnect::Reactive::BufferPolicy;
+using CppSimConnect::Reactive::OverflowPolicy;
+using CppSimConnect::Reactive::StreamResult;
+
+TEST(TestStreamResult, testBoundedQueue) {
+	BoundedQueue<int> queue(3);
+	ASSERT_EQ(queue.capacity(), 4) << "The capacity is rounded up to a power of two.\n";
+
+	for (int i = 0; i < 4; i++) {
+		ASSERT_TRUE(queue.tryPush(i));
+	}
+	ASSERT_FALSE(queue.tryPush(4)) << "A full queue refuses values.\n";
+	ASSERT_EQ(queue.size(), 4);
+
+	int value{ -1 };
+	for (int i = 0; i < 4; i++) {
+		ASSERT_TRUE(queue.tryPop(value));
+		ASSERT_EQ(value, i) << "Values come out in order.\n";
+	}
+	ASSERT_FALSE(queue.tryPop(value));
+	ASSERT_TRUE(queue.empty());
+}
+
+TEST(TestStreamResult, testStreamDoesNotComplete) {
+	StreamResult<int> stream;
+	std::vector<int> received;
+	stream.withOnNext([&received](int i) { received.push_back(i); });
+
+	stream.onNext(1);
+	stream.onNext(2);
+	ASSERT_FALSE(stream.completed()) << "Values do not complete a stream.\n";
+	ASSERT_EQ(received, (std::vector<int>{ 1, 2 }));
+
+	stream.onCompleted();
+	stream.onNext(3);
+	ASSERT_EQ(received.size(), 2) << "Nothing arrives after completion.\n";
+}
+
+static std::vector<int> publishAndDrain(OverflowPolicy overflow, StreamResult<int>& stream) {
+	std::vector<int> received;
+	auto subscription = stream.subscribeBuffered([&received](int i) { received.push_back(i); }, BufferPolicy{ overflow, 4 });
+	for (int i = 0; i < 10; i++) {
+		stream.onNext(i);
+	}
+	EXPECT_EQ(received.size(), 0) << "Nothing is delivered until the subscriber drains.\n";
+	subscription->drain();
+	return received;
+}
+
+TEST(TestStreamResult, testDropOldest) {
+	StreamResult<int> stream;
+	ASSERT_EQ(publishAndDrain(OverflowPolicy::DropOldest, stream), (std::vector<int>{ 6, 7, 8, 9 }));
+
+	auto stats = stream.stats();
+	ASSERT_EQ(stats.published, 10);
+	ASSERT_EQ(stats.delivered, 4);
+	ASSERT_EQ(stats.dropped, 6);
+	ASSERT_EQ(stats.depth, 0);
+	ASSERT_EQ(stats.maxDepth, 4);
+}
+
+TEST(TestStreamResult, testDropNewest) {
+	StreamResult<int> stream;
+	ASSERT_EQ(publishAndDrain(OverflowPolicy::DropNewest, stream), (std::vector<int>{ 0, 1, 2, 3 }));
+	ASSERT_EQ(stream.stats().dropped, 6);
+}
+
+TEST(TestStreamResult, testLatestOnly) {
+	StreamResult<int> stream;
+	ASSERT_EQ(publishAndDrain(OverflowPolicy::LatestOnly, stream), (std::vector<int>{ 9 }));
+	ASSERT_EQ(stream.stats().dropped, 9);
+	ASSERT_EQ(stream.stats().maxDepth, 1);
+}
+
+TEST(TestStreamResult, testBlock) {
+	constexpr int count{ 1000 };
+	StreamResult<int> stream;
+	std::vector<int> received;
+	bool completed{ false };
+	auto subscription = stream.subscribeBuffered([&received](int i) { received.push_back(i); }, BufferPolicy{ OverflowPolicy::Block, 8 });
+	subscription->withOnComplete([&completed]() { completed = true; });
+
+	std::atomic_bool producing{ true };
+	std::jthread producer([&stream, &producing]() {
+		for (int i = 0; i < count; i++) {
+			stream.onNext(i);
+		}
+		stream.onCompleted();
+		producing = false;
+	});
+	while (producing || (subscription->depth() > 0) || !completed) {
+		if (subscription->drain() == 0) {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	ASSERT_EQ(received.size(), count) << "A blocking subscriber loses nothing.\n";
+	for (int i = 0; i < count; i++) {
+		ASSERT_EQ(received[i], i);
+	}
+	ASSERT_EQ(stream.stats().dropped, 0);
+	ASSERT_LE(stream.stats().maxDepth, 8);
+}
+
+TEST(TestStreamResult, testReadyAndCompletion) {
+	StreamResult<int> stream;
+	int ready{ 0 };
+	std::vector<int> received;
+	bool completed{ false };
+	auto subscription = stream.subscribeBuffered([&received](int i) { received.push_back(i); }, BufferPolicy{}, [&ready]() { ready++; });
+	subscription->withOnComplete([&completed]() { completed = true; });
+
+	stream.onNext(1);
+	stream.onNext(2);
+	ASSERT_EQ(ready, 1) << "Ready is signalled once until the subscriber drains.\n";
+
+	stream.onCompleted();
+	ASSERT_FALSE(completed) << "Completion waits for the buffered values.\n";
+	ASSERT_EQ(subscription->drain(1), 1);
+	ASSERT_FALSE(completed);
+	ASSERT_EQ(ready, 2) << "A partial drain signals ready again.\n";
+	ASSERT_EQ(subscription->drain(), 1);
+	ASSERT_TRUE(completed);
+	ASSERT_EQ(received, (std::vector<int>{ 1, 2 }));
+}
+
+TEST(TestStreamResult, testUnsubscribe) {
+	StreamResult<int> stream;
+	std::vector<int> received;
+	auto subscription = stream.subscribeBuffered([&received](int i) { received.push_back(i); });
+
+	stream.onNext(1);
+	stream.unsubscribe(subscription);
+	stream.onNext(2);
+	subscription->drain();
+
+	ASSERT_TRUE(received.empty()) << "A cancelled subscription delivers nothing.\n";
+	auto stats = stream.stats();
+	ASSERT_EQ(stats.published, 1);
+	ASSERT_EQ(stats.dropped, 1) << "Undelivered values of a removed subscription count as dropped.\n";
+}
+TEST(TestStreamResult, testSubscribeWhileDelivering) {
+	constexpr int subscribers{ 200 };
+	StreamResult<int> stream;
+	std::vector<std::atomic_int> received(subscribers);
+
+	std::atomic_bool producing{ true };
+	std::jthread producer([&stream, &producing]() {
+		for (int i = 0; producing; i++) {
+			stream.onNext(i);
+		}
+	});
+	for (int i = 0; i < subscribers; i++) {
+		stream.subscribe([&counter = received[i]](int) { counter++; });
+		while (received[i] == 0) {
+			std::this_thread::yield();
+		}
+	}
+	producing = false;
+	producer.join();
+
+	ASSERT_EQ(stream.subscribers(), subscribers) << "Subscribers added to a live stream are all kept.\n";
+	ASSERT_GT(received[subscribers - 1], 0) << "A subscriber added to a live stream receives the values that follow.\n";
+}
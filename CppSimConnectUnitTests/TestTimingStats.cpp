@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CppSimConnect/sim/DispatchTiming.h"
+#include "../CppSimConnect/sim/FakeSimulator.h"
+
+#include "FakeConnection.h"
+
+
+using CppSimConnect::AtomicHistogram;
+using CppSimConnect::FakeSimulator;
+using CppSimConnect::HistogramSnapshot;
+using CppSimConnect::RequestKind;
+using CppSimConnect::SimConnect;
+
+TEST(TestTimingStats, testBuckets) {
+	for (std::uint64_t value = 0; value < HistogramSnapshot::subBuckets; value++) {
+		ASSERT_EQ(HistogramSnapshot::lowestValueOf(HistogramSnapshot::bucketOf(value)), value) << "Small values are counted exactly.\n";
+	}
+	for (std::uint64_t value = HistogramSnapshot::subBuckets; value < (1ull << 40); value = value * 3 / 2 + 1) {
+		const size_t bucket{ HistogramSnapshot::bucketOf(value) };
+		ASSERT_LT(bucket, HistogramSnapshot::bucketCount);
+		ASSERT_LE(HistogramSnapshot::lowestValueOf(bucket), value);
+		ASSERT_GT(HistogramSnapshot::lowestValueOf(bucket + 1), value);
+		ASSERT_LE(HistogramSnapshot::lowestValueOf(bucket + 1) - HistogramSnapshot::lowestValueOf(bucket), value / 8 + 1) << "Buckets are at most 1/8th of their values wide.\n";
+	}
+	ASSERT_EQ(HistogramSnapshot::bucketOf(~0ull), HistogramSnapshot::bucketCount - 1) << "Values beyond the range go in the last bucket.\n";
+}
+
+TEST(TestTimingStats, testPercentiles) {
+	AtomicHistogram histogram;
+	ASSERT_EQ(histogram.snapshot().count, 0);
+	ASSERT_EQ(histogram.snapshot().percentile(50.0), 0);
+
+	for (std::uint64_t value = 1; value <= 1000; value++) {
+		histogram.record(value);
+	}
+	auto snapshot{ histogram.snapshot() };
+	ASSERT_EQ(snapshot.count, 1000);
+	ASSERT_EQ(snapshot.sum, 500500);
+	ASSERT_EQ(snapshot.min, 1);
+	ASSERT_EQ(snapshot.max, 1000);
+	ASSERT_DOUBLE_EQ(snapshot.mean(), 500.5);
+	ASSERT_EQ(snapshot.percentile(0.0), 1);
+	ASSERT_EQ(snapshot.percentile(100.0), 1000);
+	ASSERT_NEAR(static_cast<double>(snapshot.percentile(50.0)), 500.0, 500.0 / 8);
+	ASSERT_NEAR(static_cast<double>(snapshot.percentile(99.0)), 990.0, 990.0 / 8);
+}
+
+TEST(TestTimingStats, testRoundTrips) {
+	constexpr unsigned requests{ 10 };
+
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	auto& sim = connectTo("TestTimingStats.testRoundTrips", fake, [](SimConnect::Builder& builder) { builder.withoutSystemStateCache().withTimingStats(); });
+	ASSERT_TRUE(sim.connected());
+
+	for (unsigned i = 0; i < requests; i++) {
+		ASSERT_EQ(sim.requestAircraftLoaded().get(), "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	}
+	// get() returns from inside the handler, so the last reply's handling and drain are timed a little later.
+	auto stats{ sim.timingStats() };
+	waitFor([&sim, &stats]() {
+		stats = sim.timingStats();
+		return (stats.handling[SIMCONNECT_RECV_ID_SYSTEM_STATE].count >= requests) && (stats.drainBatch.sum >= requests);
+	});
+	ASSERT_EQ(stats.roundTrip[static_cast<size_t>(RequestKind::SystemState)].count, requests);
+	ASSERT_EQ(stats.roundTrip[static_cast<size_t>(RequestKind::Data)].count, 0);
+	ASSERT_GT(stats.roundTrip[static_cast<size_t>(RequestKind::SystemState)].max, 0);
+
+	ASSERT_TRUE(stats.handling.contains(SIMCONNECT_RECV_ID_SYSTEM_STATE));
+	ASSERT_EQ(stats.handling[SIMCONNECT_RECV_ID_SYSTEM_STATE].count, requests);
+	ASSERT_FALSE(stats.handling.contains(SIMCONNECT_RECV_ID_EVENT_FRAME)) << "Only types that were seen are reported.\n";
+
+	ASSERT_GE(stats.drainBatch.sum, requests) << "Every reply was handled by a drain of the queue.\n";
+	ASSERT_EQ(stats.subscriberCallback.count, requests);
+
+	sim.stop();
+}
+
+TEST(TestTimingStats, testOffByDefault) {
+	auto fake = std::make_shared<FakeSimulator>();
+	fake->withStringState("AircraftLoaded", "SimObjects\\Airplanes\\Test\\aircraft.cfg");
+	auto& sim = connectTo("TestTimingStats.testOffByDefault", fake, [](SimConnect::Builder& builder) { builder.withoutSystemStateCache(); });
+	ASSERT_TRUE(sim.connected());
+
+	sim.requestAircraftLoaded().get();
+	auto stats{ sim.timingStats() };
+	ASSERT_EQ(stats.roundTrip[static_cast<size_t>(RequestKind::SystemState)].count, 0);
+	ASSERT_TRUE(stats.handling.empty());
+	ASSERT_EQ(stats.drainBatch.count, 0);
+
+	sim.stop();
+}
\ No newline at end of file
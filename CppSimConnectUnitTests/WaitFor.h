@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2023. Bert Laverman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+// Wait for something another thread does, polling until the predicate holds or the timeout passes.
+// Returns the predicate's last value, so a test can assert on it.
+template <typename P>
+static bool waitFor(P predicate, std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (!predicate() && (std::chrono::steady_clock::now() < deadline)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return predicate();
+}